@@ -0,0 +1,100 @@
+#include "DeferredReclaimer.h"
+
+DeferredReclaimer::DeferredReclaimer()
+{
+    for (auto& epoch : readerEpochs)
+        epoch.store(0, std::memory_order_relaxed);
+}
+
+DeferredReclaimer::~DeferredReclaimer()
+{
+    // Owners stop all readers before destroying us, so everything can go now
+    std::lock_guard<std::mutex> lock(retiredMutex);
+    retiredObjects.clear();
+}
+
+void DeferredReclaimer::retireErased(std::shared_ptr<void> object, std::function<bool()> inUse)
+{
+    RetiredObject retired;
+    retired.object = std::move(object);
+    retired.inUse = std::move(inUse);
+    recordEpochs(retired);
+
+    std::lock_guard<std::mutex> lock(retiredMutex);
+    retiredObjects.push_back(std::move(retired));
+}
+
+void DeferredReclaimer::recordEpochs(RetiredObject& retired) const
+{
+    // seq_cst pairs with the reader's increment: if we see an even (idle) epoch here,
+    // the reader's next pass starts after our pointer swap (or after the last user let
+    // go) and cannot see the old object
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (size_t i = 0; i < retired.epochsAtRetire.size(); ++i)
+        retired.epochsAtRetire[i] = readerEpochs[i].load(std::memory_order_seq_cst);
+}
+
+bool DeferredReclaimer::readersHavePassed(const RetiredObject& retired) const
+{
+    for (size_t i = 0; i < retired.epochsAtRetire.size(); ++i)
+    {
+        const uint64_t atRetire = retired.epochsAtRetire[i];
+        const bool wasInsidePass = (atRetire & 1) != 0;
+        if (wasInsidePass && readerEpochs[i].load(std::memory_order_seq_cst) == atRetire)
+            return false;
+    }
+    return true;
+}
+
+bool DeferredReclaimer::isReachable(RetiredObject& retired) const
+{
+    if (!readersHavePassed(retired))
+        return true;
+
+    if (retired.inUse && retired.inUse())
+    {
+        retired.wasInUse = true;
+        return true;
+    }
+
+    // Its last user just let go, but a reader may have reached it through that user in the
+    // pass it is in now: wait for the readers once more
+    if (retired.wasInUse)
+    {
+        retired.wasInUse = false;
+        recordEpochs(retired);
+        return !readersHavePassed(retired);
+    }
+    return false;
+}
+
+int DeferredReclaimer::collect()
+{
+    // Destroy outside the lock; freeing large preloads can take a while
+    std::vector<RetiredObject> reclaimable;
+    int pending = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+
+        std::vector<RetiredObject> stillReachable;
+        for (auto& retired : retiredObjects)
+        {
+            if (isReachable(retired))
+                stillReachable.push_back(std::move(retired));
+            else
+                reclaimable.push_back(std::move(retired));
+        }
+        retiredObjects = std::move(stillReachable);
+        pending = static_cast<int>(retiredObjects.size());
+    }
+
+    reclaimable.clear();
+    return pending;
+}
+
+int DeferredReclaimer::getNumPending() const
+{
+    std::lock_guard<std::mutex> lock(retiredMutex);
+    return static_cast<int>(retiredObjects.size());
+}
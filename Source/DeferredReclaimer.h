@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * DeferredReclaimer frees objects that real-time readers may still be using.
+ *
+ * Readers (the audio thread, the disk thread) bracket each pass over shared data
+ * with a ReadScope, which bumps their epoch counter on entry and exit (odd = inside).
+ * Writers publish a replacement with an atomic pointer swap, then retire() the old
+ * object. It is destroyed by collect() once every reader that was inside a pass at
+ * retire time has left it, and the optional inUse predicate (e.g. "a voice still
+ * plays this sample") returns false.
+ *
+ * A reader can still hold an object it reached through a user the predicate checks:
+ * the disk thread reads a voice's sample, and the voice stops mid-pass. So once the
+ * predicate turns false after having been true, the grace period starts over, and the
+ * object waits for the readers that are inside a pass at that moment as well.
+ *
+ * Readers never block or allocate; retire() and collect() run on non-realtime threads.
+ */
+class DeferredReclaimer
+{
+public:
+    enum Reader { audioThreadReader = 0, diskThreadReader, numReaders };
+
+    DeferredReclaimer();
+    ~DeferredReclaimer();
+
+    /** RAII bracket for one reader pass (audio block, disk poll) */
+    class ReadScope
+    {
+    public:
+        ReadScope(DeferredReclaimer& r, Reader reader) : epoch(r.readerEpochs[static_cast<size_t>(reader)])
+        {
+            epoch.fetch_add(1, std::memory_order_seq_cst);
+        }
+
+        ~ReadScope() { epoch.fetch_add(1, std::memory_order_seq_cst); }
+
+        ReadScope(const ReadScope&) = delete;
+        ReadScope& operator=(const ReadScope&) = delete;
+
+    private:
+        std::atomic<uint64_t>& epoch;
+    };
+
+    /** Queue an object for destruction once no reader can reach it */
+    template <typename T>
+    void retire(std::unique_ptr<T> object, std::function<bool()> inUse = nullptr)
+    {
+        if (object != nullptr)
+            retireErased(std::shared_ptr<void>(std::move(object)), std::move(inUse));
+    }
+
+    /** Destroy every retired object that is no longer reachable. Returns how many are still pending. */
+    int collect();
+
+    int getNumPending() const;
+
+private:
+    struct RetiredObject
+    {
+        std::shared_ptr<void> object;
+        std::array<uint64_t, numReaders> epochsAtRetire{};  // Or when its last user let go
+        std::function<bool()> inUse;
+        bool wasInUse = false;  // inUse was true at the last collect()
+    };
+
+    void retireErased(std::shared_ptr<void> object, std::function<bool()> inUse);
+    void recordEpochs(RetiredObject& retired) const;
+    bool readersHavePassed(const RetiredObject& retired) const;
+    bool isReachable(RetiredObject& retired) const;  // Restarts the grace period when its last user lets go
+
+    std::array<std::atomic<uint64_t>, numReaders> readerEpochs;
+
+    mutable std::mutex retiredMutex;
+    std::vector<RetiredObject> retiredObjects;
+};
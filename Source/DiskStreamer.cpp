@@ -1,4 +1,5 @@
 #include "DiskStreamer.h"
+#include <optional>
 
 // Debug logging to file (same as PluginProcessor)
 static void streamDebugLog(const juce::String& msg)
@@ -70,19 +71,26 @@ void DiskStreamer::run()
         loopCount++;
         int activeVoices = 0;
 
-        // Poll all registered voices
-        for (int i = 0; i < StreamingConstants::maxStreamingVoices; ++i)
         {
-            if (threadShouldExit())
-                break;
+            // Samples the voices point at can't be freed until this pass is over
+            std::optional<DeferredReclaimer::ReadScope> readScope;
+            if (reclaimer != nullptr)
+                readScope.emplace(*reclaimer, DeferredReclaimer::diskThreadReader);
 
-            StreamingVoice* voice = voices[static_cast<size_t>(i)].load(std::memory_order_acquire);
-            if (voice != nullptr && voice->isActive())
+            // Poll all registered voices
+            for (int i = 0; i < StreamingConstants::maxStreamingVoices; ++i)
             {
-                activeVoices++;
-                if (voice->needsMoreData())
+                if (threadShouldExit())
+                    break;
+
+                StreamingVoice* voice = voices[static_cast<size_t>(i)].load(std::memory_order_acquire);
+                if (voice != nullptr && voice->isActive())
                 {
-                    fillVoiceBuffer(i);
+                    activeVoices++;
+                    if (voice->needsMoreData())
+                    {
+                        fillVoiceBuffer(i);
+                    }
                 }
             }
         }
@@ -130,14 +138,14 @@ void DiskStreamer::fillVoiceBuffer(int voiceIndex)
     if (sample == nullptr || !sample->isValid())
         return;
 
-    streamDebugLog("fillVoiceBuffer[" + juce::String(voiceIndex) + "] ENTER - sample=" + sample->name);
+    streamDebugLog("fillVoiceBuffer[" + juce::String(voiceIndex) + "] ENTER - sample=" + sample->path.getFileName());
 
     // Check if we need to open or reopen the file reader
     auto& reader = readers[static_cast<size_t>(voiceIndex)];
-    if (reader == nullptr || readerFilePaths[static_cast<size_t>(voiceIndex)] != sample->filePath)
+    if (reader == nullptr || readerFilePaths[static_cast<size_t>(voiceIndex)] != sample->path)
     {
-        reader = openReader(sample->filePath);
-        readerFilePaths[static_cast<size_t>(voiceIndex)] = sample->filePath;
+        reader = openReader(sample->path.getFile());
+        readerFilePaths[static_cast<size_t>(voiceIndex)] = sample->path;
 
         if (reader == nullptr)
         {
@@ -147,9 +155,11 @@ void DiskStreamer::fillVoiceBuffer(int voiceIndex)
         }
     }
 
-    // Get current file position and available space
+    // Get current position and available space. Positions count from the sample's start,
+    // which is past any trimmed leading silence; trimmed trailing silence is never read.
     int64_t filePos = voice->getFileReadPosition();
-    int64_t totalFrames = static_cast<int64_t>(reader->lengthInSamples);
+    const int64_t startFrame = sample->fileStartFrame;
+    int64_t totalFrames = std::min(sample->totalSampleFrames, static_cast<int64_t>(reader->lengthInSamples) - startFrame);
 
     // Check for end of file
     if (filePos >= totalFrames)
@@ -184,7 +194,7 @@ void DiskStreamer::fillVoiceBuffer(int voiceIndex)
 
         // Read from disk
         bool success = reader->read(&tempReadBuffer, 0, framesToRead,
-                                    filePos, true, true);
+                                    startFrame + filePos, true, true);
 
         if (!success)
         {
@@ -251,12 +261,11 @@ void DiskStreamer::fillVoiceBuffer(int voiceIndex)
     voice->clearNeedsData();
 }
 
-std::unique_ptr<juce::AudioFormatReader> DiskStreamer::openReader(const juce::String& filePath)
+std::unique_ptr<juce::AudioFormatReader> DiskStreamer::openReader(const juce::File& file)
 {
     if (formatManager == nullptr)
         return nullptr;
 
-    juce::File file(filePath);
     if (!file.existsAsFile())
         return nullptr;
 
@@ -268,6 +277,6 @@ void DiskStreamer::closeReader(int voiceIndex)
     if (voiceIndex >= 0 && voiceIndex < StreamingConstants::maxStreamingVoices)
     {
         readers[static_cast<size_t>(voiceIndex)].reset();
-        readerFilePaths[static_cast<size_t>(voiceIndex)].clear();
+        readerFilePaths[static_cast<size_t>(voiceIndex)] = {};
     }
 }
@@ -7,6 +7,7 @@
 #include <atomic>
 #include "DiskStreaming.h"
 #include "StreamingVoice.h"
+#include "DeferredReclaimer.h"
 
 /**
  * DiskStreamer is a background thread that handles all disk I/O for streaming voices.
@@ -38,6 +39,9 @@ public:
     /** Set the audio format manager for creating file readers */
     void setAudioFormatManager(juce::AudioFormatManager* manager) { formatManager = manager; }
 
+    /** Set the reclaimer that keeps samples alive while a polling pass reads them */
+    void setDeferredReclaimer(DeferredReclaimer* r) { reclaimer = r; }
+
     /** Get current disk throughput in MB/s (averaged over ~1 second) */
     float getThroughputMBps() const { return currentThroughputMBps.load(std::memory_order_relaxed); }
 
@@ -51,7 +55,7 @@ private:
     void fillVoiceBuffer(int voiceIndex);
 
     /** Open a reader for the given sample file path */
-    std::unique_ptr<juce::AudioFormatReader> openReader(const juce::String& filePath);
+    std::unique_ptr<juce::AudioFormatReader> openReader(const juce::File& file);
 
     /** Close reader for a voice */
     void closeReader(int voiceIndex);
@@ -63,7 +67,7 @@ private:
     std::array<std::unique_ptr<juce::AudioFormatReader>, StreamingConstants::maxStreamingVoices> readers;
 
     // Track which sample each reader was opened for
-    std::array<juce::String, StreamingConstants::maxStreamingVoices> readerFilePaths;
+    std::array<SamplePath, StreamingConstants::maxStreamingVoices> readerFilePaths;
 
     // Temporary buffer for disk reads (to batch reads before writing to ring buffer)
     juce::AudioBuffer<float> tempReadBuffer;
@@ -71,6 +75,9 @@ private:
     // Audio format manager (owned by processor, we just hold a pointer)
     juce::AudioFormatManager* formatManager = nullptr;
 
+    // Sample reclaimer (owned by the engine)
+    DeferredReclaimer* reclaimer = nullptr;
+
     // Throughput tracking
     std::atomic<int64_t> bytesReadInWindow{0};      // Bytes read in current measurement window
     std::atomic<int64_t> totalBytesRead{0};         // Total bytes read since start
@@ -2,6 +2,10 @@
 
 #include <juce_audio_formats/juce_audio_formats.h>
 #include <atomic>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include "SamplePath.h"
 
 /**
  * DFD (Direct From Disk) Streaming Core Types
@@ -17,46 +21,91 @@
  */
 struct PreloadedSample
 {
-    juce::AudioBuffer<float> preloadBuffer;  // First 64KB only
-    juce::String filePath;                    // Full path for streaming
-    int64_t totalSampleFrames = 0;            // Total frames in the file
+    juce::AudioBuffer<float> preloadBuffer;  // First 64KB only (empty for compact preloads)
+    std::shared_ptr<const void> dataOwner;    // Keeps preloadBuffer's memory alive when it refers to external data (an arena block or a mapped snapshot)
+    bool mapped = false;                      // preloadBuffer refers into a read-only file mapping
+    SamplePath path;                          // File to stream from (interned)
+    int64_t totalSampleFrames = 0;            // Frames played: the file's, less any trimmed silence
+    int64_t fileStartFrame = 0;               // File frame the sample starts at (after trimmed leading silence)
     double sampleRate = 44100.0;
     int numChannels = 2;
 
-    // Sample zone mapping info
-    int rootNote = 60;
-    int lowNote = 0;
-    int highNote = 127;
-    int lowVelocity = 1;
-    int highVelocity = 127;
-    juce::String name;
+    int rootNote = 60;                        // Note it plays at its own pitch
 
     // Preload configuration
     static constexpr int preloadSizeBytes = 65536;  // 64KB preload
     int preloadSizeFrames = 0;                       // Calculated based on channels/bit depth
 
-    bool isValid() const { return totalSampleFrames > 0 && filePath.isNotEmpty(); }
+    // Compact preloads keep the file's own 16- or 24-bit integers instead of floats, frames
+    // interleaved, and are converted as voices read them
+    int integerBits = 0;         // 16 or 24 if the file is integer PCM of that depth, else 0
+    int compactBits = 0;         // 16 or 24 if the preload is in compactData, 0 if in preloadBuffer
+    char* compactData = nullptr; // numChannels x compactFrames samples, little-endian (owned via dataOwner)
+    int compactFrames = 0;       // Frames compactData has room for
 
-    /** Returns true if this sample is large enough to require streaming */
-    bool needsStreaming() const { return totalSampleFrames > preloadSizeFrames; }
+    /** Frames the preload has room for (preloadSizeFrames of them are read so far) */
+    int getPreloadCapacity() const { return compactBits != 0 ? compactFrames : preloadBuffer.getNumSamples(); }
+
+    /** Bytes the preload's samples take */
+    int64_t getPreloadBytes() const
+    {
+        const int bytesPerSample = compactBits != 0 ? compactBits / 8 : static_cast<int>(sizeof(float));
+        return static_cast<int64_t>(getPreloadCapacity()) * numChannels * bytesPerSample;
+    }
 
-    /** Check if a MIDI note falls within this sample's range */
-    bool containsNote(int midiNote) const
+    /** One preload sample as float */
+    float getPreloadSample(int channel, int frame) const
     {
-        return midiNote >= lowNote && midiNote <= highNote;
+        if (compactBits == 0)
+            return preloadBuffer.getSample(channel, frame);
+
+        const auto* bytes = reinterpret_cast<const uint8_t*>(compactData)
+                          + (static_cast<size_t>(frame) * static_cast<size_t>(numChannels) + static_cast<size_t>(channel)) * static_cast<size_t>(compactBits / 8);
+        if (compactBits == 16)
+            return static_cast<float>(static_cast<int16_t>(bytes[0] | (bytes[1] << 8))) * (1.0f / 32768.0f);
+
+        // Sign-extend from the top byte of an int32
+        const auto value = static_cast<int32_t>((static_cast<uint32_t>(bytes[0]) << 8) | (static_cast<uint32_t>(bytes[1]) << 16)
+                                              | (static_cast<uint32_t>(bytes[2]) << 24)) >> 8;
+        return static_cast<float>(value) * (1.0f / 8388608.0f);
     }
 
-    /** Check if velocity falls within this sample's range */
-    bool containsVelocity(int velocity) const
+    /** numFrames of a channel from startFrame, as float */
+    void readPreload(int channel, int startFrame, float* dest, int numFrames) const
     {
-        return velocity >= lowVelocity && velocity <= highVelocity;
+        if (compactBits == 0)
+        {
+            std::memcpy(dest, preloadBuffer.getReadPointer(channel, startFrame), static_cast<size_t>(numFrames) * sizeof(float));
+            return;
+        }
+
+        for (int i = 0; i < numFrames; ++i)
+            dest[i] = getPreloadSample(channel, startFrame + i);
     }
 
-    /** Check if both note and velocity match this sample */
-    bool matches(int midiNote, int velocity) const
+    /** Store float samples into a compact preload from startFrame. Exact for samples that came
+        from a file of compactBits depth, which is all a compact preload ever holds. */
+    void writeCompact(int channel, int startFrame, const float* source, int numFrames)
     {
-        return containsNote(midiNote) && containsVelocity(velocity);
+        const size_t bytesPerSample = static_cast<size_t>(compactBits / 8);
+        auto* bytes = reinterpret_cast<uint8_t*>(compactData)
+                    + (static_cast<size_t>(startFrame) * static_cast<size_t>(numChannels) + static_cast<size_t>(channel)) * bytesPerSample;
+        const float scale = compactBits == 16 ? 32768.0f : 8388608.0f;
+
+        for (int i = 0; i < numFrames; ++i, bytes += bytesPerSample * static_cast<size_t>(numChannels))
+        {
+            const auto value = static_cast<int32_t>(juce::jlimit(-scale, scale - 1.0f, std::round(source[i] * scale)));
+            bytes[0] = static_cast<uint8_t>(value);
+            bytes[1] = static_cast<uint8_t>(value >> 8);
+            if (compactBits == 24)
+                bytes[2] = static_cast<uint8_t>(value >> 16);
+        }
     }
+
+    bool isValid() const { return totalSampleFrames > 0 && !path.isEmpty(); }
+
+    /** Returns true if this sample is large enough to require streaming */
+    bool needsStreaming() const { return totalSampleFrames > preloadSizeFrames; }
 };
 
 /**
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <mutex>
+
+/** A parameter change for the audio thread */
+struct EngineCommand
+{
+    enum class Type
+    {
+        setADSR,                 // floatValues = attack, decay, sustain, release
+        setSameNoteReleaseTime,  // floatValues[0] = seconds
+        setRoundRobinLimit,      // intValue = limit
+        numTypes
+    };
+
+    Type type = Type::setADSR;
+    std::array<float, 4> floatValues{};
+    int intValue = 0;
+};
+
+/**
+ * EngineCommandQueue carries parameter changes to the audio thread, which drains
+ * it at the top of each block. The audio thread keeps its own copy of every
+ * parameter, so nothing it reads is ever written by another thread.
+ *
+ * Changes coalesce: each command type has one slot holding its latest value and a
+ * sequence number, and drain() applies the slots that moved since the last drain.
+ * A push never fails, however long the audio thread goes without draining, and
+ * only the newest value of each parameter reaches it.
+ *
+ * Lock-free on the audio side (a seqlock per slot; a slot caught mid-write is
+ * picked up by the next drain). Producers (message thread, loader thread) are
+ * serialised by a mutex, which the audio thread never takes.
+ */
+class EngineCommandQueue
+{
+public:
+    static constexpr int numSlots = static_cast<int>(EngineCommand::Type::numTypes);
+
+    /** Replaces any change of the same type the audio thread hasn't drained yet */
+    void push(const EngineCommand& command)
+    {
+        std::lock_guard<std::mutex> lock(producerMutex);
+
+        auto& slot = slots[static_cast<size_t>(command.type)];
+        const uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);  // Odd: being written
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < command.floatValues.size(); ++i)
+            slot.floatValues[i].store(command.floatValues[i], std::memory_order_relaxed);
+        slot.intValue.store(command.intValue, std::memory_order_relaxed);
+
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    /** Audio thread: calls apply(command) for every slot changed since the last drain, in type order */
+    template <typename Function>
+    int drain(Function&& apply)
+    {
+        int applied = 0;
+        for (size_t type = 0; type < slots.size(); ++type)
+        {
+            auto& slot = slots[type];
+            const uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence == drainedSequences[type] || (sequence & 1) != 0)
+                continue;
+
+            EngineCommand command;
+            command.type = static_cast<EngineCommand::Type>(type);
+            for (size_t i = 0; i < command.floatValues.size(); ++i)
+                command.floatValues[i] = slot.floatValues[i].load(std::memory_order_relaxed);
+            command.intValue = slot.intValue.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+                continue;  // Written meanwhile: the next drain gets the newer value
+
+            drainedSequences[type] = sequence;
+            apply(command);
+            ++applied;
+        }
+        return applied;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<uint32_t> sequence{0};
+        std::array<std::atomic<float>, 4> floatValues{};
+        std::atomic<int> intValue{0};
+    };
+
+    std::array<Slot, static_cast<size_t>(numSlots)> slots;
+    std::array<uint32_t, static_cast<size_t>(numSlots)> drainedSequences{};  // Audio thread only
+    std::mutex producerMutex;
+};
@@ -0,0 +1,150 @@
+#include "LibraryIndexCache.h"
+
+namespace
+{
+    constexpr int indexMagic = 0x58495348;  // "HSIX"
+}
+
+LibraryIndexCache::LibraryIndexCache(const juce::File& folder, const juce::File& cacheDirectory)
+    : libraryFolder(folder)
+{
+    const juce::File directory = cacheDirectory == juce::File() ? getDefaultCacheDirectory() : cacheDirectory;
+    const juce::String key = juce::String::toHexString(static_cast<juce::int64>(folder.getFullPathName().hashCode64()));
+    indexFile = directory.getChildFile(key + ".idx");
+}
+
+juce::File LibraryIndexCache::getDefaultCacheDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("Hammer Sampler")
+        .getChildFile("IndexCache");
+}
+
+bool LibraryIndexCache::load()
+{
+    entries.clear();
+    entryByPath.clear();
+
+    juce::MemoryBlock data;
+    if (!indexFile.existsAsFile() || !indexFile.loadFileAsData(data))
+        return false;
+
+    juce::MemoryInputStream in(data, false);
+    if (in.readInt() != indexMagic || in.readInt() != formatVersion)
+        return false;
+
+    // Guards against two folders whose paths hash the same
+    if (in.readString() != libraryFolder.getFullPathName())
+        return false;
+
+    const int numEntries = in.readInt();
+    if (numEntries < 0)
+        return false;
+
+    std::vector<Entry> loaded;
+
+    for (int i = 0; i < numEntries; ++i)
+    {
+        Entry entry;
+        entry.relativePath = in.readString();
+        entry.fileSize = in.readInt64();
+        entry.modificationTime = in.readInt64();
+        entry.isSample = in.readBool();
+        entry.midiNote = in.readInt();
+        entry.velocity = in.readInt();
+        entry.roundRobin = in.readInt();
+        entry.totalFrames = in.readInt64();
+        entry.sampleRate = in.readDouble();
+        entry.numChannels = in.readInt();
+        entry.dataOffset = in.readInt64();
+        entry.integerBits = in.readInt();
+        entry.contentHash = static_cast<uint64_t>(in.readInt64());
+        entry.audibleStart = in.readInt64();
+        entry.audibleEnd = in.readInt64();
+        entry.audibleThresholdDb = in.readFloat();
+
+        // A truncated file reads as zeros; reject it rather than trust half an index
+        if (in.isExhausted())
+            return false;
+
+        loaded.push_back(std::move(entry));
+    }
+
+    // The trailing marker catches truncation inside the last entry
+    if (in.readInt() != indexMagic || !in.isExhausted())
+        return false;
+
+    setEntries(std::move(loaded));
+    return true;
+}
+
+bool LibraryIndexCache::save() const
+{
+    juce::MemoryOutputStream out;
+    out.writeInt(indexMagic);
+    out.writeInt(formatVersion);
+    out.writeString(libraryFolder.getFullPathName());
+    out.writeInt(static_cast<int>(entries.size()));
+
+    for (const auto& entry : entries)
+    {
+        out.writeString(entry.relativePath);
+        out.writeInt64(entry.fileSize);
+        out.writeInt64(entry.modificationTime);
+        out.writeBool(entry.isSample);
+        out.writeInt(entry.midiNote);
+        out.writeInt(entry.velocity);
+        out.writeInt(entry.roundRobin);
+        out.writeInt64(entry.totalFrames);
+        out.writeDouble(entry.sampleRate);
+        out.writeInt(entry.numChannels);
+        out.writeInt64(entry.dataOffset);
+        out.writeInt(entry.integerBits);
+        out.writeInt64(static_cast<juce::int64>(entry.contentHash));
+        out.writeInt64(entry.audibleStart);
+        out.writeInt64(entry.audibleEnd);
+        out.writeFloat(entry.audibleThresholdDb);
+    }
+
+    out.writeInt(indexMagic);
+
+    if (!indexFile.getParentDirectory().createDirectory())
+        return false;
+
+    return indexFile.replaceWithData(out.getData(), out.getDataSize());
+}
+
+const LibraryIndexCache::Entry* LibraryIndexCache::find(const juce::File& file) const
+{
+    auto it = entryByPath.find(file.getRelativePathFrom(libraryFolder));
+    if (it == entryByPath.end())
+        return nullptr;
+
+    const Entry& entry = entries[it->second];
+    if (entry.fileSize != file.getSize() || entry.modificationTime != file.getLastModificationTime().toMilliseconds())
+        return nullptr;
+
+    return &entry;
+}
+
+LibraryIndexCache::Entry LibraryIndexCache::makeEntry(const juce::File& file) const
+{
+    Entry entry;
+    entry.relativePath = file.getRelativePathFrom(libraryFolder);
+    entry.fileSize = file.getSize();
+    entry.modificationTime = file.getLastModificationTime().toMilliseconds();
+    return entry;
+}
+
+void LibraryIndexCache::setEntries(std::vector<Entry> newEntries)
+{
+    entries = std::move(newEntries);
+    rebuildPathIndex();
+}
+
+void LibraryIndexCache::rebuildPathIndex()
+{
+    entryByPath.clear();
+    for (size_t i = 0; i < entries.size(); ++i)
+        entryByPath[entries[i].relativePath] = i;
+}
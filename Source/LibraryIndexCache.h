@@ -0,0 +1,77 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+/**
+ * LibraryIndexCache remembers what a library scan found, so reopening a library
+ * only has to open files that are new or changed since the last scan.
+ *
+ * One compact binary index per library folder lives in the user's application
+ * data folder (libraries are often on read-only or shared drives). Entries are
+ * keyed by path relative to the library, and are only trusted while the file's
+ * size and modification time still match. Audio files that aren't samples (names
+ * that don't parse, files that don't open) get an entry too, so they aren't
+ * reopened on every load.
+ *
+ * Not thread safe; the loader owns one instance per load.
+ */
+class LibraryIndexCache
+{
+public:
+    struct Entry
+    {
+        juce::String relativePath;  // Relative to the library folder
+        int64_t fileSize = 0;
+        int64_t modificationTime = 0;  // Milliseconds since the epoch
+        bool isSample = true;          // False: skipped until the file changes; the fields below are unused
+
+        int midiNote = 0;
+        int velocity = 0;
+        int roundRobin = 0;
+        int64_t totalFrames = 0;
+        double sampleRate = 0.0;
+        int numChannels = 0;
+        int64_t dataOffset = -1;  // Byte offset of the audio data, -1 if unknown
+        int integerBits = 0;      // 16 or 24 for integer PCM of that depth, else 0
+        uint64_t contentHash = 0; // LibraryScanner::hashContent(), 0 if unknown
+        int64_t audibleStart = 0; // LibraryScanner::findAudibleRange() at audibleThresholdDb...
+        int64_t audibleEnd = -1;  // ...-1 if not analysed
+        float audibleThresholdDb = 0.0f;
+    };
+
+    static constexpr int formatVersion = 5;
+
+    /** An empty cache directory means getDefaultCacheDirectory() */
+    explicit LibraryIndexCache(const juce::File& libraryFolder, const juce::File& cacheDirectory = {});
+
+    /** Read the index from disk. Returns false (leaving the cache empty) if it is missing or invalid. */
+    bool load();
+
+    /** Write the index to disk, replacing any previous one */
+    bool save() const;
+
+    /** The entry for a file, or nullptr if there is none or the file changed since it was indexed */
+    const Entry* find(const juce::File& file) const;
+
+    /** Entry with the key fields (path, size, time) filled in for a file in the library */
+    Entry makeEntry(const juce::File& file) const;
+
+    void setEntries(std::vector<Entry> newEntries);
+    const std::vector<Entry>& getEntries() const { return entries; }
+
+    juce::File getIndexFile() const { return indexFile; }
+
+    static juce::File getDefaultCacheDirectory();
+
+private:
+    void rebuildPathIndex();
+
+    juce::File libraryFolder;
+    juce::File indexFile;
+
+    std::vector<Entry> entries;
+    std::map<juce::String, size_t> entryByPath;
+};
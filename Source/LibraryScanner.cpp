@@ -0,0 +1,290 @@
+#include "LibraryScanner.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+LibraryScanner::LibraryScanner(juce::AudioFormatManager& manager)
+    : formatManager(manager)
+{
+}
+
+juce::Array<juce::File> LibraryScanner::findAudioFiles(const juce::File& folder, bool recursive)
+{
+    juce::Array<juce::File> audioFiles;
+    folder.findChildFiles(audioFiles, juce::File::findFiles, recursive, audioFilePatterns);
+
+    // Directory order is filesystem dependent; keep sample order stable between loads
+    std::sort(audioFiles.begin(), audioFiles.end(), [](const juce::File& a, const juce::File& b)
+    {
+        return a.getFullPathName() < b.getFullPathName();
+    });
+    return audioFiles;
+}
+
+std::vector<LibraryScanner::ScannedSample> LibraryScanner::scan(const juce::File& folder, const Options& options)
+{
+    return scanFiles(findAudioFiles(folder, options.recursive), options);
+}
+
+std::vector<LibraryScanner::ScannedSample> LibraryScanner::scanFiles(const juce::Array<juce::File>& audioFiles,
+                                                                     const Options& options)
+{
+    const size_t numFiles = static_cast<size_t>(audioFiles.size());
+
+    std::vector<ScannedSample> results(numFiles);
+    std::vector<char> valid(numFiles, 0);
+
+    forEachInParallel(numFiles, options.numThreads, [&](size_t i)
+    {
+        if (options.shouldCancel && options.shouldCancel())
+            return;
+
+        valid[i] = scanFile(audioFiles[static_cast<int>(i)], options, results[i]) ? 1 : 0;
+
+        if (options.onFileScanned)
+            options.onFileScanned();
+    });
+
+    // Compact, keeping enumeration order
+    std::vector<ScannedSample> scanned;
+    scanned.reserve(numFiles);
+    for (size_t i = 0; i < numFiles; ++i)
+    {
+        if (valid[i])
+            scanned.push_back(std::move(results[i]));
+    }
+    return scanned;
+}
+
+void LibraryScanner::forEachInParallel(size_t count, int numThreads, const std::function<void(size_t)>& job)
+{
+    // Disk bound: a few more threads than cores keeps the drive's queue full
+    if (numThreads <= 0)
+        numThreads = juce::jlimit(2, 8, juce::SystemStats::getNumCpus() * 2);
+    numThreads = juce::jmin(numThreads, juce::jmax(1, static_cast<int>(count)));
+
+    std::atomic<size_t> nextIndex{0};
+    auto worker = [&]
+    {
+        for (size_t i = nextIndex.fetch_add(1); i < count; i = nextIndex.fetch_add(1))
+            job(i);
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 1; t < numThreads; ++t)
+        workers.emplace_back(worker);
+    worker();  // This thread works too
+    for (auto& thread : workers)
+        thread.join();
+}
+
+bool LibraryScanner::scanFile(const juce::File& file, const Options& options, ScannedSample& result)
+{
+    int note, velocity, roundRobin;
+    if (!options.parseFileName || !options.parseFileName(file.getFileName(), note, velocity, roundRobin))
+        return false;
+
+    // The scan's only open of this file
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (!reader)
+        return false;
+
+    // Only 16- and 24-bit integer files can be kept compact
+    const int bits = static_cast<int>(reader->bitsPerSample);
+    const int integerBits = !reader->usesFloatingPointData && (bits == 16 || bits == 24) ? bits : 0;
+
+    result = describeSample(file, note, velocity, roundRobin, reader->sampleRate,
+                            static_cast<int>(reader->numChannels), static_cast<int64_t>(reader->lengthInSamples),
+                            integerBits);
+
+    if (reader->input != nullptr)
+    {
+        result.dataOffset = findDataOffset(*reader->input);
+        if (result.dataOffset >= 0)
+            result.contentHash = hashContent(*reader->input, result.dataOffset, result.info);
+    }
+
+    if (options.analyseSilence)
+    {
+        findAudibleRange(*reader, options.silenceThresholdDb, result.audibleStart, result.audibleEnd);
+        result.audibleThresholdDb = options.silenceThresholdDb;
+    }
+
+    return true;
+}
+
+LibraryScanner::ScannedSample LibraryScanner::describeSample(const juce::File& file, int note, int velocity,
+                                                            int roundRobin, double sampleRate, int numChannels,
+                                                            int64_t totalFrames, int integerBits)
+{
+    ScannedSample result;
+    result.midiNote = note;
+    result.velocity = velocity;
+    result.roundRobin = roundRobin;
+    result.fileSize = file.getSize();
+
+    auto& info = result.info;
+    info.path = SamplePath::intern(file);
+    info.sampleRate = sampleRate;
+    info.numChannels = numChannels;
+    info.totalSampleFrames = totalFrames;
+    info.integerBits = integerBits;
+    info.rootNote = note;
+    info.preloadSizeFrames = 0;  // Set on the preload itself
+    return result;
+}
+
+int LibraryScanner::getPreloadSizeFrames(const PreloadedSample& info, int preloadSizeKB)
+{
+    if (info.numChannels <= 0)
+        return 0;
+
+    int bytesPerSample = sizeof(float);
+    int preloadBytes = preloadSizeKB * 1024;
+    int framesToPreload = preloadBytes / (info.numChannels * bytesPerSample);
+    return static_cast<int>(std::min(static_cast<int64_t>(framesToPreload), info.totalSampleFrames));
+}
+
+std::unique_ptr<PreloadedSample> LibraryScanner::makePreload(const PreloadedSample& info)
+{
+    // Copy the metadata; the preload is immutable once published
+    auto preload = std::make_unique<PreloadedSample>();
+    preload->path = info.path;
+    preload->totalSampleFrames = info.totalSampleFrames;
+    preload->fileStartFrame = info.fileStartFrame;
+    preload->sampleRate = info.sampleRate;
+    preload->numChannels = info.numChannels;
+    preload->integerBits = info.integerBits;
+    preload->rootNote = info.rootNote;
+    return preload;
+}
+
+int64_t LibraryScanner::findDataOffset(juce::InputStream& stream)
+{
+    const int64_t originalPosition = stream.getPosition();
+    int64_t offset = -1;
+
+    auto readBytes = [&stream](uint8_t* dest, int size) { return stream.read(dest, size) == size; };
+    auto littleEndian32 = [](const uint8_t* b) { return static_cast<uint32_t>(b[0] | (b[1] << 8) | (b[2] << 16) | (static_cast<uint32_t>(b[3]) << 24)); };
+    auto bigEndian32 = [](const uint8_t* b) { return static_cast<uint32_t>((static_cast<uint32_t>(b[0]) << 24) | (b[1] << 16) | (b[2] << 8) | b[3]); };
+
+    uint8_t header[12];
+    if (stream.setPosition(0) && readBytes(header, 12))
+    {
+        const bool isWav = std::memcmp(header + 8, "WAVE", 4) == 0
+                        && (std::memcmp(header, "RIFF", 4) == 0 || std::memcmp(header, "RF64", 4) == 0);
+        const bool isAiff = std::memcmp(header, "FORM", 4) == 0
+                         && (std::memcmp(header + 8, "AIFF", 4) == 0 || std::memcmp(header + 8, "AIFC", 4) == 0);
+
+        // Walk the top-level chunks; both formats pad chunks to an even size
+        int64_t chunkStart = 12;
+        uint8_t chunk[8];
+        while ((isWav || isAiff) && stream.setPosition(chunkStart) && readBytes(chunk, 8))
+        {
+            const uint32_t chunkSize = isWav ? littleEndian32(chunk + 4) : bigEndian32(chunk + 4);
+
+            if (isWav && std::memcmp(chunk, "data", 4) == 0)
+            {
+                offset = chunkStart + 8;
+                break;
+            }
+
+            if (isAiff && std::memcmp(chunk, "SSND", 4) == 0)
+            {
+                // SSND starts with its own offset and block size fields
+                uint8_t ssndHeader[4];
+                if (readBytes(ssndHeader, 4))
+                    offset = chunkStart + 16 + bigEndian32(ssndHeader);
+                break;
+            }
+
+            chunkStart += 8 + static_cast<int64_t>(chunkSize) + (chunkSize & 1);
+        }
+    }
+
+    stream.setPosition(originalPosition);
+    return offset;
+}
+
+void LibraryScanner::findAudibleRange(juce::AudioFormatReader& reader, float thresholdDb, int64_t& start, int64_t& end)
+{
+    const auto length = static_cast<int64_t>(reader.lengthInSamples);
+    const int numChannels = static_cast<int>(reader.numChannels);
+    start = 0;
+    end = length;
+    if (length <= 0 || numChannels <= 0)
+        return;
+
+    const float threshold = juce::Decibels::decibelsToGain(thresholdDb, -200.0f);
+    constexpr int chunkFrames = 16384;
+    juce::AudioBuffer<float> chunk(numChannels, chunkFrames);
+
+    auto isAudible = [&](int frame)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            if (std::abs(chunk.getSample(channel, frame)) > threshold)
+                return true;
+        }
+        return false;
+    };
+
+    int64_t first = -1;
+    for (int64_t position = 0; position < length && first < 0; position += chunkFrames)
+    {
+        const int numFrames = static_cast<int>(std::min<int64_t>(chunkFrames, length - position));
+        if (!reader.read(&chunk, 0, numFrames, position, true, true))
+            return;
+
+        for (int i = 0; i < numFrames && first < 0; ++i)
+        {
+            if (isAudible(i))
+                first = position + i;
+        }
+    }
+    if (first < 0)
+        return;  // Silent throughout: nothing to keep it to
+
+    int64_t last = -1;
+    for (int64_t chunkEnd = length; chunkEnd > first && last < 0; chunkEnd -= chunkFrames)
+    {
+        const int64_t position = std::max(first, chunkEnd - chunkFrames);
+        const int numFrames = static_cast<int>(chunkEnd - position);
+        if (!reader.read(&chunk, 0, numFrames, position, true, true))
+            return;
+
+        for (int i = numFrames - 1; i >= 0 && last < 0; --i)
+        {
+            if (isAudible(i))
+                last = position + i;
+        }
+    }
+
+    start = first;
+    end = std::max(first, last) + 1;
+}
+
+uint64_t LibraryScanner::hashContent(juce::InputStream& stream, int64_t dataOffset, const PreloadedSample& info)
+{
+    // FNV-1a: cheap, and collisions only cost a comparison
+    uint64_t hash = 14695981039346656037ull;
+    auto add = [&hash](const void* data, size_t size)
+    {
+        for (size_t i = 0; i < size; ++i)
+            hash = (hash ^ static_cast<const uint8_t*>(data)[i]) * 1099511628211ull;
+    };
+
+    add(&info.totalSampleFrames, sizeof(info.totalSampleFrames));
+    add(&info.numChannels, sizeof(info.numChannels));
+    add(&info.sampleRate, sizeof(info.sampleRate));
+    add(&info.integerBits, sizeof(info.integerBits));
+
+    const int64_t originalPosition = stream.getPosition();
+    uint8_t data[hashedBytes];
+    if (stream.setPosition(dataOffset))
+        add(data, static_cast<size_t>(std::max(0, stream.read(data, hashedBytes))));
+    stream.setPosition(originalPosition);
+
+    return hash != 0 ? hash : 1;
+}
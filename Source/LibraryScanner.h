@@ -0,0 +1,102 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "DiskStreaming.h"
+
+/**
+ * LibraryScanner turns a sample folder into sample metadata.
+ *
+ * Pipeline:
+ * 1. Enumerate audio files (optionally including subfolders)
+ * 2. On a pool of worker threads, per file: parse the file name, open it once,
+ *    and read the header, the data offset, the content hash and (optionally) the
+ *    audible range
+ *
+ * Preloads are not read here: which samples get one, at what size and in which
+ * format depends on the whole library, so the engine reads them once the scan is done.
+ *
+ * Results come back in enumeration order, skipping files whose names don't parse
+ * or that can't be opened.
+ *
+ * Callers with a LibraryIndexCache scan only the files the cache can't answer
+ * (scanFiles).
+ */
+class LibraryScanner
+{
+public:
+    using FileNameParser = std::function<bool(const juce::String& fileName, int& note, int& velocity, int& roundRobin)>;
+
+    struct Options
+    {
+        bool recursive = true;
+        int numThreads = 0;        // 0 = pick from the CPU count
+        bool analyseSilence = false;       // Find each file's audible range (findAudibleRange)
+        float silenceThresholdDb = -80.0f; // Level at or below which leading and trailing frames are silent
+        FileNameParser parseFileName;
+        std::function<bool()> shouldCancel;  // Polled before each file; true skips the rest
+        std::function<void()> onFileScanned; // Called after each file, from any worker thread
+    };
+
+    struct ScannedSample
+    {
+        int midiNote = 0;
+        int velocity = 0;
+        int roundRobin = 0;
+        int64_t fileSize = 0;
+        int64_t dataOffset = -1;                   // Byte offset of the audio data (WAV/AIFF), else -1
+        uint64_t contentHash = 0;                  // hashContent() of the audio data, 0 if unknown
+        int64_t audibleStart = 0;                  // findAudibleRange() at audibleThresholdDb...
+        int64_t audibleEnd = -1;                   // ...-1 if not analysed
+        float audibleThresholdDb = 0.0f;
+        PreloadedSample info;                      // Metadata only, no preload data
+    };
+
+    static constexpr const char* audioFilePatterns = "*.wav;*.aif;*.aiff;*.flac;*.mp3";
+
+    explicit LibraryScanner(juce::AudioFormatManager& formatManager);
+
+    std::vector<ScannedSample> scan(const juce::File& folder, const Options& options);
+
+    /** Same as scan(), for an explicit list of files */
+    std::vector<ScannedSample> scanFiles(const juce::Array<juce::File>& audioFiles, const Options& options);
+
+    /** Sample with its metadata filled in from already known header values */
+    static ScannedSample describeSample(const juce::File& file, int note, int velocity, int roundRobin,
+                                        double sampleRate, int numChannels, int64_t totalFrames,
+                                        int integerBits = 0);
+
+    /** All audio files in a folder, sorted by path */
+    static juce::Array<juce::File> findAudioFiles(const juce::File& folder, bool recursive);
+
+    /** Frames a preload of preloadSizeKB keeps for a sample: that much float data, or the whole file if shorter */
+    static int getPreloadSizeFrames(const PreloadedSample& info, int preloadSizeKB);
+
+    /** New preload carrying info's metadata, with an empty buffer */
+    static std::unique_ptr<PreloadedSample> makePreload(const PreloadedSample& info);
+
+    /** Byte offset of the sample data in a RIFF/RF64 WAV or AIFF stream, or -1. Restores the stream position. */
+    static int64_t findDataOffset(juce::InputStream& stream);
+
+    /** Hash of a sample's shape and its first hashedBytes of raw audio data, never 0. Samples with
+        equal hashes are candidates for sharing a preload; callers confirm by comparing data.
+        Restores the stream position. */
+    static uint64_t hashContent(juce::InputStream& stream, int64_t dataOffset, const PreloadedSample& info);
+
+    static constexpr int hashedBytes = 4096;
+
+    /** Frames [start, end) of a file between its leading and trailing silence: frames at or below
+        thresholdDb on every channel. Reads forwards to the first audible frame, then backwards from
+        the end to the last. A silent or unreadable file keeps all of its frames. */
+    static void findAudibleRange(juce::AudioFormatReader& reader, float thresholdDb, int64_t& start, int64_t& end);
+
+    /** Run job(i) for i in [0, count) on up to numThreads disk-bound threads (0 = pick), this one included */
+    static void forEachInParallel(size_t count, int numThreads, const std::function<void(size_t)>& job);
+
+private:
+    bool scanFile(const juce::File& file, const Options& options, ScannedSample& result);
+
+    juce::AudioFormatManager& formatManager;
+};
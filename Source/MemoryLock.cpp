@@ -0,0 +1,92 @@
+#include "MemoryLock.h"
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <sys/mman.h>
+ #include <sys/resource.h>
+ #include <unistd.h>
+#endif
+
+bool MemoryLock::lock(const void* data, size_t bytes)
+{
+    if (data == nullptr || bytes == 0)
+        return true;
+
+   #if JUCE_LINUX || JUCE_MAC
+    return mlock(data, bytes) == 0;
+   #else
+    return false;
+   #endif
+}
+
+void MemoryLock::unlock(const void* data, size_t bytes)
+{
+    if (data == nullptr || bytes == 0)
+        return;
+
+   #if JUCE_LINUX || JUCE_MAC
+    munlock(data, bytes);
+   #endif
+}
+
+void MemoryLock::touch(void* data, size_t bytes, bool writeable)
+{
+    auto* bytePointer = static_cast<volatile char*>(data);
+    for (size_t offset = 0; offset < bytes; offset += pageBytes)
+    {
+        const char value = bytePointer[offset];
+        if (writeable)
+            bytePointer[offset] = value;
+    }
+
+    // The last page, if the range doesn't end on the stride
+    if (bytes > 0)
+    {
+        const char value = bytePointer[bytes - 1];
+        if (writeable)
+            bytePointer[bytes - 1] = value;
+    }
+}
+
+void* MemoryLock::allocatePages(size_t bytes)
+{
+    const size_t pageSize = getPageSize();
+    const size_t size = std::max<size_t>(1, (bytes + pageSize - 1) / pageSize) * pageSize;
+    void* data = ::operator new(size, std::align_val_t(pageSize), std::nothrow);
+    if (data != nullptr)
+        std::memset(data, 0, size);
+    return data;
+}
+
+void MemoryLock::freePages(void* data)
+{
+    if (data != nullptr)
+        ::operator delete(data, std::align_val_t(getPageSize()));
+}
+
+size_t MemoryLock::getPageSize()
+{
+   #if JUCE_LINUX || JUCE_MAC
+    static const size_t pageSize = []
+    {
+        const long size = sysconf(_SC_PAGESIZE);
+        return size > 0 ? static_cast<size_t>(size) : pageBytes;
+    }();
+    return pageSize;
+   #else
+    return pageBytes;
+   #endif
+}
+
+int64_t MemoryLock::getLockLimit()
+{
+   #if JUCE_LINUX || JUCE_MAC
+    rlimit limit {};
+    if (getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+        return static_cast<int64_t>(limit.rlim_cur);
+   #endif
+    return -1;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * MemoryLock keeps memory the audio thread reads in RAM, so a note-on never waits
+ * on a page the OS swapped out.
+ *
+ * lock() pins pages with mlock where the OS has it (Linux, macOS). The OS refuses
+ * once the process' locked memory would pass RLIMIT_MEMLOCK (often only a few MB
+ * unless raised); callers then fall back to touch(), which faults the pages in
+ * without pinning them: resident for now, though still pageable later.
+ *
+ * Thread safe.
+ */
+class MemoryLock
+{
+public:
+    static constexpr size_t pageBytes = 4096;  // Touch stride; the smallest page size we run on
+
+    /** Pin a range into RAM. False if the OS refused or can't lock memory. */
+    static bool lock(const void* data, size_t bytes);
+    static void unlock(const void* data, size_t bytes);
+
+    /** Fault a range's pages in. Reading leaves the data alone, so it is safe on memory other
+        threads write; writeable = true also writes each page back, which is needed for fresh
+        anonymous memory (reads only map the shared zero page) but only safe if nothing else
+        uses the range yet. */
+    static void touch(void* data, size_t bytes, bool writeable);
+
+    /** Zeroed memory on pages of its own: page-aligned and a whole number of pages long.
+        mlock works on whole pages and doesn't count nested locks, so a range shared with a
+        neighbour would be unlocked along with it; this memory can be locked and unlocked alone.
+        Null if out of memory. Free with freePages(). */
+    static void* allocatePages(size_t bytes);
+    static void freePages(void* data);
+
+    /** The OS page size (pageBytes where it can't be asked) */
+    static size_t getPageSize();
+
+    /** RLIMIT_MEMLOCK's soft limit in bytes; -1 if unlimited or unknown */
+    static int64_t getLockLimit();
+};
@@ -0,0 +1,107 @@
+#include "MemoryPressure.h"
+
+// A "key value [kB]" line's value in bytes; -1 if the key isn't there
+static int64_t findField(const juce::String& text, const juce::String& key)
+{
+    for (const auto& line : juce::StringArray::fromLines(text))
+    {
+        juce::StringArray tokens;
+        tokens.addTokens(line.replaceCharacter(':', ' '), " \t", "");
+        tokens.removeEmptyStrings();
+        if (tokens.size() < 2 || tokens[0] != key || !tokens[1].containsOnly("0123456789"))
+            continue;
+
+        const int64_t value = tokens[1].getLargeIntValue();
+        return (tokens.size() > 2 && tokens[2].equalsIgnoreCase("kB")) ? value * 1024 : value;
+    }
+    return -1;
+}
+
+MemoryPressure::Reading MemoryPressure::parseMeminfo(const juce::String& meminfo)
+{
+    Reading reading;
+    reading.totalBytes = findField(meminfo, "MemTotal");
+    reading.availableBytes = findField(meminfo, "MemAvailable");
+    return reading;
+}
+
+MemoryPressure::Reading MemoryPressure::parseCgroup(const juce::String& limit, const juce::String& usage, const juce::String& stat)
+{
+    // No limit reads "max" (v2) or a page-rounded 2^63 - 1 (v1)
+    constexpr int64_t unlimitedBytes = int64_t(1) << 60;
+    const auto limitText = limit.trim();
+    const auto usageText = usage.trim();
+    if (!limitText.containsOnly("0123456789") || limitText.isEmpty() || !usageText.containsOnly("0123456789") || usageText.isEmpty())
+        return {};
+
+    const int64_t limitBytes = limitText.getLargeIntValue();
+    if (limitBytes <= 0 || limitBytes >= unlimitedBytes)
+        return {};
+
+    // The kernel drops inactive file pages before it has to swap anything
+    int64_t reclaimable = findField(stat, "inactive_file");
+    if (reclaimable < 0)
+        reclaimable = findField(stat, "total_inactive_file");
+
+    Reading reading;
+    reading.totalBytes = limitBytes;
+    reading.availableBytes = juce::jlimit<int64_t>(0, limitBytes, limitBytes - usageText.getLargeIntValue() + juce::jmax<int64_t>(0, reclaimable));
+    reading.fromCgroup = true;
+    return reading;
+}
+
+MemoryPressure::Reading MemoryPressure::tighter(const Reading& a, const Reading& b)
+{
+    if (!a.isKnown())
+        return b;
+    if (!b.isKnown())
+        return a;
+    return b.availableBytes < a.availableBytes ? b : a;
+}
+
+MemoryPressure::Reading MemoryPressure::read()
+{
+   #if JUCE_LINUX
+    auto readFile = [](const char* path) { return juce::File(path).loadFileAsString(); };
+
+    auto reading = parseMeminfo(readFile("/proc/meminfo"));
+
+    // cgroup v2 unified hierarchy, else v1's memory controller
+    if (juce::File("/sys/fs/cgroup/memory.max").existsAsFile())
+        reading = tighter(reading, parseCgroup(readFile("/sys/fs/cgroup/memory.max"), readFile("/sys/fs/cgroup/memory.current"),
+                                               readFile("/sys/fs/cgroup/memory.stat")));
+    else if (juce::File("/sys/fs/cgroup/memory/memory.limit_in_bytes").existsAsFile())
+        reading = tighter(reading, parseCgroup(readFile("/sys/fs/cgroup/memory/memory.limit_in_bytes"),
+                                               readFile("/sys/fs/cgroup/memory/memory.usage_in_bytes"),
+                                               readFile("/sys/fs/cgroup/memory/memory.stat")));
+    return reading;
+   #else
+    return {};
+   #endif
+}
+
+MemoryPressure::Level MemoryPressure::nextLevel(Level current, const Reading& reading, const Thresholds& thresholds)
+{
+    if (!reading.isKnown())
+        return Level::normal;
+
+    const double available = reading.getAvailableFraction();
+    if (available < thresholds.criticalFraction)
+        return Level::critical;
+    if (available < thresholds.lowFraction)
+        return current == Level::critical ? Level::critical : Level::low;
+    if (available < thresholds.clearFraction)
+        return current == Level::normal ? Level::normal : Level::low;
+    return Level::normal;
+}
+
+juce::String MemoryPressure::getLevelName(Level level)
+{
+    switch (level)
+    {
+        case Level::low:      return "low";
+        case Level::critical: return "critical";
+        case Level::normal:   break;
+    }
+    return "normal";
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cstdint>
+
+/**
+ * MemoryPressure reads how much RAM the process can still get and turns it into a
+ * pressure level, so the engine can give preload memory back before the OS starts
+ * paging audio memory out.
+ *
+ * On Linux the reading is the tighter of /proc/meminfo's MemAvailable and, when the
+ * process runs in a memory-limited cgroup, the cgroup's limit less its usage, with
+ * its inactive file cache counted as available (v2: memory.max, memory.current and
+ * memory.stat; v1: memory.limit_in_bytes, memory.usage_in_bytes and memory.stat).
+ * Elsewhere nothing is read: the reading is unknown and the level stays normal.
+ *
+ * The parsers take the files' text, so they can be tested on fixed input.
+ *
+ * Thread safe: everything is static.
+ */
+class MemoryPressure
+{
+public:
+    enum class Level
+    {
+        normal,
+        low,      // Below lowFraction available
+        critical  // Below criticalFraction available
+    };
+
+    struct Reading
+    {
+        int64_t availableBytes = -1;  // -1 = unknown
+        int64_t totalBytes = -1;
+        bool fromCgroup = false;      // The cgroup's limit was the tighter one
+
+        bool isKnown() const { return availableBytes >= 0 && totalBytes > 0; }
+        double getAvailableFraction() const { return isKnown() ? static_cast<double>(availableBytes) / static_cast<double>(totalBytes) : 1.0; }
+    };
+
+    struct Thresholds
+    {
+        double lowFraction = 0.10;
+        double criticalFraction = 0.05;
+        double clearFraction = 0.15;  // Back to normal only above this, so a reading near lowFraction doesn't flap
+    };
+
+    /** The system's reading, as described above */
+    static Reading read();
+
+    /** From /proc/meminfo's text: MemAvailable of MemTotal */
+    static Reading parseMeminfo(const juce::String& meminfo);
+
+    /** From a cgroup's limit, usage and memory.stat text. Unknown if the cgroup has no limit ("max",
+        or v1's near-2^63 default). */
+    static Reading parseCgroup(const juce::String& limit, const juce::String& usage, const juce::String& stat);
+
+    /** Whichever known reading has fewer bytes available */
+    static Reading tighter(const Reading& a, const Reading& b);
+
+    /** The level after a reading, given the current one: a level is entered below its threshold,
+        and left only once the reading is clear of it (critical above lowFraction, low above
+        clearFraction). An unknown reading is normal. */
+    static Level nextLevel(Level current, const Reading& reading, const Thresholds& thresholds);
+    static Level nextLevel(Level current, const Reading& reading) { return nextLevel(current, reading, Thresholds()); }
+
+    static juce::String getLevelName(Level level);
+};
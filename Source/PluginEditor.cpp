@@ -478,7 +478,21 @@ void MidiKeyboardEditor::timerCallback()
                 rrLimitSlider.setValue(processorRef.getRoundRobinLimit(), juce::dontSendNotification);
             }
         }
-        else if (!processorRef.areSamplesLoading())
+        else if (processorRef.areSamplesLoading())
+        {
+            // Scanning counts files; the first load stage counts preload data
+            auto progress = processorRef.getLoadProgress();
+            juce::String loadText = "Loading: " + pendingLoadFolder + "... ";
+            if (progress.bytesToPreload == 0)
+                loadText += juce::String(progress.filesScanned) + "/" + juce::String(progress.filesTotal) + " files";
+            else
+                loadText += juce::String(progress.bytesPreloaded / (1024.0 * 1024.0), 1) + "/" +
+                            juce::String(progress.bytesToPreload / (1024.0 * 1024.0), 1) + " MB";
+            if (progress.secondsRemaining >= 0.0)
+                loadText += " (~" + juce::String(juce::roundToInt(progress.secondsRemaining)) + " s)";
+            statusLabel.setText(loadText, juce::dontSendNotification);
+        }
+        else
         {
             statusLabel.setText("No valid samples found", juce::dontSendNotification);
             fileSizeLabel.setText("", juce::dontSendNotification);
@@ -491,16 +505,27 @@ void MidiKeyboardEditor::timerCallback()
     {
         int activeVoices = processorRef.getActiveVoiceCount();
         int streamingVoices = processorRef.getStreamingVoiceCount();
+        int voiceSteals = processorRef.getVoiceStealStats().steals;
         int underruns = processorRef.getUnderrunCount();
         float throughput = processorRef.getDiskThroughputMBps();
         int64_t preloadBytes = processorRef.getPreloadMemoryBytes();
 
+        // Progress of a velocity/RR limit change being applied in the background
+        auto preloadProgress = processorRef.getPreloadProgress();
+        int preloadPercent = -1;
+        if (preloadProgress.inProgress && preloadProgress.samplesTotal > 0)
+            preloadPercent = (100 * preloadProgress.samplesDone) / preloadProgress.samplesTotal;
+
         // Only update labels if values changed
-        if (activeVoices != cachedActiveVoices || streamingVoices != cachedStreamingVoices)
+        if (activeVoices != cachedActiveVoices || streamingVoices != cachedStreamingVoices || voiceSteals != cachedVoiceSteals)
         {
-            voiceActivityLabel.setText("Voices: " + juce::String(activeVoices) + " | Disk: " + juce::String(streamingVoices), juce::dontSendNotification);
+            juce::String voiceText = "Voices: " + juce::String(activeVoices) + " | Disk: " + juce::String(streamingVoices);
+            if (voiceSteals > 0)
+                voiceText += " (" + juce::String(voiceSteals) + " stolen)";
+            voiceActivityLabel.setText(voiceText, juce::dontSendNotification);
             cachedActiveVoices = activeVoices;
             cachedStreamingVoices = streamingVoices;
+            cachedVoiceSteals = voiceSteals;
         }
 
         if (throughput != cachedThroughput || underruns != cachedUnderruns)
@@ -513,7 +538,7 @@ void MidiKeyboardEditor::timerCallback()
             cachedUnderruns = underruns;
         }
 
-        if (preloadBytes != cachedPreloadBytes)
+        if (preloadBytes != cachedPreloadBytes || preloadPercent != cachedPreloadPercent)
         {
             juce::String preloadStr;
             if (preloadBytes >= 1024 * 1024 * 1024)
@@ -524,8 +549,11 @@ void MidiKeyboardEditor::timerCallback()
                 preloadStr = juce::String(preloadBytes / 1024.0, 1) + " KB";
             else
                 preloadStr = juce::String(preloadBytes) + " B";
+            if (preloadPercent >= 0)
+                preloadStr += " (" + juce::String(preloadPercent) + "%)";
             preloadMemLabel.setText("RAM: " + preloadStr, juce::dontSendNotification);
             cachedPreloadBytes = preloadBytes;
+            cachedPreloadPercent = preloadPercent;
         }
     }
     else if (cachedActiveVoices != 0)
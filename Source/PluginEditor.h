@@ -114,9 +114,11 @@ private:
     // Cached values to avoid redundant label updates
     int cachedActiveVoices = -1;
     int cachedStreamingVoices = -1;
+    int cachedVoiceSteals = -1;
     int cachedUnderruns = -1;
     float cachedThroughput = -1.0f;
     int64_t cachedPreloadBytes = -1;
+    int cachedPreloadPercent = -1;  // -1 = no limit change in progress
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiKeyboardEditor)
 };
@@ -47,6 +47,9 @@ void MidiKeyboardProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce:
 {
     buffer.clear();
 
+    // Pins the published sample map for this block (lock-free)
+    SamplerEngine::AudioBlockScope audioBlock(samplerEngine);
+
     for (const auto metadata : midiMessages)
     {
         auto message = metadata.getMessage();
@@ -98,7 +101,7 @@ void MidiKeyboardProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce:
             noteRoundRobin[noteIndex] = currentRoundRobin;
 
             // Get the velocity layer index for this note/velocity combo
-            int layerIdx = samplerEngine.getVelocityLayerIndex(midiNote, velocity);
+            int layerIdx = samplerEngine.lookupVelocityLayerIndex(midiNote, velocity);
             noteVelocityLayerIdx[noteIndex] = layerIdx;
 
             // Always mark RR as activated (for grid display of all playing voices)
@@ -127,7 +130,7 @@ void MidiKeyboardProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce:
             ++noteChangeCounter;
 
             // Advance round-robin: 1 -> 2 -> ... -> N -> 1 (limited by roundRobinLimit)
-            int rrLimit = samplerEngine.getRoundRobinLimit();
+            int rrLimit = samplerEngine.getAudioRoundRobinLimit();
             currentRoundRobin = (currentRoundRobin % rrLimit) + 1;
         }
         else if (message.isNoteOff())
@@ -136,6 +139,7 @@ void MidiKeyboardProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce:
             {
                 // Pedal is down - sustain the note visually
                 noteSustained[noteIndex] = true;
+                samplerEngine.noteSustainedByPedal(midiNote);
             }
             else
             {
@@ -179,8 +183,14 @@ void MidiKeyboardProcessor::getStateInformation(juce::MemoryBlock& destData)
     xml.setAttribute("sustain", adsr.sustain);
     xml.setAttribute("release", adsr.release);
 
-    // Save preload size
+    // Save preload size, RAM budget, adaptive sizing and huge pages
     xml.setAttribute("preloadSizeKB", getPreloadSizeKB());
+    xml.setAttribute("preloadBudgetMB", getPreloadBudgetMB());
+    xml.setAttribute("adaptivePreloads", isAdaptivePreloadSizing());
+    xml.setAttribute("preloadHugePages", static_cast<int>(getPreloadHugePages()));
+    xml.setAttribute("lockPreloadMemory", getLockPreloadMemory());
+    xml.setAttribute("compactPreloads", getCompactPreloads());
+    xml.setAttribute("memoryPressureResponse", getMemoryPressureResponse());
 
     // Save transpose
     xml.setAttribute("transpose", transposeAmount);
@@ -194,6 +204,25 @@ void MidiKeyboardProcessor::getStateInformation(juce::MemoryBlock& destData)
     // Save round robin limit
     xml.setAttribute("roundRobinLimit", samplerEngine.getRoundRobinLimit());
 
+    // Save the samples this session played, so reopening warms them first
+    xml.setAttribute("workingSet", samplerEngine.getWorkingSet().toString());
+
+    // Save library layers (sampleFolder above is the first one's, for older versions)
+    for (const auto& layer : samplerEngine.getLibraryLayers())
+    {
+        auto* layerXml = xml.createNewChildElement("Layer");
+        layerXml->setAttribute("folder", layer.folder.getFullPathName());
+        layerXml->setAttribute("lowNote", layer.settings.lowNote);
+        layerXml->setAttribute("highNote", layer.settings.highNote);
+        layerXml->setAttribute("lowVelocity", layer.settings.lowVelocity);
+        layerXml->setAttribute("highVelocity", layer.settings.highVelocity);
+        layerXml->setAttribute("gain", layer.settings.gain);
+        layerXml->setAttribute("velocityLayerLimit", layer.settings.velocityLayerLimit);
+        layerXml->setAttribute("roundRobinLimit", layer.settings.roundRobinLimit);
+        layerXml->setAttribute("trimSilence", layer.settings.trimSilence);
+        layerXml->setAttribute("silenceThresholdDb", layer.settings.silenceThresholdDb);
+    }
+
     copyXmlToBinary(xml, destData);
 }
 
@@ -211,9 +240,17 @@ void MidiKeyboardProcessor::setStateInformation(const void* data, int sizeInByte
         float release = static_cast<float>(xml->getDoubleAttribute("release", 0.3));
         setADSR(attack, decay, sustain, release);
 
-        // Restore preload size
+        // Restore preload size, RAM budget, adaptive sizing and huge pages
         int preloadSizeKB = xml->getIntAttribute("preloadSizeKB", 64);
         setPreloadSizeKB(preloadSizeKB);
+        setPreloadBudgetMB(xml->getIntAttribute("preloadBudgetMB", 0));
+        setAdaptivePreloadSizing(xml->getBoolAttribute("adaptivePreloads", false));
+        // 0 = off, 1 = transparent (what older versions saved as "1"), 2 = reserved
+        const int hugePages = juce::jlimit(0, 2, xml->getIntAttribute("preloadHugePages", 0));
+        setPreloadHugePages(static_cast<PreloadArena::HugePages>(hugePages));
+        setLockPreloadMemory(xml->getBoolAttribute("lockPreloadMemory", false));
+        setCompactPreloads(xml->getBoolAttribute("compactPreloads", false));
+        setMemoryPressureResponse(xml->getBoolAttribute("memoryPressureResponse", true));
 
         // Restore transpose
         int transpose = xml->getIntAttribute("transpose", 0);
@@ -231,7 +268,36 @@ void MidiKeyboardProcessor::setStateInformation(const void* data, int sizeInByte
         int rrLimit = xml->getIntAttribute("roundRobinLimit", 99);
         samplerEngine.setRoundRobinLimit(rrLimit);
 
-        // Restore sample folder
+        // Restore the working set (the load below warms it before anything else)
+        samplerEngine.setWorkingSet(WorkingSet::fromString(xml->getStringAttribute("workingSet", "")));
+
+        // Restore library layers; layers whose folder is gone are left out
+        std::vector<SamplerEngine::LibraryLayer> layers;
+        for (auto* layerXml : xml->getChildWithTagNameIterator("Layer"))
+        {
+            SamplerEngine::LibraryLayer layer;
+            layer.folder = juce::File(layerXml->getStringAttribute("folder", ""));
+            layer.settings.lowNote = layerXml->getIntAttribute("lowNote", 0);
+            layer.settings.highNote = layerXml->getIntAttribute("highNote", 127);
+            layer.settings.lowVelocity = layerXml->getIntAttribute("lowVelocity", 1);
+            layer.settings.highVelocity = layerXml->getIntAttribute("highVelocity", 127);
+            layer.settings.gain = static_cast<float>(layerXml->getDoubleAttribute("gain", 1.0));
+            layer.settings.velocityLayerLimit = layerXml->getIntAttribute("velocityLayerLimit", 0);
+            layer.settings.roundRobinLimit = layerXml->getIntAttribute("roundRobinLimit", 0);
+            layer.settings.trimSilence = layerXml->getBoolAttribute("trimSilence", false);
+            layer.settings.silenceThresholdDb = static_cast<float>(layerXml->getDoubleAttribute("silenceThresholdDb", -80.0));
+
+            if (layer.folder.isDirectory())
+                layers.push_back(std::move(layer));
+        }
+
+        if (!layers.empty())
+        {
+            loadLibraryLayers(std::move(layers));
+            return;
+        }
+
+        // Restore sample folder (state saved before layers)
         juce::String folderPath = xml->getStringAttribute("sampleFolder", "");
         if (folderPath.isNotEmpty())
         {
@@ -18,6 +18,9 @@ public:
 
     // Sample loading
     void loadSamplesFromFolder(const juce::File& folder);
+    void loadLibraryLayers(std::vector<SamplerEngine::LibraryLayer> layers) { samplerEngine.loadLibraryLayers(std::move(layers)); }
+    std::vector<SamplerEngine::LibraryLayer> getLibraryLayers() const { return samplerEngine.getLibraryLayers(); }
+    void setLayerSettings(int layerIndex, const SamplerEngine::LayerSettings& settings) { samplerEngine.setLayerSettings(layerIndex, settings); }
     bool areSamplesLoaded() const { return samplerEngine.isLoaded(); }
     bool areSamplesLoading() const { return samplerEngine.isLoading(); }
     juce::String getLoadedFolderPath() const { return samplerEngine.getLoadedFolderPath(); }
@@ -28,10 +31,28 @@ public:
     int getPreloadSizeKB() const { return samplerEngine.getPreloadSizeKB(); }
     void setPreloadSizeKB(int sizeKB) { samplerEngine.setPreloadSizeKB(sizeKB); }
     void reloadPreloadBuffers() { samplerEngine.reloadPreloadBuffers(); }
+    int getPreloadBudgetMB() const { return samplerEngine.getPreloadBudgetMB(); }
+    void setPreloadBudgetMB(int budgetMB) { samplerEngine.setPreloadBudgetMB(budgetMB); }
+    SamplerEngine::PreloadAllocation getPreloadAllocation() const { return samplerEngine.getPreloadAllocation(); }
+    bool isAdaptivePreloadSizing() const { return samplerEngine.isAdaptivePreloadSizing(); }
+    void setAdaptivePreloadSizing(bool enabled) { samplerEngine.setAdaptivePreloadSizing(enabled); }
+    PreloadArena::HugePages getPreloadHugePages() const { return samplerEngine.getPreloadHugePages(); }
+    void setPreloadHugePages(PreloadArena::HugePages mode) { samplerEngine.setPreloadHugePages(mode); }
+    bool getLockPreloadMemory() const { return samplerEngine.getLockPreloadMemory(); }
+    void setLockPreloadMemory(bool enabled) { samplerEngine.setLockPreloadMemory(enabled); }
+    bool getCompactPreloads() const { return samplerEngine.getCompactPreloads(); }
+    void setCompactPreloads(bool enabled) { samplerEngine.setCompactPreloads(enabled); }
+    bool getMemoryPressureResponse() const { return samplerEngine.getMemoryPressureResponse(); }
+    void setMemoryPressureResponse(bool enabled) { samplerEngine.setMemoryPressureResponse(enabled); }
+    PreloadArena::Stats getPreloadArenaStats() const { return samplerEngine.getPreloadArenaStats(); }
     int getActiveVoiceCount() const { return samplerEngine.getActiveVoiceCount(); }
     int getStreamingVoiceCount() const { return samplerEngine.getStreamingVoiceCount(); }
     float getDiskThroughputMBps() const { return samplerEngine.getDiskThroughputMBps(); }
     int getUnderrunCount() const { return samplerEngine.getUnderrunCount(); }
+    SamplerEngine::VoiceStealStats getVoiceStealStats() const { return samplerEngine.getVoiceStealStats(); }
+    SamplerEngine::PreloadProgress getPreloadProgress() const { return samplerEngine.getPreloadProgress(); }
+    LoadStage getLoadStage() const { return samplerEngine.getLoadStage(); }
+    SamplerEngine::LoadProgress getLoadProgress() const { return samplerEngine.getLoadProgress(); }
     void resetUnderrunCount() { samplerEngine.resetUnderrunCount(); }
 
     // ADSR controls
@@ -0,0 +1,334 @@
+#include "PreloadArena.h"
+#include "MemoryLock.h"
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#if JUCE_LINUX
+ #include <sys/mman.h>
+#endif
+
+struct PreloadArena::Pool
+{
+    struct Slab
+    {
+        char* data = nullptr;
+        size_t size = 0;
+        bool hugePages = false;
+        bool reservedHugePages = false;
+        bool locked = false;
+        bool lockFailed = false;
+        bool evacuating = false;
+        size_t usedBytes = 0;
+        int blocks = 0;
+        std::map<size_t, size_t> freeRanges;  // Offset -> size; neighbours are always merged
+    };
+
+    ~Pool()
+    {
+        for (auto& slab : slabs)
+            destroySlab(*slab);
+    }
+
+    static std::unique_ptr<Slab> createSlab(size_t size, HugePages hugePages)
+    {
+        auto slab = std::make_unique<Slab>();
+        slab->size = size;
+
+       #if JUCE_LINUX
+        // The reserved pool hands out whole huge pages (slab sizes are multiples of them),
+        // or fails straight away if it has too few left
+        if (hugePages == HugePages::reserved)
+        {
+            void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (mapping != MAP_FAILED)
+            {
+                slab->data = static_cast<char*>(mapping);
+                slab->hugePages = slab->reservedHugePages = true;
+                slab->freeRanges[0] = size;
+                return slab;
+            }
+        }
+
+        // Over-map by one huge page so the slab can start on a huge page boundary, then trim
+        const size_t mappedSize = size + hugePageBytes;
+        void* mapping = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED)
+            return nullptr;
+
+        const auto start = reinterpret_cast<uintptr_t>(mapping);
+        const auto aligned = (start + hugePageBytes - 1) & ~static_cast<uintptr_t>(hugePageBytes - 1);
+        if (aligned > start)
+            munmap(mapping, aligned - start);
+        if (const size_t tail = start + mappedSize - (aligned + size); tail > 0)
+            munmap(reinterpret_cast<void*>(aligned + size), tail);
+
+        slab->data = reinterpret_cast<char*>(aligned);
+        if (hugePages != HugePages::off)
+            slab->hugePages = madvise(slab->data, size, MADV_HUGEPAGE) == 0;
+       #else
+        juce::ignoreUnused(hugePages);
+        slab->data = static_cast<char*>(::operator new(size, std::align_val_t(alignment), std::nothrow));
+        if (slab->data == nullptr)
+            return nullptr;
+       #endif
+
+        slab->freeRanges[0] = size;
+        return slab;
+    }
+
+    // Locks a slab into RAM; if the OS refuses, faults its pages in instead. Its free ranges
+    // belong to no block, so only they are written to.
+    static void lockSlab(Slab& slab)
+    {
+        if (slab.locked)
+            return;
+
+        slab.locked = MemoryLock::lock(slab.data, slab.size);
+        slab.lockFailed = !slab.locked;
+        if (slab.lockFailed)
+        {
+            MemoryLock::touch(slab.data, slab.size, false);
+            for (const auto& [offset, size] : slab.freeRanges)
+                MemoryLock::touch(slab.data + offset, size, true);
+        }
+    }
+
+    static void unlockSlab(Slab& slab)
+    {
+        if (slab.locked)
+            MemoryLock::unlock(slab.data, slab.size);
+        slab.locked = slab.lockFailed = false;
+    }
+
+    static void destroySlab(Slab& slab)
+    {
+       #if JUCE_LINUX
+        munmap(slab.data, slab.size);
+       #else
+        ::operator delete(slab.data, std::align_val_t(alignment));
+       #endif
+        slab.data = nullptr;
+    }
+
+    // First fit, oldest slab first, so long-lived preloads settle at the front
+    char* allocate(size_t bytes, Slab*& owner)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (auto& slab : slabs)
+        {
+            if (slab->evacuating)
+                continue;
+
+            for (auto it = slab->freeRanges.begin(); it != slab->freeRanges.end(); ++it)
+            {
+                if (it->second < bytes)
+                    continue;
+
+                const size_t offset = it->first;
+                const size_t remaining = it->second - bytes;
+                slab->freeRanges.erase(it);
+                if (remaining > 0)
+                    slab->freeRanges[offset + bytes] = remaining;
+
+                slab->usedBytes += bytes;
+                ++slab->blocks;
+                owner = slab.get();
+                return slab->data + offset;
+            }
+        }
+
+        // Larger requests get a slab of their own, rounded up to whole huge pages
+        const size_t size = std::max(slabBytes, (bytes + hugePageBytes - 1) / hugePageBytes * hugePageBytes);
+        auto slab = createSlab(size, hugePages);
+        if (slab == nullptr)
+            return nullptr;
+
+        if (lockMemory)
+            lockSlab(*slab);  // Before the block is handed out: the whole slab is still free
+
+        slab->freeRanges.clear();
+        if (size > bytes)
+            slab->freeRanges[bytes] = size - bytes;
+        slab->usedBytes = bytes;
+        slab->blocks = 1;
+        owner = slab.get();
+        slabs.push_back(std::move(slab));
+        return owner->data;
+    }
+
+    void release(Slab* slab, char* data, size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        slab->usedBytes -= bytes;
+        if (--slab->blocks == 0)
+        {
+            destroySlab(*slab);
+            slabs.erase(std::find_if(slabs.begin(), slabs.end(), [slab](const auto& s) { return s.get() == slab; }));
+            return;
+        }
+
+        size_t offset = static_cast<size_t>(data - slab->data);
+        size_t size = bytes;
+
+        // Merge with the free range after, then the one before
+        auto next = slab->freeRanges.lower_bound(offset);
+        if (next != slab->freeRanges.end() && next->first == offset + size)
+        {
+            size += next->second;
+            next = slab->freeRanges.erase(next);
+        }
+        if (next != slab->freeRanges.begin())
+        {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == offset)
+            {
+                offset = previous->first;
+                size += previous->second;
+                slab->freeRanges.erase(previous);
+            }
+        }
+        slab->freeRanges[offset] = size;
+    }
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<Slab>> slabs;  // Oldest first
+    HugePages hugePages = HugePages::off;
+    bool lockMemory = false;
+};
+
+PreloadArena::PreloadArena()
+    : pool(std::make_shared<Pool>())
+{
+}
+
+PreloadArena::~PreloadArena() = default;
+
+void PreloadArena::setHugePages(HugePages mode)
+{
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    pool->hugePages = mode;
+}
+
+PreloadArena::HugePages PreloadArena::getHugePages() const
+{
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    return pool->hugePages;
+}
+
+void PreloadArena::setLockMemory(bool shouldLock)
+{
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    pool->lockMemory = shouldLock;
+    for (auto& slab : pool->slabs)
+    {
+        if (shouldLock)
+            Pool::lockSlab(*slab);
+        else
+            Pool::unlockSlab(*slab);
+    }
+}
+
+bool PreloadArena::getLockMemory() const
+{
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    return pool->lockMemory;
+}
+
+std::shared_ptr<void> PreloadArena::allocate(size_t bytes)
+{
+    bytes = roundUp(std::max<size_t>(bytes, 1));
+
+    Pool::Slab* slab = nullptr;
+    char* data = pool->allocate(bytes, slab);
+    if (data == nullptr)
+        return nullptr;
+
+    // The deleter keeps the pool alive, so blocks may outlive the arena
+    return std::shared_ptr<void>(data, [owner = pool, slab, bytes](void* block)
+    {
+        owner->release(slab, static_cast<char*>(block), bytes);
+    });
+}
+
+int PreloadArena::beginCompaction(float maxOccupancy)
+{
+    std::lock_guard<std::mutex> lock(pool->mutex);
+
+    std::vector<Pool::Slab*> sparse;
+    size_t keptFreeBytes = 0;
+    for (auto& slab : pool->slabs)
+    {
+        slab->evacuating = false;
+        keptFreeBytes += slab->size - slab->usedBytes;
+        if (static_cast<double>(slab->usedBytes) < static_cast<double>(maxOccupancy) * static_cast<double>(slab->size))
+            sparse.push_back(slab.get());
+    }
+
+    // Emptiest first, and only as many as the other slabs have room for: moving blocks
+    // into a brand new slab would just shuffle them
+    std::sort(sparse.begin(), sparse.end(), [](const auto* a, const auto* b) { return a->usedBytes < b->usedBytes; });
+
+    int marked = 0;
+    size_t movingBytes = 0;
+    for (auto* slab : sparse)
+    {
+        const size_t freeBytes = slab->size - slab->usedBytes;
+        if (movingBytes + slab->usedBytes > keptFreeBytes - freeBytes)
+            break;
+
+        slab->evacuating = true;
+        keptFreeBytes -= freeBytes;
+        movingBytes += slab->usedBytes;
+        ++marked;
+    }
+    return marked;
+}
+
+bool PreloadArena::isEvacuating(const void* data) const
+{
+    std::lock_guard<std::mutex> lock(pool->mutex);
+
+    const auto* address = static_cast<const char*>(data);
+    for (const auto& slab : pool->slabs)
+    {
+        if (address >= slab->data && address < slab->data + slab->size)
+            return slab->evacuating;
+    }
+    return false;
+}
+
+PreloadArena::Stats PreloadArena::getStats() const
+{
+    std::lock_guard<std::mutex> lock(pool->mutex);
+
+    Stats stats;
+    for (const auto& slab : pool->slabs)
+    {
+        stats.reservedBytes += static_cast<int64_t>(slab->size);
+        stats.usedBytes += static_cast<int64_t>(slab->usedBytes);
+        stats.blocks += slab->blocks;
+        ++stats.slabs;
+        if (slab->hugePages)
+            ++stats.hugePageSlabs;
+        if (slab->reservedHugePages)
+            ++stats.reservedHugePageSlabs;
+        if (slab->locked)
+            stats.lockedBytes += static_cast<int64_t>(slab->size);
+        if (slab->lockFailed)
+            ++stats.lockFailures;
+
+        for (const auto& [offset, size] : slab->freeRanges)
+            stats.largestFreeBytes = std::max(stats.largestFreeBytes, static_cast<int64_t>(size));
+    }
+
+    stats.freeBytes = stats.reservedBytes - stats.usedBytes;
+    if (stats.freeBytes > 0)
+        stats.fragmentation = 1.0f - static_cast<float>(static_cast<double>(stats.largestFreeBytes) / static_cast<double>(stats.freeBytes));
+    return stats;
+}
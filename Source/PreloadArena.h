@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * PreloadArena hands out preload memory from a few large slabs instead of one heap
+ * allocation per sample, so thousands of preloads don't fragment the heap and a
+ * library's preloads sit next to each other in memory.
+ *
+ * A block goes back to its slab when the last reference to it goes: preloads hold
+ * theirs as dataOwner, so the reclaimer decides when, as for any other preload.
+ * Free ranges merge with their neighbours, and a slab left with no blocks is
+ * returned to the OS.
+ *
+ * Compaction is driven by the engine: beginCompaction() marks the sparsely used
+ * slabs, allocate() stops using them, and the engine copies the preloads living in
+ * them into fresh blocks. Once the old preloads are reclaimed those slabs empty out
+ * and are released.
+ *
+ * Slabs can ask for huge page backing, which saves TLB misses when voices jump
+ * between preloads: transparent huge pages, or pages from the explicitly reserved
+ * pool (vm.nr_hugepages), falling back to transparent ones when the pool is empty.
+ * Both are Linux only; elsewhere the request has no effect.
+ *
+ * Slabs can also be locked into RAM (MemoryLock) so preloads are never paged out.
+ * A slab the OS refuses to lock (RLIMIT_MEMLOCK) is pre-touched instead.
+ *
+ * Thread safe. Not for the audio thread: allocating and releasing take a lock.
+ */
+class PreloadArena
+{
+public:
+    static constexpr size_t slabBytes = 16 * 1024 * 1024;     // A multiple of the huge page size
+    static constexpr size_t hugePageBytes = 2 * 1024 * 1024;
+    static constexpr size_t alignment = 64;                    // Blocks start on a cache line
+
+    enum class HugePages
+    {
+        off,
+        transparent,  // madvise(MADV_HUGEPAGE); the kernel backs what it can
+        reserved      // MAP_HUGETLB from the reserved pool, else transparent
+    };
+
+    struct Stats
+    {
+        int64_t reservedBytes = 0;     // Held in slabs
+        int64_t usedBytes = 0;         // In live blocks
+        int64_t freeBytes = 0;         // In slabs, outside blocks
+        int64_t largestFreeBytes = 0;  // Largest single free range
+        int slabs = 0;
+        int hugePageSlabs = 0;         // Slabs the OS agreed to back with huge pages
+        int reservedHugePageSlabs = 0; // Of those, slabs from the reserved pool
+        int blocks = 0;
+        int64_t lockedBytes = 0;       // In slabs locked into RAM
+        int lockFailures = 0;          // Slabs the OS refused to lock, pre-touched instead
+        float fragmentation = 0.0f;    // Share of the free bytes outside the largest free range
+    };
+
+    PreloadArena();
+    ~PreloadArena();  // Blocks still held keep their slabs alive
+
+    /** Applies to slabs created from now on */
+    void setHugePages(HugePages mode);
+    HugePages getHugePages() const;
+
+    /** Lock every slab into RAM, now and as they are created (or unlock them) */
+    void setLockMemory(bool shouldLock);
+    bool getLockMemory() const;
+
+    /** A block of at least `bytes`, aligned to `alignment`; nullptr if the OS is out of memory */
+    std::shared_ptr<void> allocate(size_t bytes);
+
+    /** Marks slabs whose blocks fill less than maxOccupancy of them, emptiest first, as long as
+        the other slabs have room for their blocks; allocate() avoids them until the next call.
+        Returns how many were marked. */
+    int beginCompaction(float maxOccupancy = 0.5f);
+
+    /** True if data lies in a slab marked by the last beginCompaction() */
+    bool isEvacuating(const void* data) const;
+
+    Stats getStats() const;
+
+    static size_t roundUp(size_t bytes) { return (bytes + alignment - 1) & ~(alignment - 1); }
+
+private:
+    struct Pool;
+    std::shared_ptr<Pool> pool;
+
+    PreloadArena(const PreloadArena&) = delete;
+    PreloadArena& operator=(const PreloadArena&) = delete;
+};
@@ -0,0 +1,96 @@
+#include "PreloadBudget.h"
+#include <algorithm>
+#include <cmath>
+
+PreloadBudget::Result PreloadBudget::allocate(const std::vector<Request>& requests, int64_t budgetBytes)
+{
+    Result result;
+    result.frames.resize(requests.size(), 0);
+    budgetBytes = std::max<int64_t>(0, budgetBytes);
+
+    int64_t floorBytes = 0;
+    for (const auto& request : requests)
+        floorBytes += static_cast<int64_t>(request.minFrames) * request.bytesPerFrame;
+
+    // Not even the floors fit: shrink them all by the same factor
+    if (floorBytes > budgetBytes)
+    {
+        const double scale = static_cast<double>(budgetBytes) / static_cast<double>(floorBytes);
+        for (size_t i = 0; i < requests.size(); ++i)
+        {
+            result.frames[i] = static_cast<int>(std::floor(requests[i].minFrames * scale));
+            result.allocatedBytes += static_cast<int64_t>(result.frames[i]) * requests[i].bytesPerFrame;
+        }
+        result.floorsFit = false;
+        return result;
+    }
+
+    std::vector<size_t> open;  // Still below their cap
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        result.frames[i] = requests[i].minFrames;
+        if (requests[i].maxFrames > requests[i].minFrames && requests[i].weight > 0.0 && requests[i].bytesPerFrame > 0)
+            open.push_back(i);
+    }
+
+    // Water filling: hand out the rest by weight; a sample whose share would pass its cap
+    // takes just the cap, and the next round shares what it left among the others
+    int64_t remaining = budgetBytes - floorBytes;
+    while (remaining > 0 && !open.empty())
+    {
+        double totalWeight = 0.0;
+        for (size_t i : open)
+            totalWeight += requests[i].weight;
+
+        std::vector<size_t> stillOpen;
+        int64_t capped = 0;
+        for (size_t i : open)
+        {
+            const auto& request = requests[i];
+            const double share = static_cast<double>(remaining) * request.weight / totalWeight;
+            const int64_t headroom = static_cast<int64_t>(request.maxFrames - result.frames[i]) * request.bytesPerFrame;
+            if (share >= static_cast<double>(headroom))
+            {
+                result.frames[i] = request.maxFrames;
+                capped += headroom;
+            }
+            else
+            {
+                stillOpen.push_back(i);
+            }
+        }
+
+        if (capped > 0)
+        {
+            remaining -= capped;
+            open = std::move(stillOpen);
+            continue;
+        }
+
+        // Nobody reaches a cap: everyone takes their share
+        for (size_t i : open)
+        {
+            const auto& request = requests[i];
+            const double share = static_cast<double>(remaining) * request.weight / totalWeight;
+            result.frames[i] += static_cast<int>(share / request.bytesPerFrame);
+        }
+        break;
+    }
+
+    for (size_t i = 0; i < requests.size(); ++i)
+        result.allocatedBytes += static_cast<int64_t>(result.frames[i]) * requests[i].bytesPerFrame;
+
+    return result;
+}
+
+double PreloadBudget::weightFor(int bytesPerFrame, double playbackRate, uint32_t plays, uint32_t underruns)
+{
+    // Each play adds less than the one before, so a few hot notes can't take everything
+    const double usage = 1.0 + std::log2(1.0 + static_cast<double>(plays));
+
+    // Underruns say the preload ran out before the disk caught up; up to 5x the time
+    constexpr uint32_t maxCountedUnderruns = 8;
+    const double risk = 1.0 + 0.5 * static_cast<double>(std::min(underruns, maxCountedUnderruns));
+
+    return static_cast<double>(bytesPerFrame) * std::max(playbackRate, 0.0) * usage * risk;
+}
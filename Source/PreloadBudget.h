@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * PreloadBudget splits a RAM budget between the preloads of a library's samples.
+ *
+ * Every sample first gets its floor (the smallest preload that still covers the
+ * disk thread's first read, or the whole sample if shorter). The rest of the
+ * budget goes out in proportion to each sample's weight, and no sample gets more
+ * than its cap (the whole sample, or the largest preload size), so what short
+ * samples can't use flows on to the others.
+ *
+ * weightFor() makes a weight "bytes of preload per second of playback" times how
+ * much the sample matters, so samples that matter equally get equal time before
+ * the disk has to keep up: stereo and faster-playing samples get more frames,
+ * often played samples and samples that underran get more time.
+ *
+ * The budget is a hard limit: if the floors alone don't fit, they are scaled
+ * down together. Pure computation, safe on any thread.
+ */
+class PreloadBudget
+{
+public:
+    struct Request
+    {
+        int minFrames = 0;      // Floor
+        int maxFrames = 0;      // Cap (>= minFrames)
+        int bytesPerFrame = 0;  // Channels x sizeof(float)
+        double weight = 1.0;    // Share of what is left after the floors
+    };
+
+    struct Result
+    {
+        std::vector<int> frames;     // Per request
+        int64_t allocatedBytes = 0;
+        bool floorsFit = true;       // False if the floors were scaled down to fit
+    };
+
+    static Result allocate(const std::vector<Request>& requests, int64_t budgetBytes);
+
+    /** Weight of a sample read at up to playbackRate source frames per output frame,
+        played `plays` times this session, with `underruns` underruns while streaming */
+    static double weightFor(int bytesPerFrame, double playbackRate, uint32_t plays, uint32_t underruns);
+};
@@ -0,0 +1,115 @@
+#include "PreloadProfile.h"
+
+namespace
+{
+    constexpr int profileMagic = 0x50505348;  // "HSPP"
+}
+
+PreloadProfile::PreloadProfile(const juce::File& folder, const juce::File& profileDirectory)
+    : libraryFolder(folder)
+{
+    const juce::File directory = profileDirectory == juce::File() ? getDefaultProfileDirectory() : profileDirectory;
+    const juce::String key = juce::String::toHexString(static_cast<juce::int64>(folder.getFullPathName().hashCode64()));
+    profileFile = directory.getChildFile(key + ".profile");
+}
+
+juce::File PreloadProfile::getDefaultProfileDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("Hammer Sampler")
+        .getChildFile("PreloadProfiles");
+}
+
+bool PreloadProfile::load()
+{
+    scales.clear();
+
+    juce::MemoryBlock data;
+    if (!profileFile.existsAsFile() || !profileFile.loadFileAsData(data))
+        return false;
+
+    juce::MemoryInputStream in(data, false);
+    if (in.readInt() != profileMagic || in.readInt() != formatVersion)
+        return false;
+
+    // Guards against two folders whose paths hash the same
+    if (in.readString() != libraryFolder.getFullPathName())
+        return false;
+
+    const int numEntries = in.readInt();
+    if (numEntries < 0)
+        return false;
+
+    std::map<juce::String, float> loaded;
+    for (int i = 0; i < numEntries; ++i)
+    {
+        const juce::String relativePath = in.readString();
+        const float scale = in.readFloat();
+        if (in.isExhausted())
+            return false;
+
+        loaded[relativePath] = juce::jlimit(minScale, maxScale, scale);
+    }
+
+    if (in.readInt() != profileMagic || !in.isExhausted())
+        return false;
+
+    scales = std::move(loaded);
+    return true;
+}
+
+bool PreloadProfile::save() const
+{
+    if (scales.empty())
+        return !profileFile.existsAsFile() || profileFile.deleteFile();
+
+    juce::MemoryOutputStream out;
+    out.writeInt(profileMagic);
+    out.writeInt(formatVersion);
+    out.writeString(libraryFolder.getFullPathName());
+    out.writeInt(static_cast<int>(scales.size()));
+
+    for (const auto& [relativePath, scale] : scales)
+    {
+        out.writeString(relativePath);
+        out.writeFloat(scale);
+    }
+
+    out.writeInt(profileMagic);
+
+    if (!profileFile.getParentDirectory().createDirectory())
+        return false;
+
+    return profileFile.replaceWithData(out.getData(), out.getDataSize());
+}
+
+float PreloadProfile::getScale(const juce::File& file) const
+{
+    auto it = scales.find(file.getRelativePathFrom(libraryFolder));
+    return it != scales.end() ? it->second : 1.0f;
+}
+
+void PreloadProfile::setScale(const juce::File& file, float scale)
+{
+    const juce::String relativePath = file.getRelativePathFrom(libraryFolder);
+    scale = juce::jlimit(minScale, maxScale, scale);
+    if (scale == 1.0f)
+        scales.erase(relativePath);
+    else
+        scales[relativePath] = scale;
+}
+
+float PreloadProfile::nextScale(float scale, bool underran, float refillLag)
+{
+    // The preload ran out before the disk caught up: twice the room next time
+    if (underran)
+        scale *= 2.0f;
+    // Under a quarter of the preload was left when the first refill arrived
+    else if (refillLag > 0.75f)
+        scale *= 1.25f;
+    // Over three quarters were left: give a little back, slowly
+    else if (refillLag >= 0.0f && refillLag < 0.25f)
+        scale *= 0.9f;
+
+    return juce::jlimit(minScale, maxScale, scale);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cstdint>
+#include <map>
+
+/**
+ * PreloadProfile remembers how large each sample's preload turned out to need,
+ * so adaptive preload sizing doesn't start over every time a library opens.
+ *
+ * A scale of 1 is the preload the sample would get anyway (preloadSizeKB, or its
+ * share of the RAM budget); 2 asks for twice that. nextScale() learns it from how
+ * each play went: an underrun doubles it, a disk refill that arrived with little of
+ * the preload left grows it, and one that arrived with most of it unused shrinks it.
+ *
+ * One small binary file per library folder lives next to the index caches in the
+ * user's application data folder, keyed by path relative to the library. Samples
+ * at scale 1 aren't stored.
+ *
+ * Not thread safe.
+ */
+class PreloadProfile
+{
+public:
+    static constexpr int formatVersion = 1;
+    static constexpr float minScale = 0.25f;
+    static constexpr float maxScale = 8.0f;
+
+    /** An empty profile directory means getDefaultProfileDirectory() */
+    explicit PreloadProfile(const juce::File& libraryFolder, const juce::File& profileDirectory = {});
+
+    /** Read the profile from disk. Returns false (leaving it empty) if it is missing or invalid. */
+    bool load();
+
+    /** Write the profile to disk, replacing any previous one (an empty profile deletes it) */
+    bool save() const;
+
+    /** A file's learned scale, 1 if it has none */
+    float getScale(const juce::File& file) const;
+    void setScale(const juce::File& file, float scale);  // Kept within minScale..maxScale
+
+    const std::map<juce::String, float>& getScales() const { return scales; }
+    juce::File getProfileFile() const { return profileFile; }
+
+    static juce::File getDefaultProfileDirectory();
+
+    /** The scale after one adaptation interval. refillLag is the largest share of its preload
+        any voice of the sample played before the disk's first refill arrived (-1 = none streamed). */
+    static float nextScale(float scale, bool underran, float refillLag);
+
+private:
+    juce::File libraryFolder;
+    juce::File profileFile;
+
+    std::map<juce::String, float> scales;  // By path relative to the library
+};
@@ -0,0 +1,289 @@
+#include "PreloadSnapshot.h"
+#include "LibraryScanner.h"
+#include <algorithm>
+
+namespace
+{
+    constexpr int snapshotMagic = 0x53505348;  // "HSPS"
+
+    int64_t alignUp(int64_t value, int64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+PreloadSnapshot::PreloadSnapshot(const juce::File& folder, const Config& snapshotConfig, const juce::File& snapshotDirectory)
+    : libraryFolder(folder), config(snapshotConfig)
+{
+    const juce::File directory = snapshotDirectory == juce::File() ? getDefaultDirectory() : snapshotDirectory;
+    libraryKey = juce::String::toHexString(static_cast<juce::int64>(folder.getFullPathName().hashCode64()));
+    snapshotFile = directory.getChildFile(libraryKey + "_" + juce::String(config.preloadSizeKB) + "k_" +
+                                          (config.budgetMB > 0 ? juce::String(config.budgetMB) + "mb_" : juce::String()) +
+                                          juce::String(config.velocityLayerLimit) + "v_" +
+                                          juce::String(config.roundRobinLimit) + "rr" +
+                                          (config.compactPreloads ? "_c" : "") + ".snap");
+}
+
+juce::File PreloadSnapshot::getDefaultDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("Hammer Sampler")
+        .getChildFile("PreloadSnapshots");
+}
+
+int64_t PreloadSnapshot::channelStride(int numFrames)
+{
+    return alignUp(static_cast<int64_t>(numFrames) * static_cast<int64_t>(sizeof(float)), dataAlignment);
+}
+
+int64_t PreloadSnapshot::dataBytes(const Entry& entry)
+{
+    if (entry.compactBits != 0)
+        return alignUp(static_cast<int64_t>(entry.numFrames) * entry.numChannels * (entry.compactBits / 8), dataAlignment);
+
+    return static_cast<int64_t>(entry.numChannels) * channelStride(entry.numFrames);
+}
+
+bool PreloadSnapshot::open()
+{
+    mapping.reset();
+    entries.clear();
+
+    if (!snapshotFile.existsAsFile())
+        return false;
+
+    auto mapped = std::make_shared<juce::MemoryMappedFile>(snapshotFile, juce::MemoryMappedFile::readOnly);
+    if (mapped->getData() == nullptr)
+        return false;
+
+    const auto fileSize = static_cast<int64_t>(mapped->getSize());
+    juce::MemoryInputStream in(mapped->getData(), mapped->getSize(), false);
+
+    if (in.readInt() != snapshotMagic || in.readInt() != formatVersion)
+        return false;
+
+    if (in.readInt() != config.preloadSizeKB || in.readInt() != config.budgetMB ||
+        in.readInt() != config.velocityLayerLimit || in.readInt() != config.roundRobinLimit ||
+        in.readBool() != config.compactPreloads)
+        return false;
+
+    // Guards against two folders whose paths hash the same
+    if (in.readString() != libraryFolder.getFullPathName())
+        return false;
+
+    const int numEntries = in.readInt();
+    if (numEntries < 0)
+        return false;
+
+    std::map<juce::String, Entry> loaded;
+
+    for (int i = 0; i < numEntries; ++i)
+    {
+        const juce::String relativePath = in.readString();
+        Entry entry;
+        entry.fileSize = in.readInt64();
+        entry.modificationTime = in.readInt64();
+        entry.totalFrames = in.readInt64();
+        entry.fileStartFrame = in.readInt64();
+        entry.numChannels = in.readInt();
+        entry.numFrames = in.readInt();
+        entry.compactBits = in.readInt();
+        entry.dataOffset = in.readInt64();
+
+        // A truncated index reads as zeros; reject it rather than trust half a snapshot
+        if (in.isExhausted())
+            return false;
+
+        // Never hand out a pointer past the end of the mapping
+        if (entry.numChannels <= 0 || entry.numFrames < 0 || entry.dataOffset < in.getPosition() ||
+            (entry.compactBits != 0 && entry.compactBits != 16 && entry.compactBits != 24) ||
+            entry.dataOffset % dataAlignment != 0 || entry.dataOffset + dataBytes(entry) > fileSize)
+            return false;
+
+        loaded[relativePath] = entry;
+    }
+
+    if (in.readInt() != snapshotMagic)
+        return false;
+
+    entries = std::move(loaded);
+    mapping = std::move(mapped);
+    return true;
+}
+
+std::unique_ptr<PreloadedSample> PreloadSnapshot::createPreload(const PreloadedSample& info, int numFrames) const
+{
+    if (mapping == nullptr)
+        return nullptr;
+
+    const juce::File file(info.path.getFile());
+    auto it = entries.find(file.getRelativePathFrom(libraryFolder));
+    if (it == entries.end())
+        return nullptr;
+
+    const Entry& entry = it->second;
+    if (entry.fileSize != file.getSize() || entry.modificationTime != file.getLastModificationTime().toMilliseconds())
+        return nullptr;
+
+    if (entry.numChannels != info.numChannels || entry.totalFrames != info.totalSampleFrames ||
+        entry.fileStartFrame != info.fileStartFrame ||
+        entry.numFrames != (numFrames >= 0 ? static_cast<int>(std::min<int64_t>(numFrames, info.totalSampleFrames))
+                                           : LibraryScanner::getPreloadSizeFrames(info, config.preloadSizeKB)))
+        return nullptr;
+
+    // Float files stay float even in a compact snapshot
+    if (entry.compactBits != (config.compactPreloads ? info.integerBits : 0))
+        return nullptr;
+
+    // The mapping is read only; voices and the disk thread only ever read a preload
+    auto* data = static_cast<char*>(mapping->getData()) + entry.dataOffset;
+    auto preload = LibraryScanner::makePreload(info);
+    if (entry.compactBits != 0)
+    {
+        preload->compactBits = entry.compactBits;
+        preload->compactData = data;
+        preload->compactFrames = entry.numFrames;
+    }
+    else
+    {
+        std::vector<float*> channels;
+        for (int channel = 0; channel < entry.numChannels; ++channel)
+            channels.push_back(reinterpret_cast<float*>(data + channel * channelStride(entry.numFrames)));
+
+        preload->preloadBuffer.setDataToReferTo(channels.data(), entry.numChannels, entry.numFrames);
+    }
+    preload->preloadSizeFrames = entry.numFrames;
+    preload->dataOwner = mapping;
+    preload->mapped = true;
+    return preload;
+}
+
+bool PreloadSnapshot::write(const std::vector<const PreloadedSample*>& preloads,
+                            const std::function<bool()>& shouldCancel) const
+{
+    struct Record
+    {
+        juce::String relativePath;
+        Entry entry;
+        const PreloadedSample* preload = nullptr;
+    };
+
+    std::vector<Record> records;
+    records.reserve(preloads.size());
+    for (const auto* preload : preloads)
+    {
+        if (preload == nullptr || preload->numChannels <= 0)
+            continue;
+
+        const juce::File file(preload->path.getFile());
+        Record record;
+        record.relativePath = file.getRelativePathFrom(libraryFolder);
+        record.entry.fileSize = file.getSize();
+        record.entry.modificationTime = file.getLastModificationTime().toMilliseconds();
+        record.entry.totalFrames = preload->totalSampleFrames;
+        record.entry.fileStartFrame = preload->fileStartFrame;
+        record.entry.numChannels = preload->numChannels;
+        record.entry.numFrames = preload->getPreloadCapacity();
+        record.entry.compactBits = preload->compactBits;
+        record.preload = preload;
+        records.push_back(std::move(record));
+    }
+
+    auto writeIndex = [&](juce::OutputStream& out)
+    {
+        out.writeInt(snapshotMagic);
+        out.writeInt(formatVersion);
+        out.writeInt(config.preloadSizeKB);
+        out.writeInt(config.budgetMB);
+        out.writeInt(config.velocityLayerLimit);
+        out.writeInt(config.roundRobinLimit);
+        out.writeBool(config.compactPreloads);
+        out.writeString(libraryFolder.getFullPathName());
+        out.writeInt(static_cast<int>(records.size()));
+
+        for (const auto& record : records)
+        {
+            out.writeString(record.relativePath);
+            out.writeInt64(record.entry.fileSize);
+            out.writeInt64(record.entry.modificationTime);
+            out.writeInt64(record.entry.totalFrames);
+            out.writeInt64(record.entry.fileStartFrame);
+            out.writeInt(record.entry.numChannels);
+            out.writeInt(record.entry.numFrames);
+            out.writeInt(record.entry.compactBits);
+            out.writeInt64(record.entry.dataOffset);
+        }
+
+        out.writeInt(snapshotMagic);
+    };
+
+    // Every index field has a fixed size, so the offsets can be laid out before they are known
+    juce::MemoryOutputStream sizing;
+    writeIndex(sizing);
+    int64_t offset = alignUp(static_cast<int64_t>(sizing.getDataSize()), indexAlignment);
+    for (auto& record : records)
+    {
+        record.entry.dataOffset = offset;
+        offset += dataBytes(record.entry);
+    }
+
+    juce::MemoryOutputStream index;
+    writeIndex(index);
+
+    if (!snapshotFile.getParentDirectory().createDirectory())
+        return false;
+
+    // Written aside and renamed into place: instances that mapped the old file keep it intact
+    juce::TemporaryFile temporary(snapshotFile);
+    {
+        auto out = temporary.getFile().createOutputStream();
+        if (out == nullptr)
+            return false;
+
+        int64_t position = static_cast<int64_t>(index.getDataSize());
+        bool ok = out->write(index.getData(), index.getDataSize());
+
+        for (const auto& record : records)
+        {
+            if (!ok || (shouldCancel && shouldCancel()))
+                return false;
+
+            ok = out->writeRepeatedByte(0, static_cast<size_t>(record.entry.dataOffset - position));
+            position = record.entry.dataOffset;
+
+            if (record.entry.compactBits != 0)
+            {
+                const auto bytes = static_cast<size_t>(record.preload->getPreloadBytes());
+                ok = out->write(record.preload->compactData, bytes)
+                  && out->writeRepeatedByte(0, static_cast<size_t>(dataBytes(record.entry)) - bytes);
+                position += dataBytes(record.entry);
+                continue;
+            }
+
+            const int64_t stride = channelStride(record.entry.numFrames);
+            const auto channelBytes = static_cast<size_t>(record.entry.numFrames) * sizeof(float);
+            for (int channel = 0; channel < record.entry.numChannels && ok; ++channel)
+            {
+                ok = out->write(record.preload->preloadBuffer.getReadPointer(channel), channelBytes)
+                  && out->writeRepeatedByte(0, static_cast<size_t>(stride) - channelBytes);
+                position += stride;
+            }
+        }
+
+        out->flush();
+        if (!ok)
+            return false;
+    }
+
+    if (!temporary.overwriteTargetFileWithTemporary())
+        return false;
+
+    // One snapshot per library: drop the ones for other configurations
+    for (const auto& file : snapshotFile.getParentDirectory().findChildFiles(juce::File::findFiles, false, libraryKey + "_*.snap"))
+    {
+        if (file != snapshotFile)
+            file.deleteFile();
+    }
+
+    return true;
+}
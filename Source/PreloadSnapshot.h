@@ -0,0 +1,107 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+#include "DiskStreaming.h"
+
+/**
+ * PreloadSnapshot stores a library's preloads in one file, already decoded to
+ * float PCM (or kept as 16/24-bit integers for compact preloads), so the next
+ * load maps the file instead of reading every sample.
+ *
+ * Mapped preloads are usable the moment the file is opened, and the pages are
+ * shared through the OS page cache between plugin instances and across DAW
+ * restarts. Each preload keeps the mapping alive (PreloadedSample::dataOwner),
+ * so the snapshot can be replaced on disk while voices still play from it.
+ *
+ * One snapshot per library and configuration (preload size, format and limits), in the
+ * user's application data folder; writing one removes the library's snapshots
+ * for other configurations. With a RAM budget, each sample's size is whatever the
+ * budget gave it; entries of another size are not used. Entries are keyed like the index cache: path relative
+ * to the library, trusted only while the file's size and modification time match.
+ *
+ * Layout: an index (magic, version, configuration, folder, one record per sample,
+ * trailing magic), padded to a page boundary, then per sample each channel's
+ * frames as native-endian floats, padded to dataAlignment bytes (compact preloads:
+ * their interleaved integer frames, padded the same way). The file is a
+ * machine-local cache and is never moved between machines.
+ *
+ * Not thread safe; open it on one thread, then use its preloads anywhere.
+ */
+class PreloadSnapshot
+{
+public:
+    struct Config
+    {
+        int preloadSizeKB = 64;
+        int budgetMB = 0;  // Preload RAM budget the sizes came from (0 = preloadSizeKB for all)
+        int velocityLayerLimit = 1;
+        int roundRobinLimit = 1;
+        bool compactPreloads = false;  // Integer files' preloads are stored compact
+
+        bool operator==(const Config& other) const
+        {
+            return preloadSizeKB == other.preloadSizeKB
+                && budgetMB == other.budgetMB
+                && velocityLayerLimit == other.velocityLayerLimit
+                && roundRobinLimit == other.roundRobinLimit
+                && compactPreloads == other.compactPreloads;
+        }
+        bool operator!=(const Config& other) const { return !(*this == other); }
+    };
+
+    static constexpr int formatVersion = 4;
+    static constexpr int64_t dataAlignment = 64;    // Each channel starts on a cache line
+    static constexpr int64_t indexAlignment = 4096; // Sample data starts on a page
+
+    /** An empty directory means getDefaultDirectory() */
+    PreloadSnapshot(const juce::File& libraryFolder, const Config& config, const juce::File& snapshotDirectory = {});
+
+    /** Map the snapshot. Returns false if there is none for this configuration or it is invalid. */
+    bool open();
+    bool isOpen() const { return mapping != nullptr; }
+    int getNumEntries() const { return static_cast<int>(entries.size()); }
+
+    /** A preload with info's metadata whose buffer points into the mapping, or nullptr if the
+        snapshot has no entry for the file, the file changed since it was written, or the entry
+        isn't numFrames long (-1 = the configuration's preload size). Compact entries give
+        compact preloads. */
+    std::unique_ptr<PreloadedSample> createPreload(const PreloadedSample& info, int numFrames = -1) const;
+
+    /** Write these preloads as the library's snapshot, replacing it for any configuration.
+        shouldCancel is polled between samples; a cancelled or failed write leaves no file. */
+    bool write(const std::vector<const PreloadedSample*>& preloads,
+               const std::function<bool()>& shouldCancel = nullptr) const;
+
+    juce::File getSnapshotFile() const { return snapshotFile; }
+
+    static juce::File getDefaultDirectory();
+
+private:
+    struct Entry
+    {
+        int64_t fileSize = 0;
+        int64_t modificationTime = 0;  // Milliseconds since the epoch
+        int64_t totalFrames = 0;
+        int64_t fileStartFrame = 0;    // Where the preload starts in the file (trimmed silence)
+        int numChannels = 0;
+        int numFrames = 0;             // Preloaded frames per channel
+        int compactBits = 0;           // 16 or 24 for compact (interleaved integer) data, else 0
+        int64_t dataOffset = 0;        // Byte offset of the first channel in the file
+    };
+
+    static int64_t channelStride(int numFrames);
+    static int64_t dataBytes(const Entry& entry);
+
+    juce::File libraryFolder;
+    Config config;
+    juce::File snapshotFile;
+    juce::String libraryKey;  // File name prefix shared by all of the library's snapshots
+
+    std::shared_ptr<juce::MemoryMappedFile> mapping;
+    std::map<juce::String, Entry> entries;  // By path relative to the library
+};
@@ -0,0 +1,50 @@
+#include "PreloadWorker.h"
+
+PreloadWorker::PreloadWorker(std::function<void()> jobToRun, std::function<void()> housekeepingToRun,
+                             const juce::String& threadName)
+    : juce::Thread(threadName),
+      job(std::move(jobToRun)),
+      housekeeping(std::move(housekeepingToRun))
+{
+}
+
+PreloadWorker::~PreloadWorker()
+{
+    stopThread();
+}
+
+void PreloadWorker::startThread()
+{
+    juce::Thread::startThread();
+}
+
+void PreloadWorker::stopThread()
+{
+    signalThreadShouldExit();
+    notify();  // Wake up the thread if it's waiting
+    juce::Thread::stopThread(5000);
+}
+
+void PreloadWorker::requestWork()
+{
+    workRequested.store(true, std::memory_order_release);
+    notify();
+}
+
+void PreloadWorker::run()
+{
+    while (!threadShouldExit())
+    {
+        // Mark busy before taking the request, so isBusy() never blinks false in between
+        busy.store(true, std::memory_order_release);
+        if (workRequested.exchange(false, std::memory_order_acq_rel) && job)
+            job();
+        busy.store(false, std::memory_order_release);
+
+        if (housekeeping)
+            housekeeping();
+
+        if (!hasPendingRequest())
+            wait(housekeepingIntervalMs);
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <functional>
+
+/**
+ * PreloadWorker runs preload jobs (loading and freeing preload buffers) on a
+ * background thread, so the message thread never waits for disk.
+ *
+ * - requestWork() coalesces: however often it is called, the job runs once more
+ *   after the latest request. A running job polls hasPendingRequest() and returns
+ *   early when its settings are already stale.
+ * - Between jobs, the housekeeping callback runs every housekeepingIntervalMs
+ *   (the engine frees retired preloads there).
+ *
+ * The engine also runs library loads on one, so a newer folder choice cancels
+ * the load in progress instead of waiting for it.
+ */
+class PreloadWorker : public juce::Thread
+{
+public:
+    static constexpr int housekeepingIntervalMs = 100;
+
+    PreloadWorker(std::function<void()> job, std::function<void()> housekeeping,
+                  const juce::String& threadName = "PreloadWorker");
+    ~PreloadWorker() override;
+
+    void startThread();
+    void stopThread();
+
+    /** Run the job (again) as soon as possible */
+    void requestWork();
+
+    /** True if a newer request arrived while the job is running */
+    bool hasPendingRequest() const { return workRequested.load(std::memory_order_acquire); }
+
+    /** True while the job is queued or running */
+    bool isBusy() const { return busy.load(std::memory_order_acquire) || hasPendingRequest(); }
+
+private:
+    void run() override;
+
+    std::function<void()> job;
+    std::function<void()> housekeeping;
+
+    std::atomic<bool> workRequested{false};
+    std::atomic<bool> busy{false};
+
+    JUCE_DECLARE_NON_COPYABLE(PreloadWorker)
+};
@@ -0,0 +1,106 @@
+#include "SampleLookupTable.h"
+#include <algorithm>
+
+void SampleLookupTable::clear()
+{
+    resolvedNote.fill(-1);
+    for (auto& row : velocityToLayer)
+        row.fill(-1);
+
+    layerStride = 0;
+    rrStride = 0;
+    sampleIndex.clear();
+    fallbackIndex.clear();
+}
+
+void SampleLookupTable::build(const std::array<NoteLayout, 128>& notes, const std::vector<SampleKey>& samples, int velocityLayerLimit)
+{
+    clear();
+
+    // Table dimensions come from the data, so typical libraries stay small (128 x 8 x 16)
+    for (const auto& layout : notes)
+        layerStride = std::max(layerStride, layout.numVelocityLayers);
+    for (const auto& key : samples)
+        rrStride = std::max(rrStride, key.roundRobin);
+
+    if (layerStride == 0 || rrStride == 0)
+        return;
+
+    // Resolve fallbacks and precompute the limited velocity -> layer mapping per note
+    for (int note = 0; note < 128; ++note)
+    {
+        const auto& layout = notes[static_cast<size_t>(note)];
+        if (!layout.isMapped)
+            continue;
+
+        const int actualNote = (layout.fallbackNote >= 0) ? layout.fallbackNote : note;
+        const int totalLayers = notes[static_cast<size_t>(actualNote)].numVelocityLayers;
+        if (totalLayers == 0)
+            continue;
+
+        resolvedNote[static_cast<size_t>(note)] = actualNote;
+
+        // Use the first N layers and spread velocity 1-127 evenly across them
+        const int effectiveLayers = std::min(std::max(1, velocityLayerLimit), totalLayers);
+        auto& row = velocityToLayer[static_cast<size_t>(note)];
+        for (int velocity = 0; velocity < 128; ++velocity)
+        {
+            int layerIndex = ((velocity - 1) * effectiveLayers) / 127;
+            row[static_cast<size_t>(velocity)] = static_cast<int8_t>(std::clamp(layerIndex, 0, effectiveLayers - 1));
+        }
+    }
+
+    const size_t noteLayers = static_cast<size_t>(128 * layerStride);
+    sampleIndex.assign(noteLayers * static_cast<size_t>(rrStride), -1);
+    fallbackIndex.assign(noteLayers, -1);
+
+    // First matching sample wins, so duplicate (note, layer, rr) entries resolve
+    // to the same sample the old linear scan returned
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        const auto& key = samples[i];
+        if (key.midiNote < 0 || key.midiNote > 127 || key.velocityLayerIndex < 0 ||
+            key.velocityLayerIndex >= layerStride || key.roundRobin < 1)
+            continue;
+
+        const size_t noteLayer = static_cast<size_t>(key.midiNote * layerStride + key.velocityLayerIndex);
+        auto& exact = sampleIndex[noteLayer * static_cast<size_t>(rrStride) + static_cast<size_t>(key.roundRobin - 1)];
+        if (exact < 0)
+            exact = static_cast<int>(i);
+
+        if (fallbackIndex[noteLayer] < 0)
+            fallbackIndex[noteLayer] = static_cast<int>(i);
+    }
+
+    // Layers with nothing playable yet (still loading, or missing) borrow from the
+    // nearest playable layer of the same note, the softer one on a tie
+    std::vector<int> ownFallback(static_cast<size_t>(layerStride));
+    for (int note = 0; note < 128; ++note)
+    {
+        const size_t noteStart = static_cast<size_t>(note * layerStride);
+        std::copy_n(fallbackIndex.begin() + static_cast<std::ptrdiff_t>(noteStart), layerStride, ownFallback.begin());
+
+        for (int layer = 0; layer < layerStride; ++layer)
+        {
+            if (ownFallback[static_cast<size_t>(layer)] >= 0)
+                continue;
+
+            for (int distance = 1; distance < layerStride; ++distance)
+            {
+                const int softer = layer - distance;
+                const int louder = layer + distance;
+                int borrowed = -1;
+                if (softer >= 0)
+                    borrowed = ownFallback[static_cast<size_t>(softer)];
+                if (borrowed < 0 && louder < layerStride)
+                    borrowed = ownFallback[static_cast<size_t>(louder)];
+
+                if (borrowed >= 0)
+                {
+                    fallbackIndex[noteStart + static_cast<size_t>(layer)] = borrowed;
+                    break;
+                }
+            }
+        }
+    }
+}
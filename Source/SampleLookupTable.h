@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * SampleLookupTable resolves a (note, velocity, round-robin) request to a sample
+ * index with a few array loads, so note-on never scans the sample list.
+ *
+ * The table is rebuilt off the audio thread whenever the note mappings, the
+ * velocity layer limit or the set of preloaded samples change:
+ * - resolvedNote[note]              : note after applying the fallback mapping (-1 = none)
+ * - velocityToLayer[note][velocity] : limited velocity layer index (-1 = no layers)
+ * - sampleIndex[note][layer][rr]    : exact match (-1 = missing or not preloaded)
+ * - fallbackIndex[note][layer]      : first playable sample of the layer, used when
+ *                                     the requested round-robin is missing. A layer with
+ *                                     nothing playable uses the nearest playable layer's,
+ *                                     so a partly loaded library still sounds everywhere.
+ */
+class SampleLookupTable
+{
+public:
+    /** Per-note layout, taken from the note mappings */
+    struct NoteLayout
+    {
+        int numVelocityLayers = 0;  // Layers this note has its own samples for
+        int fallbackNote = -1;      // Note to borrow samples from (-1 = none)
+        bool isMapped = false;      // False if the note has neither samples nor a fallback
+    };
+
+    /** One entry per sample, in sample order. velocityLayerIndex < 0 marks it unplayable. */
+    struct SampleKey
+    {
+        int midiNote = 0;
+        int velocityLayerIndex = -1;
+        int roundRobin = 0;
+    };
+
+    SampleLookupTable() { clear(); }
+
+    void build(const std::array<NoteLayout, 128>& notes, const std::vector<SampleKey>& samples, int velocityLayerLimit);
+    void clear();
+
+    /** Returns the sample index for a request, or -1 if nothing playable matches */
+    int find(int midiNote, int velocity, int roundRobin) const
+    {
+        if (midiNote < 0 || midiNote > 127)
+            return -1;
+
+        const int actualNote = resolvedNote[static_cast<size_t>(midiNote)];
+        if (actualNote < 0)
+            return -1;
+
+        const int layer = getVelocityLayerIndex(midiNote, velocity);
+        if (layer < 0)
+            return -1;
+
+        const size_t noteLayer = static_cast<size_t>(actualNote * layerStride + layer);
+        if (roundRobin >= 1 && roundRobin <= rrStride)
+        {
+            const int exact = sampleIndex[noteLayer * static_cast<size_t>(rrStride) + static_cast<size_t>(roundRobin - 1)];
+            if (exact >= 0)
+                return exact;
+        }
+
+        return fallbackIndex[noteLayer];
+    }
+
+    /** Limited velocity layer index for a note (after fallback), or -1 */
+    int getVelocityLayerIndex(int midiNote, int velocity) const
+    {
+        if (midiNote < 0 || midiNote > 127)
+            return -1;
+
+        const int clampedVelocity = velocity < 0 ? 0 : (velocity > 127 ? 127 : velocity);
+        return velocityToLayer[static_cast<size_t>(midiNote)][static_cast<size_t>(clampedVelocity)];
+    }
+
+    /** Note whose samples are used for midiNote (after fallback), or -1 */
+    int getResolvedNote(int midiNote) const
+    {
+        if (midiNote < 0 || midiNote > 127)
+            return -1;
+        return resolvedNote[static_cast<size_t>(midiNote)];
+    }
+
+private:
+    std::array<int, 128> resolvedNote{};
+    std::array<std::array<int8_t, 128>, 128> velocityToLayer{};
+
+    int layerStride = 0;  // Max velocity layers of any note
+    int rrStride = 0;     // Max round-robin position of any sample
+    std::vector<int> sampleIndex;
+    std::vector<int> fallbackIndex;
+};
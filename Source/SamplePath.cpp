@@ -0,0 +1,110 @@
+#include "SamplePath.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+struct SamplePath::Node
+{
+    const Node* folder = nullptr;  // Null for a folder (or a path without one)
+    std::string name;              // UTF-8: the file name, or a folder's full path
+
+    bool operator==(const Node& other) const { return folder == other.folder && name == other.name; }
+
+    // Its string and the set's own bookkeeping (next pointer and cached hash)
+    size_t getBytes() const
+    {
+        const bool heapName = name.capacity() >= sizeof(std::string);  // Short names live inside the string
+        return sizeof(Node) + 2 * sizeof(void*) + (heapName ? name.capacity() + 1 : 0);
+    }
+};
+
+namespace
+{
+    struct NodeHash
+    {
+        size_t operator()(const SamplePath::Node& node) const
+        {
+            return std::hash<std::string>()(node.name) ^ (std::hash<const void*>()(node.folder) * 31);
+        }
+    };
+
+    struct Pool
+    {
+        std::mutex mutex;
+        std::unordered_set<SamplePath::Node, NodeHash> nodes;  // Elements never move
+        std::atomic<int64_t> bytes{0};
+
+        const SamplePath::Node* find(const SamplePath::Node* folder, std::string name)
+        {
+            SamplePath::Node key;
+            key.folder = folder;
+            key.name = std::move(name);
+
+            auto [it, isNew] = nodes.insert(std::move(key));
+            if (isNew)
+                bytes += static_cast<int64_t>(it->getBytes());
+            return &*it;
+        }
+    };
+
+    Pool& getPool()
+    {
+        static Pool pool;  // Never destroyed before paths stop being used: it lives to exit
+        return pool;
+    }
+}
+
+SamplePath SamplePath::intern(const juce::String& fullPath)
+{
+    if (fullPath.isEmpty())
+        return {};
+
+    const int split = fullPath.lastIndexOfChar(juce::File::getSeparatorChar());
+
+    auto& pool = getPool();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    const Node* folder = split > 0 ? pool.find(nullptr, fullPath.substring(0, split).toStdString()) : nullptr;
+    return SamplePath(pool.find(folder, (split > 0 ? fullPath.substring(split + 1) : fullPath).toStdString()));
+}
+
+juce::String SamplePath::toString() const
+{
+    if (node == nullptr)
+        return {};
+
+    const auto name = juce::String::fromUTF8(node->name.c_str(), static_cast<int>(node->name.size()));
+    if (node->folder == nullptr)
+        return name;
+
+    return juce::String::fromUTF8(node->folder->name.c_str(), static_cast<int>(node->folder->name.size()))
+         + juce::File::getSeparatorString() + name;
+}
+
+juce::String SamplePath::getFileName() const
+{
+    if (node == nullptr)
+        return {};
+    return node->folder != nullptr ? juce::String::fromUTF8(node->name.c_str(), static_cast<int>(node->name.size()))
+                                   : juce::File(toString()).getFileName();
+}
+
+size_t SamplePath::getNodeBytes() const
+{
+    return node != nullptr ? node->getBytes() : 0;
+}
+
+const void* SamplePath::getFolderKey() const
+{
+    return node != nullptr ? node->folder : nullptr;
+}
+
+size_t SamplePath::getFolderBytes() const
+{
+    return node != nullptr && node->folder != nullptr ? node->folder->getBytes() : 0;
+}
+
+int64_t SamplePath::getInternedBytes()
+{
+    return getPool().bytes.load();
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+ * SamplePath is an interned sample file path. Each distinct path is stored once for
+ * the life of the process, as its folder (interned too, so a folder's files share it)
+ * and its file name. A SamplePath is one pointer: copying and comparing one costs
+ * nothing, so preloads, voices and the disk thread carry these instead of strings.
+ *
+ * Interning the same path again gives the same SamplePath, so reloading a library
+ * adds nothing. Paths are never freed; the pool only grows by the distinct paths the
+ * process ever loads.
+ *
+ * Thread safe. intern() takes a lock (loader threads); everything else is lock free.
+ */
+class SamplePath
+{
+public:
+    SamplePath() = default;  // Empty
+
+    static SamplePath intern(const juce::String& fullPath);
+    static SamplePath intern(const juce::File& file) { return intern(file.getFullPathName()); }
+
+    bool isEmpty() const { return node == nullptr; }
+    juce::String toString() const;  // Full path; builds a string, so not for the audio thread
+    juce::File getFile() const { return juce::File(toString()); }
+    juce::String getFileName() const;
+
+    /** Bytes this path's own node takes (its folder's is shared, and counted by the folder) */
+    size_t getNodeBytes() const;
+    const void* getFolderKey() const;  // Same for paths in the same folder
+    size_t getFolderBytes() const;
+
+    /** Bytes held by every path interned so far */
+    static int64_t getInternedBytes();
+
+    bool operator==(const SamplePath& other) const { return node == other.node; }
+    bool operator!=(const SamplePath& other) const { return node != other.node; }
+
+    struct Node;  // Defined in SamplePath.cpp
+
+    struct Hash
+    {
+        size_t operator()(const SamplePath& path) const { return std::hash<const void*>()(path.node); }
+    };
+
+private:
+    explicit SamplePath(const Node* n) : node(n) {}
+
+    const Node* node = nullptr;
+};
@@ -0,0 +1,79 @@
+#include "SampleTable.h"
+#include <set>
+
+void SampleTable::reserve(size_t count)
+{
+    paths.reserve(count);
+    midiNotes.reserve(count);
+    velocities.reserve(count);
+    roundRobins.reserve(count);
+    libraryLayers.reserve(count);
+    velocityLayerIndices.reserve(count);
+    totalFrames.reserve(count);
+    fileStartFrames.reserve(count);
+    sampleRates.reserve(count);
+    numChannels.reserve(count);
+    integerBits.reserve(count);
+    fileFrames.reserve(count);
+    fileSizes.reserve(count);
+    dataOffsets.reserve(count);
+    contentHashes.reserve(count);
+}
+
+size_t SampleTable::add(const LibraryScanner::ScannedSample& scanned, int libraryLayer, int64_t fileStartFrame, int64_t frames)
+{
+    const auto& info = scanned.info;
+    paths.push_back(info.path);
+    midiNotes.push_back(static_cast<uint8_t>(juce::jlimit(0, 127, scanned.midiNote)));
+    velocities.push_back(static_cast<uint8_t>(juce::jlimit(0, 127, scanned.velocity)));
+    roundRobins.push_back(static_cast<uint16_t>(juce::jlimit(0, 65535, scanned.roundRobin)));
+    libraryLayers.push_back(static_cast<uint8_t>(libraryLayer));
+    velocityLayerIndices.push_back(-1);
+    totalFrames.push_back(frames);
+    fileStartFrames.push_back(fileStartFrame);
+    sampleRates.push_back(info.sampleRate);
+    numChannels.push_back(static_cast<uint8_t>(juce::jlimit(0, 255, info.numChannels)));
+    integerBits.push_back(static_cast<uint8_t>(info.integerBits));
+    fileFrames.push_back(info.totalSampleFrames);
+    fileSizes.push_back(scanned.fileSize);
+    dataOffsets.push_back(scanned.dataOffset);
+    contentHashes.push_back(scanned.contentHash);
+    return size() - 1;
+}
+
+PreloadedSample SampleTable::describe(size_t i) const
+{
+    PreloadedSample info;
+    info.path = paths[i];
+    info.totalSampleFrames = totalFrames[i];
+    info.fileStartFrame = fileStartFrames[i];
+    info.sampleRate = sampleRates[i];
+    info.numChannels = numChannels[i];
+    info.integerBits = integerBits[i];
+    info.rootNote = midiNotes[i];
+    return info;
+}
+
+int64_t SampleTable::getBytes() const
+{
+    auto columnBytes = [](const auto& column)
+    {
+        return static_cast<int64_t>(column.capacity() * sizeof(typename std::decay_t<decltype(column)>::value_type));
+    };
+
+    int64_t bytes = columnBytes(paths) + columnBytes(midiNotes) + columnBytes(velocities) + columnBytes(roundRobins)
+                  + columnBytes(libraryLayers) + columnBytes(velocityLayerIndices) + columnBytes(totalFrames)
+                  + columnBytes(fileStartFrames) + columnBytes(sampleRates) + columnBytes(numChannels)
+                  + columnBytes(integerBits) + columnBytes(fileFrames) + columnBytes(fileSizes)
+                  + columnBytes(dataOffsets) + columnBytes(contentHashes);
+
+    // Each sample's file name, and each folder once
+    std::set<const void*> folders;
+    for (const auto& path : paths)
+    {
+        bytes += static_cast<int64_t>(path.getNodeBytes());
+        if (folders.insert(path.getFolderKey()).second)
+            bytes += static_cast<int64_t>(path.getFolderBytes());
+    }
+    return bytes;
+}
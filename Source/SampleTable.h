@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "DiskStreaming.h"
+#include "LibraryScanner.h"
+#include "SamplePath.h"
+
+/**
+ * SampleTable holds a library's sample metadata as columns, one per field, indexed
+ * like the engine's samples. Passes over every sample (stage planning, limit changes,
+ * budget rebalancing, packing) read the few columns they need, packed tight, instead
+ * of striding over whole records; a 100k-sample library's metadata stays a few MB.
+ *
+ * Paths are interned (SamplePath), and what only preloads need is built on demand by
+ * describe(). Fields are as small as their ranges allow.
+ *
+ * Built by the loader; afterwards only velocityLayerIndices changes, once the note
+ * mappings are known. Not thread safe: the engine guards it like its samples.
+ */
+struct SampleTable
+{
+    // From the file name
+    std::vector<SamplePath> paths;
+    std::vector<uint8_t> midiNotes;
+    std::vector<uint8_t> velocities;
+    std::vector<uint16_t> roundRobins;
+
+    // Where it plays
+    std::vector<uint8_t> libraryLayers;         // Index into the engine's layers
+    std::vector<int16_t> velocityLayerIndices;  // 0-based, -1 until the note mappings are built
+
+    // Audio
+    std::vector<int64_t> totalFrames;      // Frames played: the file's, less any trimmed silence
+    std::vector<int64_t> fileStartFrames;  // File frame playback starts at
+    std::vector<double> sampleRates;
+    std::vector<uint8_t> numChannels;
+    std::vector<uint8_t> integerBits;      // 16 or 24 for integer PCM of that depth, else 0
+
+    // File
+    std::vector<int64_t> fileFrames;       // Including trimmed silence
+    std::vector<int64_t> fileSizes;
+    std::vector<int64_t> dataOffsets;      // Byte offset of the audio data, -1 if unknown
+    std::vector<uint64_t> contentHashes;   // Equal hashes may share a preload, 0 = unknown
+
+    size_t size() const { return paths.size(); }
+    void reserve(size_t count);
+    void clear() { *this = SampleTable(); }
+
+    /** Appends a scanned sample, played from fileStartFrame for totalFrames (its audible range
+        when trimmed, else the whole file). Returns its index. */
+    size_t add(const LibraryScanner::ScannedSample& scanned, int libraryLayer, int64_t fileStartFrame, int64_t totalFrames);
+
+    /** A preload-less PreloadedSample carrying sample i's metadata, as preloads are made from */
+    PreloadedSample describe(size_t i) const;
+
+    /** Bytes the columns hold, plus the interned paths of the table's samples and folders */
+    int64_t getBytes() const;
+};
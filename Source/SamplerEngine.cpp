@@ -1,7 +1,16 @@
 #include "SamplerEngine.h"
+#include "LibraryIndexCache.h"
+#include "MemoryLock.h"
+#include "PreloadProfile.h"
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 
 // Debug logging
 static void engineDebugLog(const juce::String& msg)
@@ -12,6 +21,256 @@ static void engineDebugLog(const juce::String& msg)
     logFile.appendText("[" + timestamp + "] " + msg + "\n");
 }
 
+// RAM one frame of a sample's preload takes: floats, or compactBits-bit integers
+static int bytesPerPreloadFrame(const PreloadedSample& info, int compactBits)
+{
+    return info.numChannels * (compactBits != 0 ? compactBits / 8 : static_cast<int>(sizeof(float)));
+}
+
+// RAM a sample's preload of `frames` frames takes once read
+static int64_t preloadBytesFor(const PreloadedSample& info, int frames, int compactBits)
+{
+    return static_cast<int64_t>(frames) * static_cast<int64_t>(bytesPerPreloadFrame(info, compactBits));
+}
+
+// Faults in a preload's pages (read only: they may be a read-only mapping)
+static void touchPreload(const PreloadedSample& preload)
+{
+    if (preload.compactBits != 0)
+    {
+        MemoryLock::touch(preload.compactData, static_cast<size_t>(preload.getPreloadBytes()), false);
+        return;
+    }
+
+    for (int channel = 0; channel < preload.preloadBuffer.getNumChannels(); ++channel)
+        MemoryLock::touch(const_cast<float*>(preload.preloadBuffer.getReadPointer(channel)),
+                          static_cast<size_t>(preload.preloadBuffer.getNumSamples()) * sizeof(float), false);
+}
+
+// A preload of `frames` of info's channels (the whole sample if shorter) with nothing read
+// yet, as floats or (compactBits != 0) compact integers: one arena block holds every
+// channel, or the heap if the arena can't get memory
+static std::unique_ptr<PreloadedSample> allocatePreload(PreloadArena& arena, const PreloadedSample& info, int frames,
+                                                        int compactBits)
+{
+    if (info.numChannels <= 0)
+        return nullptr;
+
+    frames = static_cast<int>(std::min<int64_t>(std::max(0, frames), info.totalSampleFrames));
+    auto preload = LibraryScanner::makePreload(info);
+
+    if (compactBits != 0)
+    {
+        const auto bytes = static_cast<size_t>(preloadBytesFor(info, frames, compactBits));
+        auto block = arena.allocate(bytes);
+        if (block == nullptr)
+            block = std::shared_ptr<void>(new char[std::max<size_t>(bytes, 1)], std::default_delete<char[]>());
+
+        preload->compactBits = compactBits;
+        preload->compactData = static_cast<char*>(block.get());
+        preload->compactFrames = frames;
+        preload->dataOwner = std::move(block);
+        preload->preloadSizeFrames = 0;
+        return preload;
+    }
+
+    const size_t channelStride = PreloadArena::roundUp(static_cast<size_t>(frames) * sizeof(float));
+    if (auto block = arena.allocate(channelStride * static_cast<size_t>(info.numChannels)))
+    {
+        std::vector<float*> channels;
+        for (int channel = 0; channel < info.numChannels; ++channel)
+            channels.push_back(reinterpret_cast<float*>(static_cast<char*>(block.get()) + static_cast<size_t>(channel) * channelStride));
+
+        preload->preloadBuffer.setDataToReferTo(channels.data(), info.numChannels, frames);
+        preload->dataOwner = std::move(block);
+    }
+    else
+    {
+        preload->preloadBuffer.setSize(info.numChannels, frames);
+    }
+
+    preload->preloadSizeFrames = 0;
+    return preload;
+}
+
+// Where a preload's data starts: preloads sharing data (sharePreloads) have the same one
+static const void* preloadData(const PreloadedSample& preload)
+{
+    if (preload.compactBits != 0)
+        return preload.compactData;
+    return preload.preloadBuffer.getNumChannels() > 0 ? preload.preloadBuffer.getReadPointer(0) : nullptr;
+}
+
+// A preload with info's metadata whose first `frames` frames are source's, without a copy:
+// it refers to source's memory (an arena block or a mapped snapshot) and keeps it alive
+static std::unique_ptr<PreloadedSample> referToPreload(const PreloadedSample& info, const PreloadedSample& source, int frames)
+{
+    auto preload = LibraryScanner::makePreload(info);
+    if (source.compactBits != 0)
+    {
+        preload->compactBits = source.compactBits;
+        preload->compactData = source.compactData;  // Interleaved: a prefix is the first frames
+        preload->compactFrames = frames;
+    }
+    else
+    {
+        std::vector<float*> channels;
+        for (int channel = 0; channel < source.numChannels; ++channel)
+            channels.push_back(const_cast<float*>(source.preloadBuffer.getReadPointer(channel)));
+
+        preload->preloadBuffer.setDataToReferTo(channels.data(), source.numChannels, frames);
+    }
+    preload->dataOwner = source.dataOwner;
+    preload->mapped = source.mapped;
+    preload->preloadSizeFrames = std::min(frames, source.preloadSizeFrames);
+    return preload;
+}
+
+// True if two preloads in the same format hold the same first `frames` frames
+static bool samePreloadData(const PreloadedSample& a, const PreloadedSample& b, int frames)
+{
+    if (a.compactBits != b.compactBits || a.numChannels != b.numChannels ||
+        frames > a.preloadSizeFrames || frames > b.preloadSizeFrames)
+        return false;
+
+    if (a.compactBits != 0)
+        return std::memcmp(a.compactData, b.compactData, static_cast<size_t>(preloadBytesFor(a, frames, a.compactBits))) == 0;
+
+    for (int channel = 0; channel < a.numChannels; ++channel)
+    {
+        if (std::memcmp(a.preloadBuffer.getReadPointer(channel), b.preloadBuffer.getReadPointer(channel),
+                        static_cast<size_t>(frames) * sizeof(float)) != 0)
+            return false;
+    }
+    return true;
+}
+
+// A copy of preload sized for `frames` and stored as compactBits (0 = floats), keeping the
+// frames it already holds; any further frames are left for SamplerEngine::extendPreload().
+// Shrinking mapped data (a snapshot) in its own format refers to less of the same mapping;
+// other data is copied so the surplus RAM is freed. Compact data holds what the file does,
+// so converting either way loses nothing.
+static std::unique_ptr<PreloadedSample> resizedPreload(PreloadArena& arena, const PreloadedSample& preload, int frames,
+                                                       int compactBits)
+{
+    const int numChannels = preload.numChannels;
+    const int keptFrames = std::min(frames, preload.preloadSizeFrames);
+
+    if (preload.mapped && frames <= preload.preloadSizeFrames && compactBits == preload.compactBits)
+        return referToPreload(preload, preload, frames);
+
+    auto resized = allocatePreload(arena, preload, frames, compactBits);
+    if (resized == nullptr)
+        return nullptr;
+
+    if (compactBits != 0 && compactBits == preload.compactBits)
+    {
+        std::memcpy(resized->compactData, preload.compactData, static_cast<size_t>(preloadBytesFor(preload, keptFrames, compactBits)));
+    }
+    else if (compactBits != 0)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            resized->writeCompact(channel, 0, preload.preloadBuffer.getReadPointer(channel), keptFrames);
+    }
+    else
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            preload.readPreload(channel, 0, resized->preloadBuffer.getWritePointer(channel), keptFrames);
+    }
+
+    resized->preloadSizeFrames = keptFrames;
+    return resized;
+}
+
+// Note mappings for one layer from its samples' (note, velocity) pairs: sorted velocity
+// layers with their ranges, and a fallback to the next higher note for notes without samples
+static std::map<int, NoteMapping> buildNoteMappings(const std::vector<std::pair<int, int>>& noteVelocities)
+{
+    std::map<int, NoteMapping> mappings;
+    for (const auto& [midiNote, velocity] : noteVelocities)
+    {
+        auto& noteMapping = mappings[midiNote];
+        noteMapping.midiNote = midiNote;
+
+        auto it = std::find_if(noteMapping.velocityLayers.begin(), noteMapping.velocityLayers.end(),
+            [velocity = velocity](const VelocityLayer& layer) { return layer.velocityValue == velocity; });
+
+        if (it == noteMapping.velocityLayers.end())
+        {
+            VelocityLayer newLayer;
+            newLayer.velocityValue = velocity;
+            noteMapping.velocityLayers.push_back(newLayer);
+        }
+    }
+
+    // Build velocity ranges
+    for (auto& [note, mapping] : mappings)
+    {
+        std::sort(mapping.velocityLayers.begin(), mapping.velocityLayers.end(),
+            [](const VelocityLayer& a, const VelocityLayer& b) {
+                return a.velocityValue < b.velocityValue;
+            });
+
+        for (size_t i = 0; i < mapping.velocityLayers.size(); ++i)
+        {
+            auto& layer = mapping.velocityLayers[i];
+            if (i == 0)
+                layer.velocityRangeStart = 1;
+            else
+                layer.velocityRangeStart = mapping.velocityLayers[i - 1].velocityValue + 1;
+            layer.velocityRangeEnd = layer.velocityValue;
+        }
+    }
+
+    // Build fallbacks
+    for (int n = 0; n < 128; ++n)
+    {
+        if (mappings.find(n) == mappings.end())
+        {
+            int fallback = -1;
+            for (int higher = n + 1; higher < 128; ++higher)
+            {
+                if (mappings.find(higher) != mappings.end())
+                {
+                    fallback = higher;
+                    break;
+                }
+            }
+            if (fallback >= 0)
+            {
+                mappings[n].midiNote = n;
+                mappings[n].fallbackNote = fallback;
+            }
+        }
+        else
+        {
+            mappings[n].fallbackNote = -1;
+        }
+    }
+
+    return mappings;
+}
+
+// Layer settings clamped to valid ranges (a low end above the high end is raised to it)
+static SamplerEngine::LayerSettings limitedLayerSettings(SamplerEngine::LayerSettings settings)
+{
+    settings.lowNote = juce::jlimit(0, 127, settings.lowNote);
+    settings.highNote = juce::jlimit(settings.lowNote, 127, settings.highNote);
+    settings.lowVelocity = juce::jlimit(1, 127, settings.lowVelocity);
+    settings.highVelocity = juce::jlimit(settings.lowVelocity, 127, settings.highVelocity);
+    settings.gain = juce::jlimit(0.0f, 4.0f, settings.gain);
+    settings.velocityLayerLimit = juce::jmax(0, settings.velocityLayerLimit);
+    settings.roundRobinLimit = juce::jmax(0, settings.roundRobinLimit);
+    settings.silenceThresholdDb = juce::jlimit(-120.0f, -30.0f, settings.silenceThresholdDb);
+    return settings;
+}
+
+// The last stage that is complete while samples of this stage are still loading
+static LoadStage previousStage(LoadStage stage)
+{
+    return stage == LoadStage::None ? stage : static_cast<LoadStage>(static_cast<int>(stage) - 1);
+}
+
 SamplerEngine::SamplerEngine()
 {
     formatManager.registerBasicFormats();
@@ -19,32 +278,72 @@ SamplerEngine::SamplerEngine()
     // Initialize disk streamer
     diskStreamer = std::make_unique<DiskStreamer>();
     diskStreamer->setAudioFormatManager(&formatManager);
+    diskStreamer->setDeferredReclaimer(&reclaimer);
+
+    setVoiceStealingPolicy(std::make_unique<CostAwareStealingPolicy>());
+
+    audioParams.adsr.attack = adsrParams.attack;
+    audioParams.adsr.decay = adsrParams.decay;
+    audioParams.adsr.sustain = adsrParams.sustain;
+    audioParams.adsr.release = adsrParams.release;
+    audioParams.sameNoteReleaseTime = sameNoteReleaseTime;
 
     // Register streaming voices with disk streamer
     for (int i = 0; i < StreamingConstants::maxStreamingVoices; ++i)
     {
         diskStreamer->registerVoice(i, &streamingVoices[static_cast<size_t>(i)]);
     }
+
+    // Applies limit changes, and frees retired preloads once voices let go of them
+    preloadWorker = std::make_unique<PreloadWorker>([this] { applyPreloadLimits(); },
+                                                    [this] { reclaimer.collect(); checkPreloadBudget(); reportMemoryLockFailures(); checkMemoryPressure(); });
+    preloadWorker->startThread();
+
+    // Library loads, newest request only
+    loadWorker = std::make_unique<PreloadWorker>([this] { runRequestedLoad(); }, nullptr, "LibraryLoader");
+    loadWorker->startThread();
 }
 
 SamplerEngine::~SamplerEngine()
 {
+    // Cancel any library load, then stop background preloading before the sample list goes away
+    if (loadWorker)
+    {
+        loadWorker->stopThread();
+    }
+
+    if (preloadWorker)
+    {
+        preloadWorker->stopThread();
+    }
+
     // Stop disk streaming thread
     if (diskStreamer)
     {
         diskStreamer->stopThread();
     }
+}
 
-    // Wait for any loading thread to finish
-    if (loadingThread && loadingThread->joinable())
-    {
-        loadingThread->join();
-    }
+SamplerEngine::AudioBlockScope::AudioBlockScope(SamplerEngine& e)
+    : engine(e), readScope(e.reclaimer, DeferredReclaimer::audioThreadReader)
+{
+    engine.applyPendingCommands();
+
+    engine.audioSampleMap = engine.publishedSampleMap.load(std::memory_order_acquire);
+}
+
+SamplerEngine::AudioBlockScope::~AudioBlockScope()
+{
+    engine.audioSampleMap = nullptr;
 }
 
 void SamplerEngine::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
     currentSampleRate = sampleRate;
+    budgetSampleRate = sampleRate;
+
+    // Audio is stopped here, so pick up anything queued while it was
+    applyPendingCommands();
 
     // Prepare streaming voices
     for (auto& voice : streamingVoices)
@@ -65,12 +364,62 @@ void SamplerEngine::setADSR(float attack, float decay, float sustain, float rele
     adsrParams.decay = juce::jmax(0.001f, decay);
     adsrParams.sustain = juce::jlimit(0.0f, 1.0f, sustain);
     adsrParams.release = juce::jmax(0.001f, release);
+
+    EngineCommand command;
+    command.type = EngineCommand::Type::setADSR;
+    command.floatValues = { adsrParams.attack, adsrParams.decay, adsrParams.sustain, adsrParams.release };
+    pushCommand(command);
+}
+
+void SamplerEngine::setSameNoteReleaseTime(float seconds)
+{
+    sameNoteReleaseTime = juce::jlimit(0.01f, 5.0f, seconds);
+
+    EngineCommand command;
+    command.type = EngineCommand::Type::setSameNoteReleaseTime;
+    command.floatValues[0] = sameNoteReleaseTime;
+    pushCommand(command);
+}
+
+void SamplerEngine::pushCommand(const EngineCommand& command)
+{
+    // Never full: a change replaces any of its type the audio thread hasn't drained yet
+    commandQueue.push(command);
+}
+
+void SamplerEngine::applyPendingCommands()
+{
+    commandQueue.drain([this](const EngineCommand& command)
+    {
+        switch (command.type)
+        {
+            case EngineCommand::Type::setADSR:
+                audioParams.adsr.attack = command.floatValues[0];
+                audioParams.adsr.decay = command.floatValues[1];
+                audioParams.adsr.sustain = command.floatValues[2];
+                audioParams.adsr.release = command.floatValues[3];
+                ++audioParams.adsrGeneration;
+                break;
+
+            case EngineCommand::Type::setSameNoteReleaseTime:
+                audioParams.sameNoteReleaseTime = command.floatValues[0];
+                break;
+
+            case EngineCommand::Type::setRoundRobinLimit:
+                audioParams.roundRobinLimit = command.intValue;
+                break;
+
+            case EngineCommand::Type::numTypes:
+                break;
+        }
+    });
 }
 
 bool SamplerEngine::isLoaded() const
 {
     std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
-    return loadingState == LoadingState::Loaded && !noteMappings.empty();
+    return loadingState == LoadingState::Loaded
+        && std::any_of(libraryLayers.begin(), libraryLayers.end(), [](const LoadedLayer& layer) { return !layer.noteMappings.empty(); });
 }
 
 bool SamplerEngine::isNoteAvailable(int midiNote) const
@@ -163,30 +512,17 @@ int SamplerEngine::getVelocityLayerIndex(int midiNote, int velocity) const
 {
     std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
 
-    auto it = noteMappings.find(midiNote);
-    if (it == noteMappings.end())
-        return -1;
-
-    const auto& mapping = it->second;
-    int actualNote = (mapping.fallbackNote >= 0) ? mapping.fallbackNote : midiNote;
-
-    auto actualIt = noteMappings.find(actualNote);
-    if (actualIt == noteMappings.end())
+    // Same limited layer mapping as noteOn, for the first layer
+    if (currentSampleMap == nullptr || currentSampleMap->layers.empty())
         return -1;
+    return currentSampleMap->layers.front().lookup.getVelocityLayerIndex(midiNote, velocity);
+}
 
-    const auto& actualMapping = actualIt->second;
-    int totalLayers = static_cast<int>(actualMapping.velocityLayers.size());
-    if (totalLayers == 0)
+int SamplerEngine::lookupVelocityLayerIndex(int midiNote, int velocity) const
+{
+    if (audioSampleMap == nullptr || audioSampleMap->layers.empty())
         return -1;
-
-    // Apply velocity layer limit (same logic as findStreamingSample)
-    int effectiveLayers = std::min(velocityLayerLimit, totalLayers);
-
-    // Map incoming velocity (1-127) to limited layer index evenly
-    int layerIndex = ((velocity - 1) * effectiveLayers) / 127;
-    layerIndex = juce::jlimit(0, effectiveLayers - 1, layerIndex);
-
-    return layerIndex;
+    return audioSampleMap->layers.front().lookup.getVelocityLayerIndex(midiNote, velocity);
 }
 
 int SamplerEngine::parseNoteName(const juce::String& noteName)
@@ -277,574 +613,2292 @@ bool SamplerEngine::parseFileName(const juce::String& fileName, int& note, int&
 
 void SamplerEngine::loadSamplesFromFolder(const juce::File& folder)
 {
-    // Wait for any existing loading to complete
-    if (loadingThread && loadingThread->joinable())
-    {
-        loadingThread->join();
-    }
+    loadLibraryLayers({ LibraryLayer{ folder, LayerSettings() } });
+}
+
+void SamplerEngine::loadLibraryLayers(std::vector<LibraryLayer> layers)
+{
+    if (layers.size() > static_cast<size_t>(maxLibraryLayers))
+        layers.resize(static_cast<size_t>(maxLibraryLayers));
 
-    loadedFolderPath = folder.getFullPathName();
+    loadedFolderPath = layers.empty() ? juce::String() : layers.front().folder.getFullPathName();
 
-    if (!folder.isDirectory())
+    if (layers.empty() || std::any_of(layers.begin(), layers.end(), [](const LibraryLayer& layer) { return !layer.folder.isDirectory(); }))
         return;
 
-    // Start background loading
+    for (auto& layer : layers)
+        layer.settings = limitedLayerSettings(layer.settings);
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+        requestedLayers = std::move(layers);
+    }
+
+    // Never waits: a load in progress sees the new request and gives up at its next check
     loadingState = LoadingState::Loading;
-    loadingThread = std::make_unique<std::thread>(&SamplerEngine::loadSamplesInBackground, this, folder.getFullPathName());
+    loadWorker->requestWork();
 }
 
-void SamplerEngine::loadSamplesInBackground(const juce::String& folderPath)
+std::vector<SamplerEngine::LibraryLayer> SamplerEngine::getLibraryLayers() const
 {
-    engineDebugLog("Loading samples from: " + folderPath);
+    std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+    return requestedLayers;
+}
 
-    // Reset underrun counter
-    StreamingVoice::resetUnderrunCount();
+void SamplerEngine::setLayerSettings(int layerIndex, const LayerSettings& settings)
+{
+    const auto limited = limitedLayerSettings(settings);
+    bool limitsChanged = false;
+    bool trimChanged = false;
+    {
+        std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+        if (layerIndex >= 0 && layerIndex < static_cast<int>(requestedLayers.size()))
+        {
+            auto& requested = requestedLayers[static_cast<size_t>(layerIndex)].settings;
+            trimChanged = requested.trimSilence != limited.trimSilence
+                       || (limited.trimSilence && requested.silenceThresholdDb != limited.silenceThresholdDb);
+            requested = limited;
+        }
 
-    // Stop all streaming voices and unregister from DiskStreamer
-    for (int i = 0; i < StreamingConstants::maxStreamingVoices; ++i)
+        if (layerIndex >= 0 && layerIndex < static_cast<int>(libraryLayers.size()))
+        {
+            auto& current = libraryLayers[static_cast<size_t>(layerIndex)].layer.settings;
+            limitsChanged = current.velocityLayerLimit != limited.velocityLayerLimit
+                         || current.roundRobinLimit != limited.roundRobinLimit;
+            current = limited;
+
+            // Ranges and gain are in the sample map; a staged library gets them with the swap
+            if (!libraryStaging)
+                publishSampleMap();
+        }
+    }
+
+    // Trimming moves every sample's start and end: the library reloads (and keeps playing
+    // until the trimmed one swaps in). The index cache makes that a matter of reading preloads.
+    if (trimChanged)
+    {
+        loadingState = LoadingState::Loading;
+        loadWorker->requestWork();
+    }
+    else if (limitsChanged)
     {
-        streamingVoices[static_cast<size_t>(i)].stopVoice(false);
-        if (diskStreamer)
-            diskStreamer->unregisterVoice(i);
+        preloadWorker->requestWork();
     }
+}
 
-    juce::Thread::sleep(20);
+void SamplerEngine::runRequestedLoad()
+{
+    std::vector<LibraryLayer> layers;
+    {
+        std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+        layers = requestedLayers;
+    }
 
-    juce::File folder(folderPath);
+    if (!layers.empty())
+        loadSamplesInBackground(layers);
+}
 
-    std::vector<StreamingSample> tempSamples;
+bool SamplerEngine::isLoadCancelled() const
+{
+    return loadWorker->threadShouldExit() || loadWorker->hasPendingRequest();
+}
 
-    totalInstrumentFileSize = 0;
-    preloadMemoryBytes = 0;
-    int64_t tempTotalSize = 0;
-    int tempMaxRoundRobins = 1;
+SamplerEngine::LoadProgress SamplerEngine::getLoadProgress() const
+{
+    LoadProgress progress;
+    progress.inProgress = loadingState == LoadingState::Loading
+                       || (loadingState == LoadingState::Loaded && loadStage != LoadStage::Complete);
+    progress.filesTotal = loadFilesTotal.load(std::memory_order_relaxed);
+    progress.filesScanned = loadFilesScanned.load(std::memory_order_relaxed);
+    progress.bytesPreloaded = loadBytesPreloaded.load(std::memory_order_relaxed);
+    progress.bytesToPreload = loadBytesToPreload.load(std::memory_order_relaxed);
+
+    if (!progress.inProgress)
+        return progress;
+
+    // Extrapolate the current phase's rate so far
+    const auto now = juce::Time::getMillisecondCounter();
+    auto estimate = [now](juce::uint32 startMs, double done, double total)
+    {
+        if (done <= 0.0 || total <= done)
+            return done > 0.0 ? 0.0 : -1.0;
+        const double elapsedSeconds = static_cast<double>(now - startMs) / 1000.0;
+        return elapsedSeconds * (total - done) / done;
+    };
+
+    if (progress.bytesToPreload == 0)
+        progress.secondsRemaining = estimate(loadScanStartMs.load(), progress.filesScanned, progress.filesTotal);
+    else
+        progress.secondsRemaining = estimate(loadPreloadStartMs.load(), static_cast<double>(progress.bytesPreloaded),
+                                             static_cast<double>(progress.bytesToPreload));
+    return progress;
+}
+
+void SamplerEngine::setCacheDirectory(const juce::File& root)
+{
+    std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+    cacheDirectory = root;
+}
 
-    juce::Array<juce::File> audioFiles;
-    folder.findChildFiles(audioFiles, juce::File::findFiles, false, "*.wav;*.aif;*.aiff;*.flac;*.mp3");
+juce::File SamplerEngine::getCacheDirectory() const
+{
+    std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+    return cacheDirectory;
+}
 
-    engineDebugLog("Found " + juce::String(audioFiles.size()) + " audio files");
+juce::File SamplerEngine::getCacheSubdirectory(const char* name) const
+{
+    const auto root = getCacheDirectory();
+    return root == juce::File() ? juce::File() : root.getChildFile(name);
+}
 
+std::vector<LibraryScanner::ScannedSample> SamplerEngine::scanLibraryFolder(const LibraryLayer& layer)
+{
+    // Files the index cache still vouches for skip the header scan; the rest get a
+    // parallel header-only scan. Preloads are read afterwards, in load stages.
+    // A layer that trims silence also needs each file's audible range at its threshold.
+    const auto& folder = layer.folder;
+    const bool trimSilence = layer.settings.trimSilence;
+    const float silenceThresholdDb = layer.settings.silenceThresholdDb;
+    LibraryScanner scanner(formatManager);
+    LibraryIndexCache indexCache(folder, getCacheSubdirectory("IndexCache"));
+    indexCache.load();
+
+    const auto scanStartTime = juce::Time::getMillisecondCounter();
+    const auto audioFiles = LibraryScanner::findAudioFiles(folder, true);
+    loadFilesTotal += audioFiles.size();
+
+    std::vector<LibraryScanner::ScannedSample> scannedSamples;
+    std::vector<LibraryIndexCache::Entry> notSamples;  // Still-valid entries of files that aren't samples
+    juce::Array<juce::File> filesToScan;
     for (const auto& file : audioFiles)
     {
-        int note, velocity, roundRobin;
-        if (!parseFileName(file.getFileName(), note, velocity, roundRobin))
-            continue;
-
-        // Track max round-robin found
-        if (roundRobin > tempMaxRoundRobins)
-            tempMaxRoundRobins = roundRobin;
-
-        tempTotalSize += file.getSize();
-
-        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
-        if (!reader)
+        const auto* entry = indexCache.find(file);
+        if (entry != nullptr && !entry->isSample)
+        {
+            notSamples.push_back(*entry);
             continue;
+        }
 
-        StreamingSample ss;
-        ss.midiNote = note;
-        ss.velocity = velocity;
-        ss.roundRobin = roundRobin;
-        ss.velocityLayerIndex = -1;  // Will be set after building noteMappings
-        ss.isPreloaded = false;      // Don't preload yet - will be done by updatePreloadedSamples
-
-        ss.preload.filePath = file.getFullPathName();
-        ss.preload.sampleRate = reader->sampleRate;
-        ss.preload.numChannels = static_cast<int>(reader->numChannels);
-        ss.preload.totalSampleFrames = static_cast<int64_t>(reader->lengthInSamples);
-        ss.preload.name = file.getFileNameWithoutExtension();
-        ss.preload.rootNote = note;
-        ss.preload.lowNote = note;
-        ss.preload.highNote = note;
-        ss.preload.lowVelocity = velocity;
-        ss.preload.highVelocity = velocity;
-        ss.preload.preloadSizeFrames = 0;  // Will be set when actually preloaded
+        if (entry != nullptr && trimSilence && (entry->audibleEnd < 0 || entry->audibleThresholdDb != silenceThresholdDb))
+            entry = nullptr;  // Analysed at another threshold, or not at all
 
-        tempSamples.push_back(std::move(ss));
+        if (entry != nullptr)
+        {
+            auto scanned = LibraryScanner::describeSample(file, entry->midiNote, entry->velocity, entry->roundRobin,
+                                                          entry->sampleRate, entry->numChannels, entry->totalFrames,
+                                                          entry->integerBits);
+            scanned.dataOffset = entry->dataOffset;
+            scanned.contentHash = entry->contentHash;
+            scanned.audibleStart = entry->audibleStart;
+            scanned.audibleEnd = entry->audibleEnd;
+            scanned.audibleThresholdDb = entry->audibleThresholdDb;
+            scannedSamples.push_back(std::move(scanned));
+        }
+        else
+        {
+            filesToScan.add(file);
+        }
     }
-
+    const size_t numCached = scannedSamples.size();
+    const size_t numEntriesKept = numCached + notSamples.size();
+    loadFilesScanned += static_cast<int>(numEntriesKept);
+
+    LibraryScanner::Options scanOptions;
+    scanOptions.parseFileName = &SamplerEngine::parseFileName;
+    scanOptions.analyseSilence = trimSilence;
+    scanOptions.silenceThresholdDb = silenceThresholdDb;
+    scanOptions.shouldCancel = [this] { return isLoadCancelled(); };
+    scanOptions.onFileScanned = [this] { ++loadFilesScanned; };
+
+    std::unordered_set<SamplePath, SamplePath::Hash> scannedPaths;
+    for (auto& scanned : scanner.scanFiles(filesToScan, scanOptions))
     {
-        std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
-        streamingSamples = std::move(tempSamples);
+        scannedPaths.insert(scanned.info.path);
+        scannedSamples.push_back(std::move(scanned));
     }
 
-    // Build noteMappings for UI
-    std::map<int, NoteMapping> tempMappings;
-    for (const auto& ss : streamingSamples)
-    {
-        auto& noteMapping = tempMappings[ss.midiNote];
-        noteMapping.midiNote = ss.midiNote;
-
-        auto it = std::find_if(noteMapping.velocityLayers.begin(), noteMapping.velocityLayers.end(),
-            [&ss](const VelocityLayer& layer) { return layer.velocityValue == ss.velocity; });
+    if (isLoadCancelled())
+        return {};  // Half a scan must not end up in the index
 
-        if (it == noteMapping.velocityLayers.end())
+    // Scanned files the scanner skipped aren't samples: remembered, so they aren't opened again
+    for (const auto& file : filesToScan)
+    {
+        if (scannedPaths.count(SamplePath::intern(file)) == 0)
         {
-            VelocityLayer newLayer;
-            newLayer.velocityValue = ss.velocity;
-            noteMapping.velocityLayers.push_back(newLayer);
+            auto entry = indexCache.makeEntry(file);
+            entry.isSample = false;
+            notSamples.push_back(std::move(entry));
         }
     }
 
-    // Build velocity ranges
-    for (auto& [note, mapping] : tempMappings)
+    // Back to findAudioFiles() order, so sample indices match a full scan
+    std::unordered_map<SamplePath, int, SamplePath::Hash> fileOrder;
+    for (int i = 0; i < audioFiles.size(); ++i)
+        fileOrder.emplace(SamplePath::intern(audioFiles[i]), i);
+    std::sort(scannedSamples.begin(), scannedSamples.end(),
+        [&fileOrder](const LibraryScanner::ScannedSample& a, const LibraryScanner::ScannedSample& b) {
+            return fileOrder[a.info.path] < fileOrder[b.info.path];
+        });
+
+    // Rewrite the index only if files were added, changed or removed
+    if (!filesToScan.isEmpty() || numEntriesKept != indexCache.getEntries().size())
     {
-        std::sort(mapping.velocityLayers.begin(), mapping.velocityLayers.end(),
-            [](const VelocityLayer& a, const VelocityLayer& b) {
-                return a.velocityValue < b.velocityValue;
-            });
-
-        for (size_t i = 0; i < mapping.velocityLayers.size(); ++i)
+        std::vector<LibraryIndexCache::Entry> entries = std::move(notSamples);
+        entries.reserve(entries.size() + scannedSamples.size());
+        for (const auto& scanned : scannedSamples)
         {
-            auto& layer = mapping.velocityLayers[i];
-            if (i == 0)
-                layer.velocityRangeStart = 1;
-            else
-                layer.velocityRangeStart = mapping.velocityLayers[i - 1].velocityValue + 1;
-            layer.velocityRangeEnd = layer.velocityValue;
+            auto entry = indexCache.makeEntry(scanned.info.path.getFile());
+            entry.midiNote = scanned.midiNote;
+            entry.velocity = scanned.velocity;
+            entry.roundRobin = scanned.roundRobin;
+            entry.totalFrames = scanned.info.totalSampleFrames;
+            entry.sampleRate = scanned.info.sampleRate;
+            entry.numChannels = scanned.info.numChannels;
+            entry.dataOffset = scanned.dataOffset;
+            entry.integerBits = scanned.info.integerBits;
+            entry.contentHash = scanned.contentHash;
+            entry.audibleStart = scanned.audibleStart;
+            entry.audibleEnd = scanned.audibleEnd;
+            entry.audibleThresholdDb = scanned.audibleThresholdDb;
+            entries.push_back(std::move(entry));
         }
+        indexCache.setEntries(std::move(entries));
+
+        if (!indexCache.save())
+            engineDebugLog("Could not write library index: " + indexCache.getIndexFile().getFullPathName());
     }
 
-    // Build fallbacks
-    for (int n = 0; n < 128; ++n)
+    engineDebugLog("Indexed " + juce::String(static_cast<int>(scannedSamples.size())) + " samples (" +
+                   juce::String(static_cast<int>(numCached)) + " cached, " +
+                   juce::String(filesToScan.size()) + " scanned) in " +
+                   juce::String(juce::Time::getMillisecondCounter() - scanStartTime) + " ms: " +
+                   folder.getFullPathName());
+
+    return scannedSamples;
+}
+
+void SamplerEngine::loadSamplesInBackground(const std::vector<LibraryLayer>& layers)
+{
+    juce::StringArray folderNames;
+    for (const auto& layer : layers)
+        folderNames.add(layer.folder.getFullPathName());
+    const juce::String folderPath = folderNames.joinIntoString(", ");
+
+    engineDebugLog("Loading samples from: " + folderPath);
+
+    // Reset underrun counter
+    StreamingVoice::resetUnderrunCount();
+
+    // The current library stays published, and keeps playing, while the next one is
+    // built behind it. Its preloads are held until the next library's first stage swaps
+    // in; voices still playing them then finish before they are freed.
     {
-        if (tempMappings.find(n) == tempMappings.end())
-        {
-            int fallback = -1;
-            for (int higher = n + 1; higher < 128; ++higher)
-            {
-                if (tempMappings.find(higher) != tempMappings.end())
-                {
-                    fallback = higher;
-                    break;
-                }
-            }
-            if (fallback >= 0)
-            {
-                tempMappings[n].midiNote = n;
-                tempMappings[n].fallbackNote = fallback;
-            }
-        }
-        else
+        std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+
+        ++libraryGeneration;  // Abandons any limit change in progress
+        libraryStaging = true;
+        loadStage = LoadStage::None;
+
+        for (auto& ss : streamingSamples)
         {
-            tempMappings[n].fallbackNote = -1;
+            if (ss.preload != nullptr)
+                outgoingPreloads.push_back(std::move(ss.preload));
         }
+        streamingSamples.clear();
+        sampleTable.clear();
+        libraryLayers.clear();
+        sampleUsage.reset();
     }
 
+    loadFilesTotal = 0;
+    loadFilesScanned = 0;
+    loadBytesPreloaded = 0;
+    loadBytesToPreload = 0;
+    loadScanStartMs = juce::Time::getMillisecondCounter();
+
+    std::vector<StreamingSample> tempSamples;
+    SampleTable tempTable;
+    std::vector<LoadedLayer> tempLayers;
+
+    totalInstrumentFileSize = 0;
+    preloadMemoryBytes = computePreloadMemoryBytes();
+    int64_t tempTotalSize = 0;
+    int tempMaxRoundRobins = 1;
+
+    // Layers are scanned one after another; their samples share one list, layer by layer
+    for (size_t layerIndex = 0; layerIndex < layers.size(); ++layerIndex)
     {
-        std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
-        noteMappings = std::move(tempMappings);
+        auto scannedSamples = scanLibraryFolder(layers[layerIndex]);
+        if (isLoadCancelled())
+        {
+            engineDebugLog("Load cancelled while scanning: " + folderPath);
+            return;  // The newer request starts over; nothing of this one was published
+        }
+
+        // What adaptive sizing learned about this folder last time
+        PreloadProfile profile(layers[layerIndex].folder, getCacheSubdirectory("PreloadProfiles"));
+        profile.load();
+
+        tempSamples.reserve(tempSamples.size() + scannedSamples.size());
+        tempTable.reserve(tempTable.size() + scannedSamples.size());
+        for (auto& scanned : scannedSamples)
+        {
+            // Track max round-robin found
+            if (scanned.roundRobin > tempMaxRoundRobins)
+                tempMaxRoundRobins = scanned.roundRobin;
+
+            tempTotalSize += scanned.fileSize;
+
+            // Trimmed: playback, the preload and streaming all start and end at the audible range
+            int64_t startFrame = 0;
+            int64_t frames = scanned.info.totalSampleFrames;
+            if (layers[layerIndex].settings.trimSilence && scanned.audibleEnd > scanned.audibleStart)
+            {
+                startFrame = scanned.audibleStart;
+                frames = scanned.audibleEnd - scanned.audibleStart;
+            }
+            tempTable.add(scanned, static_cast<int>(layerIndex), startFrame, frames);  // Velocity layer set after building noteMappings
+
+            StreamingSample ss;
+            ss.preloadScale = profile.getScale(scanned.info.path.getFile());
+            tempSamples.push_back(std::move(ss));
+        }
+
+        LoadedLayer loaded;
+        loaded.layer = layers[layerIndex];
+        tempLayers.push_back(std::move(loaded));
     }
 
-    totalInstrumentFileSize = tempTotalSize;
-    maxRoundRobins = tempMaxRoundRobins;
+    // Build each layer's noteMappings; the first layer's also answers the UI queries
+    std::vector<std::vector<std::pair<int, int>>> noteVelocities(tempLayers.size());
+    for (size_t i = 0; i < tempTable.size(); ++i)
+        noteVelocities[tempTable.libraryLayers[i]].emplace_back(tempTable.midiNotes[i], tempTable.velocities[i]);
 
-    // Calculate max velocity layers across all notes
     int tempMaxVelLayers = 1;
-    for (const auto& [note, mapping] : noteMappings)
+    for (size_t layerIndex = 0; layerIndex < tempLayers.size(); ++layerIndex)
     {
-        int layers = static_cast<int>(mapping.velocityLayers.size());
-        if (layers > tempMaxVelLayers)
-            tempMaxVelLayers = layers;
+        auto& mappings = tempLayers[layerIndex].noteMappings;
+        mappings = buildNoteMappings(noteVelocities[layerIndex]);
+
+        // Max velocity layers across all notes of all layers
+        for (const auto& [note, mapping] : mappings)
+            tempMaxVelLayers = juce::jmax(tempMaxVelLayers, static_cast<int>(mapping.velocityLayers.size()));
     }
-    maxVelocityLayersGlobal = tempMaxVelLayers;
-    velocityLayerLimit = maxVelocityLayersGlobal;  // Default to max
-    roundRobinLimit = maxRoundRobins;  // Default to max
 
     // Calculate velocityLayerIndex for each sample based on its position in the note's sorted layers
+    for (size_t sampleIndex = 0; sampleIndex < tempTable.size(); ++sampleIndex)
     {
-        std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
-        for (auto& ss : streamingSamples)
+        const auto& mappings = tempLayers[tempTable.libraryLayers[sampleIndex]].noteMappings;
+        auto noteIt = mappings.find(tempTable.midiNotes[sampleIndex]);
+        if (noteIt != mappings.end())
         {
-            auto noteIt = noteMappings.find(ss.midiNote);
-            if (noteIt != noteMappings.end())
+            const auto& velocityLayers = noteIt->second.velocityLayers;
+            for (size_t i = 0; i < velocityLayers.size(); ++i)
             {
-                const auto& layers = noteIt->second.velocityLayers;
-                for (size_t i = 0; i < layers.size(); ++i)
+                if (velocityLayers[i].velocityValue == tempTable.velocities[sampleIndex])
                 {
-                    if (layers[i].velocityValue == ss.velocity)
-                    {
-                        ss.velocityLayerIndex = static_cast<int>(i);
-                        break;
-                    }
+                    tempTable.velocityLayerIndices[sampleIndex] = static_cast<int16_t>(i);
+                    break;
                 }
             }
         }
     }
 
-    engineDebugLog("Loaded " + juce::String(streamingSamples.size()) + " samples (metadata only)");
+    {
+        std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+        streamingSamples = std::move(tempSamples);
+        sampleTable = std::move(tempTable);
+        libraryLayers = std::move(tempLayers);
+        noteMappings = libraryLayers.front().noteMappings;
+        ++libraryGeneration;
+    }
+
+    totalInstrumentFileSize = tempTotalSize;
+    maxRoundRobins = tempMaxRoundRobins;
+    maxVelocityLayersGlobal = tempMaxVelLayers;
+    velocityLayerLimit = maxVelocityLayersGlobal;  // Default to max
+    roundRobinLimit = maxRoundRobins;  // Default to max (the audio thread gets it with the swap)
+
+    // Sizes first: the working set weighs in on the RAM budget
+    applyRestoredWorkingSet();
+    rebalancePreloadBudget();
+
+    // Preloads a snapshot holds for this library and configuration are mapped, not read
+    const int snapshotCount = adoptSnapshotPreloads();
+
+    engineDebugLog("Loaded " + juce::String(streamingSamples.size()) + " samples");
+    engineDebugLog("Preloads from snapshot: " + juce::String(snapshotCount));
     engineDebugLog("Max round-robins: " + juce::String(maxRoundRobins));
     engineDebugLog("Max velocity layers: " + juce::String(maxVelocityLayersGlobal));
     engineDebugLog("Total file size: " + juce::String(tempTotalSize / (1024 * 1024)) + " MB");
 
-    // Preload samples that are within the current limits
-    updatePreloadedSamples();
-
-    // Re-register voices with DiskStreamer
-    if (diskStreamer)
+    // Stage 1 (one layer and round robin per note) loads here, so the library plays
+    // within moments; the preload worker fills in the remaining stages behind it
+    std::vector<size_t> firstStage;
+    std::vector<size_t> workingSet;
     {
-        for (int i = 0; i < StreamingConstants::maxStreamingVoices; ++i)
+        std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+        assignLoadStages();
+
+        int64_t bytesToPreload = 0;
+        for (size_t i = 0; i < streamingSamples.size(); ++i)
         {
-            diskStreamer->registerVoice(i, &streamingVoices[static_cast<size_t>(i)]);
-        }
-    }
+            const auto& ss = streamingSamples[i];
+            if (!shouldSampleBePreloaded(i))
+                continue;
 
-    loadingState = LoadingState::Loaded;
-}
+            bytesToPreload += getTargetPreloadBytes(i);
+            if (ss.loadStage == LoadStage::Playable && ss.preload == nullptr)
+                firstStage.push_back(i);
+        }
 
-const SamplerEngine::StreamingSample* SamplerEngine::findStreamingSample(int midiNote, int velocity, int roundRobin) const
-{
-    int actualNote = midiNote;
-    auto it = noteMappings.find(midiNote);
-    if (it != noteMappings.end() && it->second.fallbackNote >= 0)
-    {
-        actualNote = it->second.fallbackNote;
-    }
+        loadPreloadStartMs = juce::Time::getMillisecondCounter();
+        loadBytesToPreload = bytesToPreload;
 
-    auto noteIt = noteMappings.find(actualNote);
-    if (noteIt == noteMappings.end())
-        return nullptr;
+        // The restored working set goes first, most-played first
+        auto plays = [this](size_t index) { return (*sampleUsage)[index].plays.load(std::memory_order_relaxed); };
+        std::stable_sort(firstStage.begin(), firstStage.end(), [&plays](size_t a, size_t b) { return plays(a) > plays(b); });
 
-    const auto& layers = noteIt->second.velocityLayers;
-    int totalLayers = static_cast<int>(layers.size());
-    if (totalLayers == 0)
-        return nullptr;
+        for (size_t i = 0; i < streamingSamples.size(); ++i)
+        {
+            if ((*sampleUsage)[i].framesPlayed.load(std::memory_order_relaxed) > 0)
+                workingSet.push_back(i);
+        }
+        std::stable_sort(workingSet.begin(), workingSet.end(), [&plays](size_t a, size_t b) { return plays(a) > plays(b); });
+    }
 
-    // Apply velocity layer limit (use first N layers, redistribute velocity evenly)
-    int effectiveLayers = std::min(velocityLayerLimit, totalLayers);
+    const auto stageStartTime = juce::Time::getMillisecondCounter();
 
-    // Map incoming velocity (1-127) to limited layer index
-    // Evenly distribute: velocity 1-127 maps to layers 0 to (effectiveLayers-1)
-    int layerIndex = ((velocity - 1) * effectiveLayers) / 127;
-    layerIndex = juce::jlimit(0, effectiveLayers - 1, layerIndex);
+    // Blocks are taken in note and layer order before the parallel reads, so the stage's
+    // preloads sit together in the arena whatever order the reads finish in
+    std::vector<std::unique_ptr<PreloadedSample>> firstStagePreloads(firstStage.size());
+    {
+        std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+        std::vector<size_t> order(firstStage.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+        {
+            return packsBefore(firstStage[a], firstStage[b]);
+        });
 
-    // Get the velocity value of the target layer
-    int targetVelocity = layers[static_cast<size_t>(layerIndex)].velocityValue;
+        for (size_t i : order)
+        {
+            const size_t index = firstStage[i];
+            firstStagePreloads[i] = allocatePreload(preloadArena, sampleTable.describe(index), getTargetPreloadFrames(index),
+                                                    getTargetCompactBits(index));
+        }
+    }
 
-    // Find the sample with matching note, velocity, and round-robin
-    // Only return preloaded samples
-    const StreamingSample* fallbackSample = nullptr;
-    for (const auto& ss : streamingSamples)
+    LibraryScanner::forEachInParallel(firstStage.size(), 0, [&](size_t i)
     {
-        if (ss.midiNote == actualNote && ss.velocity == targetVelocity && ss.isPreloaded)
+        if (isLoadCancelled() || firstStagePreloads[i] == nullptr)
+            return;
+
+        if (!extendPreload(*firstStagePreloads[i]))
         {
-            if (ss.roundRobin == roundRobin)
-                return &ss;
-            // Track a fallback in case exact RR not found
-            if (fallbackSample == nullptr)
-                fallbackSample = &ss;
+            firstStagePreloads[i].reset();
+            return;
         }
-    }
 
-    return fallbackSample;
-}
+        loadBytesPreloaded += firstStagePreloads[i]->getPreloadBytes();
+    });
 
-void SamplerEngine::noteOn(int midiNote, int velocity, int roundRobin, int sampleOffset)
-{
-    // Find sample from offset note (for sample borrowing), but play at original midiNote pitch
-    int sampleNote = juce::jlimit(0, 127, midiNote + sampleOffset);
-    const StreamingSample* ss = findStreamingSample(sampleNote, velocity, roundRobin);
-    if (!ss)
+    if (isLoadCancelled())
+    {
+        engineDebugLog("Load cancelled in stage 1: " + folderPath);
         return;
+    }
 
-    // Polyphonic same-note: send existing voices to release phase (realistic piano behavior)
-    // This lets the old sound decay naturally while the new attack plays
-    for (auto& voice : streamingVoices)
     {
-        if (voice.isActive() && voice.getPlayingNote() == midiNote && !voice.isQuickFadingOut())
+        std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+        for (size_t i = 0; i < firstStage.size(); ++i)
         {
-            voice.stopVoiceWithCustomRelease(sameNoteReleaseTime, currentSampleRate);
+            auto& ss = streamingSamples[firstStage[i]];
+            if (ss.preload == nullptr)
+                ss.preload = std::move(firstStagePreloads[i]);
         }
+
+        // Swap: new note-ons play the new library from the next audio block on
+        mapVelocityLayerLimit = velocityLayerLimit;
+        libraryStaging = false;
+        publishSampleMap();
+        retirePreloads(std::move(outgoingPreloads));
+        outgoingPreloads.clear();
+        preloadMemoryBytes = computePreloadMemoryBytes();
+        loadStage = LoadStage::Playable;
     }
 
-    // Count how many voices are currently playing this note
-    int voicesForThisNote = 0;
-    for (const auto& voice : streamingVoices)
+    EngineCommand rrCommand;
+    rrCommand.type = EngineCommand::Type::setRoundRobinLimit;
+    rrCommand.intValue = roundRobinLimit.load();
+    pushCommand(rrCommand);
+
+    engineDebugLog("Load stage 1: " + juce::String(static_cast<int>(firstStage.size())) + " samples in " +
+                   juce::String(juce::Time::getMillisecondCounter() - stageStartTime) + " ms");
+
+    loadingState = LoadingState::Loaded;
+
+    // Streamed parts of the working set next, then remaining layers and round robins
+    warmStreamedRegions(workingSet);
+    if (isLoadCancelled())
+        return;
+
+    preloadWorker->requestWork();
+}
+
+PreloadSnapshot::Config SamplerEngine::getPreloadSnapshotConfig(int layerIndex) const
+{
+    // With a budget or adaptive sizing, sizes are per sample; the entries say what each one has
+    PreloadSnapshot::Config config;
+    config.budgetMB = preloadBudgetMB;
+    config.preloadSizeKB = (config.budgetMB > 0 || adaptivePreloadSizing.load()) ? 0 : preloadSizeKB.load();
+    config.velocityLayerLimit = getLayerVelocityLimit(layerIndex);
+    config.roundRobinLimit = getLayerRoundRobinLimit(layerIndex);
+    config.compactPreloads = compactPreloadStorage.load();
+    return config;
+}
+
+int SamplerEngine::adoptSnapshotPreloads()
+{
+    int numLayers = 0;
     {
-        if (voice.isActive() && voice.getPlayingNote() == midiNote)
-        {
-            voicesForThisNote++;
-        }
+        std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+        numLayers = static_cast<int>(libraryLayers.size());
     }
 
-    // If we exceed the per-note limit, fade out the oldest voice with 10ms fade (no clicks)
-    if (voicesForThisNote >= maxVoicesPerNote)
+    // Each layer has its folder's snapshot
+    int adopted = 0;
+    for (int layerIndex = 0; layerIndex < numLayers; ++layerIndex)
     {
-        uint64_t oldestCounter = UINT64_MAX;
-        StreamingVoice* oldestVoice = nullptr;
-
-        for (auto& voice : streamingVoices)
+        PreloadSnapshot::Config config;
+        juce::File folder;
+        std::vector<size_t> wanted;
+        std::vector<PreloadedSample> infos;
+        std::vector<int> frames;
         {
-            if (voice.isActive() && voice.getPlayingNote() == midiNote)
+            std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+            config = getPreloadSnapshotConfig(layerIndex);
+            folder = libraryLayers[static_cast<size_t>(layerIndex)].layer.folder;
+            for (size_t i = 0; i < streamingSamples.size(); ++i)
             {
-                if (voice.getVoiceStartCounter() < oldestCounter)
+                if (sampleTable.libraryLayers[i] == layerIndex && shouldSampleBePreloaded(i) && streamingSamples[i].preload == nullptr)
                 {
-                    oldestCounter = voice.getVoiceStartCounter();
-                    oldestVoice = &voice;
+                    wanted.push_back(i);
+                    infos.push_back(sampleTable.describe(i));
+                    frames.push_back(getTargetPreloadFrames(i));
                 }
             }
         }
 
-        if (oldestVoice != nullptr)
+        PreloadSnapshot snapshot(folder, config, getCacheSubdirectory("PreloadSnapshots"));
+        if (wanted.empty() || !snapshot.open())
+            continue;
+
+        // Only checks file sizes and times; no sample data is touched until a voice plays it
+        std::vector<std::unique_ptr<PreloadedSample>> preloads;
+        preloads.reserve(infos.size());
+        for (size_t i = 0; i < infos.size(); ++i)
+            preloads.push_back(snapshot.createPreload(infos[i], frames[i]));
+
+        // Mapped pages aren't in the arena: when memory is locked, at least fault them in now
+        if (preloadArena.getLockMemory())
+        {
+            for (const auto& preload : preloads)
+                if (preload != nullptr)
+                    touchPreload(*preload);
+        }
+
+        std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+
+        int layerAdopted = 0;
+        for (size_t i = 0; i < wanted.size(); ++i)
         {
-            oldestVoice->startQuickFadeOut(currentSampleRate);
+            auto& ss = streamingSamples[wanted[i]];
+            if (preloads[i] != nullptr && ss.preload == nullptr)
+            {
+                loadBytesPreloaded += preloads[i]->getPreloadBytes();
+                ss.preload = std::move(preloads[i]);
+                ++layerAdopted;
+            }
         }
+
+        // An exact match needs no rewrite once the remaining stages are in
+        if (static_cast<size_t>(layerAdopted) == wanted.size() && snapshot.getNumEntries() == layerAdopted)
+            libraryLayers[static_cast<size_t>(layerIndex)].snapshotConfig = config;
+
+        adopted += layerAdopted;
     }
 
-    // Increment global voice counter for age tracking
-    ++voiceStartCounterGlobal;
+    return adopted;
+}
 
-    // Find a free streaming voice
-    for (size_t i = 0; i < streamingVoices.size(); ++i)
+void SamplerEngine::writePreloadSnapshot(uint32_t generation)
+{
+    for (int layerIndex = 0;; ++layerIndex)
     {
-        if (!streamingVoices[i].isActive())
+        PreloadSnapshot::Config config;
+        juce::File folder;
+        std::vector<const PreloadedSample*> preloads;
         {
-            juce::ADSR::Parameters adsrJuceParams;
-            adsrJuceParams.attack = adsrParams.attack;
-            adsrJuceParams.decay = adsrParams.decay;
-            adsrJuceParams.sustain = adsrParams.sustain;
-            adsrJuceParams.release = adsrParams.release;
-            streamingVoices[i].setADSRParameters(adsrJuceParams);
+            std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+            if (generation != libraryGeneration || layerIndex >= static_cast<int>(libraryLayers.size()))
+                return;
 
-            streamingVoices[i].startVoice(&ss->preload, midiNote,
-                                           static_cast<float>(velocity) / 127.0f, currentSampleRate,
-                                           voiceStartCounterGlobal);
-            return;
+            const auto& layer = libraryLayers[static_cast<size_t>(layerIndex)];
+            config = getPreloadSnapshotConfig(layerIndex);
+            if (layer.snapshotConfig == config)
+                continue;
+
+            folder = layer.layer.folder;
+            for (size_t i = 0; i < streamingSamples.size(); ++i)
+            {
+                if (sampleTable.libraryLayers[i] == layerIndex && streamingSamples[i].preload != nullptr)
+                    preloads.push_back(streamingSamples[i].preload.get());
+            }
+
+            // Written without the lock: preloads retired meanwhile are freed only afterwards
+            snapshotWriteInProgress = true;
         }
-    }
 
-    // No free voice - steal the oldest voice globally (with 10ms fade)
-    uint64_t oldestCounter = UINT64_MAX;
-    size_t oldestIndex = 0;
+        const auto startTime = juce::Time::getMillisecondCounter();
+        const bool written = PreloadSnapshot(folder, config, getCacheSubdirectory("PreloadSnapshots")).write(preloads, [this]
+        {
+            return preloadWorker->threadShouldExit() || preloadWorker->hasPendingRequest();
+        });
+        snapshotWriteInProgress = false;
+
+        if (!written)
+            return;  // Cancelled by a newer job (which writes again once complete), or the disk failed
 
-    for (size_t i = 0; i < streamingVoices.size(); ++i)
-    {
-        if (streamingVoices[i].getVoiceStartCounter() < oldestCounter)
         {
-            oldestCounter = streamingVoices[i].getVoiceStartCounter();
-            oldestIndex = i;
+            std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+            if (generation == libraryGeneration)
+                libraryLayers[static_cast<size_t>(layerIndex)].snapshotConfig = config;
         }
+
+        engineDebugLog("Preload snapshot: " + juce::String(static_cast<int>(preloads.size())) + " samples in " +
+                       juce::String(juce::Time::getMillisecondCounter() - startTime) + " ms: " +
+                       folder.getFullPathName());
     }
+}
+
+void SamplerEngine::applyRestoredWorkingSet()
+{
+    std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+
+    sampleUsage = std::make_shared<SampleUsageTable>(streamingSamples.size());
 
-    juce::ADSR::Parameters adsrJuceParams;
-    adsrJuceParams.attack = adsrParams.attack;
-    adsrJuceParams.decay = adsrParams.decay;
-    adsrJuceParams.sustain = adsrParams.sustain;
-    adsrJuceParams.release = adsrParams.release;
-    streamingVoices[oldestIndex].setADSRParameters(adsrJuceParams);
-    streamingVoices[oldestIndex].startQuickFadeOut(currentSampleRate);
+    // Entries don't name a layer: layers with a sample for the same key all take it
+    std::multimap<std::tuple<int, int, int>, size_t> sampleByKey;
+    for (size_t i = 0; i < sampleTable.size(); ++i)
+        sampleByKey.emplace(std::make_tuple(sampleTable.midiNotes[i], sampleTable.velocities[i], sampleTable.roundRobins[i]), i);
 
-    // Start the new voice after a brief delay would be ideal, but for simplicity
-    // we find another free voice or use a different slot
-    // Actually, let's just start it - the old voice will fade out
-    for (size_t i = 0; i < streamingVoices.size(); ++i)
+    int matched = 0;
+    for (const auto& entry : restoredWorkingSet.entries)
     {
-        if (!streamingVoices[i].isActive())
+        auto range = sampleByKey.equal_range(std::make_tuple(entry.midiNote, entry.velocity, entry.roundRobin));
+        if (range.first == range.second)
+            continue;
+
+        for (auto it = range.first; it != range.second; ++it)
         {
-            streamingVoices[i].setADSRParameters(adsrJuceParams);
-            streamingVoices[i].startVoice(&ss->preload, midiNote,
-                                           static_cast<float>(velocity) / 127.0f, currentSampleRate,
-                                           voiceStartCounterGlobal);
-            return;
+            auto& usage = (*sampleUsage)[it->second];
+            usage.plays.store(entry.plays, std::memory_order_relaxed);
+            usage.framesPlayed.store(entry.framesPlayed, std::memory_order_relaxed);
         }
+        ++matched;
     }
 
-    // Still no free voice - force steal the oldest one immediately
-    streamingVoices[oldestIndex].stopVoice(false);
-    streamingVoices[oldestIndex].startVoice(&ss->preload, midiNote,
-                                             static_cast<float>(velocity) / 127.0f, currentSampleRate,
-                                             voiceStartCounterGlobal);
+    if (!restoredWorkingSet.entries.empty())
+        engineDebugLog("Working set: " + juce::String(matched) + " of " +
+                       juce::String(static_cast<int>(restoredWorkingSet.entries.size())) + " samples found");
+
+    restoredWorkingSet.entries.clear();  // One load only; the usage table carries it on
 }
 
-void SamplerEngine::noteOff(int midiNote)
+void SamplerEngine::warmStreamedRegions(const std::vector<size_t>& sampleIndices)
 {
-    for (auto& voice : streamingVoices)
+    constexpr int chunkBytes = 256 * 1024;
+    std::vector<char> scratch;
+    int64_t bytesWarmed = 0;
+    const auto startTime = juce::Time::getMillisecondCounter();
+
+    for (size_t index : sampleIndices)
     {
-        if (voice.isActive() && voice.getPlayingNote() == midiNote)
+        SamplePath path;
+        int64_t fileStartFrame = 0, fileSize = 0, dataOffset = 0, fileFrames = 0, framesPlayed = 0, preloadFrames = 0;
         {
-            voice.stopVoice(true);  // Allow tail off
+            std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+            if (sampleUsage == nullptr || index >= streamingSamples.size())
+                return;
+
+            path = sampleTable.paths[index];
+            fileStartFrame = sampleTable.fileStartFrames[index];
+            fileSize = sampleTable.fileSizes[index];
+            dataOffset = juce::jmax<int64_t>(0, sampleTable.dataOffsets[index]);
+            fileFrames = sampleTable.fileFrames[index];
+            framesPlayed = (*sampleUsage)[index].framesPlayed.load(std::memory_order_relaxed);
+            preloadFrames = getTargetPreloadFrames(index);
+        }
+        if (fileFrames <= 0 || framesPlayed <= preloadFrames)
+            continue;  // Everything played is already in the preload
+
+        // Frames map to bytes in proportion; exact for PCM, close enough for compressed files
+        auto byteAt = [&](int64_t frame)
+        {
+            const double fraction = static_cast<double>(juce::jmin(fileStartFrame + frame, fileFrames)) /
+                                    static_cast<double>(fileFrames);
+            return dataOffset + static_cast<int64_t>(fraction * static_cast<double>(fileSize - dataOffset));
+        };
+
+        juce::FileInputStream stream(path.getFile());
+        if (!stream.openedOk())
+            continue;
+
+        // Reading is what counts: the data lands in the OS file cache for the disk thread
+        scratch.resize(static_cast<size_t>(chunkBytes));
+        const int64_t end = byteAt(framesPlayed);
+        stream.setPosition(byteAt(preloadFrames));
+        for (int64_t position = stream.getPosition(); position < end; position += chunkBytes)
+        {
+            if (isLoadCancelled())
+                return;
+
+            const int toRead = static_cast<int>(juce::jmin<int64_t>(chunkBytes, end - position));
+            if (stream.read(scratch.data(), toRead) < toRead)
+                break;
+            bytesWarmed += toRead;
         }
     }
+
+    if (bytesWarmed > 0)
+        engineDebugLog("Warmed " + juce::String(bytesWarmed / 1024) + " KB of streamed working set in " +
+                       juce::String(juce::Time::getMillisecondCounter() - startTime) + " ms");
 }
 
-void SamplerEngine::processBlock(juce::AudioBuffer<float>& buffer)
+WorkingSet SamplerEngine::getWorkingSet() const
 {
-    const int numSamples = buffer.getNumSamples();
+    std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
 
-    juce::ADSR::Parameters adsrJuceParams;
-    adsrJuceParams.attack = adsrParams.attack;
-    adsrJuceParams.decay = adsrParams.decay;
-    adsrJuceParams.sustain = adsrParams.sustain;
-    adsrJuceParams.release = adsrParams.release;
+    // Nothing loaded yet: keep what was restored, so saving mid-load doesn't lose it
+    if (sampleUsage == nullptr)
+        return restoredWorkingSet;
 
-    for (auto& voice : streamingVoices)
+    // Layers sharing a key become one entry, with the most any of them played
+    WorkingSet workingSet;
+    std::map<std::tuple<int, int, int>, size_t> entryByKey;
+    for (size_t i = 0; i < streamingSamples.size(); ++i)
     {
-        voice.setADSRParameters(adsrJuceParams);
+        const auto& usage = (*sampleUsage)[i];
+        const uint32_t plays = usage.plays.load(std::memory_order_relaxed);
+        if (plays == 0)
+            continue;
 
-        if (voice.isActive())
+        const int midiNote = sampleTable.midiNotes[i], velocity = sampleTable.velocities[i], roundRobin = sampleTable.roundRobins[i];
+        const int64_t framesPlayed = usage.framesPlayed.load(std::memory_order_relaxed);
+        auto [it, isNew] = entryByKey.emplace(std::make_tuple(midiNote, velocity, roundRobin), workingSet.entries.size());
+        if (!isNew)
         {
-            voice.renderNextBlock(buffer, 0, numSamples);
+            auto& existing = workingSet.entries[it->second];
+            existing.plays = juce::jmax(existing.plays, plays);
+            existing.framesPlayed = juce::jmax(existing.framesPlayed, framesPlayed);
+            continue;
         }
-    }
-}
 
-int SamplerEngine::getActiveVoiceCount() const
-{
-    int count = 0;
-    for (const auto& voice : streamingVoices)
-    {
-        if (voice.isActive())
-            ++count;
+        WorkingSet::Entry entry;
+        entry.midiNote = midiNote;
+        entry.velocity = velocity;
+        entry.roundRobin = roundRobin;
+        entry.plays = plays;
+        entry.framesPlayed = framesPlayed;
+        workingSet.entries.push_back(entry);
     }
-    return count;
+    return workingSet;
 }
 
-int SamplerEngine::getStreamingVoiceCount() const
+void SamplerEngine::setWorkingSet(WorkingSet workingSet)
 {
-    int count = 0;
-    for (const auto& voice : streamingVoices)
-    {
-        if (voice.isActive() && voice.needsMoreData())
-            ++count;
-    }
-    return count;
+    std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+    restoredWorkingSet = std::move(workingSet);
 }
 
-float SamplerEngine::getDiskThroughputMBps() const
+void SamplerEngine::assignLoadStages()
 {
-    if (!diskStreamer)
-        return 0.0f;
+    std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
 
-    return diskStreamer->getThroughputMBps();
-}
+    // Lowest round robin present for each (library layer, note, layer), and the layer stage 1
+    // uses: the middle one, which the nearest-layer fallback can stretch over all velocities
+    const auto& table = sampleTable;
+    auto keyOf = [&table](size_t i)
+    {
+        return std::make_tuple(static_cast<int>(table.libraryLayers[i]), static_cast<int>(table.midiNotes[i]),
+                               static_cast<int>(table.velocityLayerIndices[i]));
+    };
 
-int SamplerEngine::getUnderrunCount() const
-{
-    return StreamingVoice::getUnderrunCount();
-}
+    std::map<std::tuple<int, int, int>, int> lowestRoundRobin;
+    for (size_t i = 0; i < table.size(); ++i)
+    {
+        auto key = keyOf(i);
+        auto it = lowestRoundRobin.find(key);
+        if (it == lowestRoundRobin.end() || table.roundRobins[i] < it->second)
+            lowestRoundRobin[key] = table.roundRobins[i];
+    }
 
-void SamplerEngine::resetUnderrunCount()
-{
-    StreamingVoice::resetUnderrunCount();
+    for (size_t index = 0; index < streamingSamples.size(); ++index)
+    {
+        auto& ss = streamingSamples[index];
+        const int libraryLayer = table.libraryLayers[index];
+        const auto& mappings = libraryLayers[static_cast<size_t>(libraryLayer)].noteMappings;
+        auto noteIt = mappings.find(table.midiNotes[index]);
+        const int numLayers = (noteIt != mappings.end()) ? static_cast<int>(noteIt->second.velocityLayers.size()) : 1;
+        const int firstLayer = juce::jmin(numLayers, getLayerVelocityLimit(libraryLayer)) / 2;
+        const bool isFirstRoundRobin = table.roundRobins[index] == lowestRoundRobin[keyOf(index)];
+        const bool inWorkingSet = sampleUsage != nullptr && (*sampleUsage)[index].plays.load(std::memory_order_relaxed) > 0;
+
+        if (inWorkingSet)
+            ss.loadStage = LoadStage::Playable;  // What the session played comes first
+        else if (!isFirstRoundRobin)
+            ss.loadStage = LoadStage::Complete;
+        else if (table.velocityLayerIndices[index] == firstLayer)
+            ss.loadStage = LoadStage::Playable;
+        else
+            ss.loadStage = LoadStage::AllLayers;
+    }
 }
 
-void SamplerEngine::reloadPreloadBuffers()
+
+void SamplerEngine::publishSampleMap()
 {
     std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
 
-    int64_t totalPreloadBytes = 0;
-    int reloadedCount = 0;
+    auto map = std::make_unique<SampleMap>();
 
-    for (auto& ss : streamingSamples)
+    map->samples.reserve(streamingSamples.size());
+    for (const auto& ss : streamingSamples)
+        map->samples.push_back(ss.preload.get());
+
+    // One lookup table per library layer, all indexing the one sample list
+    map->layers.resize(libraryLayers.size());
+    for (size_t layerIndex = 0; layerIndex < libraryLayers.size(); ++layerIndex)
     {
-        if (ss.isPreloaded)
+        const auto& layer = libraryLayers[layerIndex];
+        const auto& settings = layer.layer.settings;
+
+        std::array<SampleLookupTable::NoteLayout, 128> notes{};
+        for (const auto& [note, mapping] : layer.noteMappings)
         {
-            // Reload this sample's preload buffer with new size
-            loadSamplePreloadBuffer(ss);
-            reloadedCount++;
+            if (note < 0 || note > 127)
+                continue;
+
+            auto& layout = notes[static_cast<size_t>(note)];
+            layout.numVelocityLayers = static_cast<int>(mapping.velocityLayers.size());
+            layout.fallbackNote = mapping.fallbackNote;
+            layout.isMapped = true;
         }
 
-        if (ss.isPreloaded)
+        // Only the layer's own preloaded samples are playable
+        std::vector<SampleLookupTable::SampleKey> keys;
+        keys.reserve(streamingSamples.size());
+        for (size_t i = 0; i < streamingSamples.size(); ++i)
         {
-            totalPreloadBytes += static_cast<int64_t>(ss.preload.preloadBuffer.getNumSamples()) *
-                                 static_cast<int64_t>(ss.preload.numChannels) * static_cast<int64_t>(sizeof(float));
+            const bool playable = streamingSamples[i].preload != nullptr && sampleTable.libraryLayers[i] == layerIndex;
+
+            SampleLookupTable::SampleKey key;
+            key.midiNote = sampleTable.midiNotes[i];
+            key.velocityLayerIndex = playable ? sampleTable.velocityLayerIndices[i] : -1;
+            key.roundRobin = sampleTable.roundRobins[i];
+            keys.push_back(key);
         }
+
+        int limit = mapVelocityLayerLimit;
+        if (settings.velocityLayerLimit > 0)
+            limit = juce::jmin(limit, settings.velocityLayerLimit);
+
+        auto& layerMap = map->layers[layerIndex];
+        layerMap.lookup.build(notes, keys, limit);
+        layerMap.lowNote = settings.lowNote;
+        layerMap.highNote = settings.highNote;
+        layerMap.lowVelocity = settings.lowVelocity;
+        layerMap.highVelocity = settings.highVelocity;
+        layerMap.gain = settings.gain;
+        layerMap.roundRobinLimit = settings.roundRobinLimit;
     }
 
-    preloadMemoryBytes = totalPreloadBytes;
+    map->usage = sampleUsage;
+    map->libraryGeneration = libraryGeneration;
 
-    engineDebugLog("reloadPreloadBuffers: preloadSizeKB=" + juce::String(preloadSizeKB) +
-                   " reloaded=" + juce::String(reloadedCount) +
-                   " preloadMem=" + juce::String(totalPreloadBytes / 1024) + " KB");
-}
+    // Swap in; the audio thread may still be using the old map for this block
+    publishedSampleMap.store(map.get(), std::memory_order_release);
+    reclaimer.retire(std::move(currentSampleMap));
+    currentSampleMap = std::move(map);
 
-void SamplerEngine::setVelocityLayerLimit(int limit)
-{
-    int newLimit = juce::jlimit(1, juce::jmax(1, maxVelocityLayersGlobal), limit);
-    if (newLimit != velocityLayerLimit)
-    {
-        velocityLayerLimit = newLimit;
-        updatePreloadedSamples();
-    }
+    reclaimer.collect();
 }
 
-void SamplerEngine::setRoundRobinLimit(int limit)
+void SamplerEngine::retirePreloads(std::vector<std::unique_ptr<PreloadedSample>> preloads)
 {
-    int newLimit = juce::jlimit(1, juce::jmax(1, maxRoundRobins), limit);
-    if (newLimit != roundRobinLimit)
+    if (preloads.empty())
+        return;
+
+    // Voices keep a pointer to their sample after note-on, so wait for them too
+    std::vector<const PreloadedSample*> retiredSamples;
+    retiredSamples.reserve(preloads.size());
+    for (const auto& preload : preloads)
+        retiredSamples.push_back(preload.get());
+    std::sort(retiredSamples.begin(), retiredSamples.end());
+
+    auto isPlaying = [this, retiredSamples]
     {
-        roundRobinLimit = newLimit;
-        updatePreloadedSamples();
-    }
+        if (snapshotWriteInProgress.load())
+            return true;
+
+        for (const auto& voice : streamingVoices)
+        {
+            const PreloadedSample* sample = voice.getCurrentSample();
+            if (sample != nullptr && std::binary_search(retiredSamples.begin(), retiredSamples.end(), sample))
+                return true;
+        }
+        return false;
+    };
+
+    reclaimer.retire(std::make_unique<std::vector<std::unique_ptr<PreloadedSample>>>(std::move(preloads)), isPlaying);
 }
 
-bool SamplerEngine::shouldSampleBePreloaded(const StreamingSample& ss) const
+void SamplerEngine::noteOn(int midiNote, int velocity, int roundRobin, int sampleOffset)
 {
-    // Sample should be preloaded if:
+    // Audio thread: only the map pinned for this block is safe to read
+    const SampleMap* map = audioSampleMap;
+    if (map == nullptr)
+        return;
+
+    // Find sample from offset note (for sample borrowing), but play at original midiNote pitch
+    int sampleNote = juce::jlimit(0, 127, midiNote + sampleOffset);
+
+    // Every library layer whose key and velocity ranges hold the note adds a voice
+    struct LayerHit
+    {
+        int sampleIndex = -1;
+        float gain = 1.0f;
+    };
+    std::array<LayerHit, maxLibraryLayers> hits{};
+    int numHits = 0;
+    for (const auto& layer : map->layers)
+    {
+        if (numHits == maxLibraryLayers)
+            break;
+        if (midiNote < layer.lowNote || midiNote > layer.highNote ||
+            velocity < layer.lowVelocity || velocity > layer.highVelocity)
+            continue;
+
+        // Exact (note, layer, RR) match, else the first preloaded sample of the layer
+        const int layerRoundRobin = (layer.roundRobinLimit > 0 && roundRobin > layer.roundRobinLimit)
+                                  ? (roundRobin - 1) % layer.roundRobinLimit + 1
+                                  : roundRobin;
+        const int index = layer.lookup.find(sampleNote, velocity, layerRoundRobin);
+        if (index < 0 || index >= static_cast<int>(map->samples.size()) || map->samples[static_cast<size_t>(index)] == nullptr)
+            continue;
+
+        hits[static_cast<size_t>(numHits++)] = { index, layer.gain };
+    }
+
+    if (numHits == 0)
+        return;
+
+    // Polyphonic same-note: send existing voices to release phase (realistic piano behavior)
+    // This lets the old sound decay naturally while the new attack plays
+    for (int v = voicePool.getOldestForNote(midiNote); v != VoicePool::none; v = voicePool.getNextForNote(v))
+    {
+        auto& voice = streamingVoices[static_cast<size_t>(v)];
+        if (voice.isActive() && !voice.isQuickFadingOut())
+        {
+            voice.stopVoiceWithCustomRelease(audioParams.sameNoteReleaseTime, currentSampleRate);
+        }
+    }
+
+    // Increment global voice counter for age tracking
+    ++voiceStartCounterGlobal;
+    notePlayCounts[static_cast<size_t>(sampleNote)].fetch_add(1, std::memory_order_relaxed);
+
+    for (int i = 0; i < numHits; ++i)
+        startLayerVoice(midiNote, velocity, hits[static_cast<size_t>(i)].sampleIndex, hits[static_cast<size_t>(i)].gain, numHits);
+
+    activeVoiceCount.store(voicePool.getNumActive(), std::memory_order_relaxed);
+}
+
+void SamplerEngine::startLayerVoice(int midiNote, int velocity, int sampleIndex, float gain, int voicesPerNote)
+{
+    const PreloadedSample* sample = audioSampleMap->samples[static_cast<size_t>(sampleIndex)];
+
+    // If we exceed the per-note limit (per layer playing the note), fade out the oldest voice with 10ms fade (no clicks)
+    if (voicePool.getNumActiveForNote(midiNote) >= maxVoicesPerNote * voicesPerNote)
+    {
+        const int oldestForNote = voicePool.getOldestForNote(midiNote);
+        streamingVoices[static_cast<size_t>(oldestForNote)].startQuickFadeOut(currentSampleRate);
+    }
+
+    // Running out of voices: fade out the cheapest one now, while the reserve
+    // still has a voice for the new note
+    if (voicePool.getNumActive() >= StreamingConstants::maxStreamingVoices - stealReserveVoices)
+    {
+        const int victim = findVoiceToSteal();
+        if (victim != VoicePool::none)
+        {
+            auto& stolen = streamingVoices[static_cast<size_t>(victim)];
+            if (stolen.isReleasing())
+                stealCounters.releasedSteals.fetch_add(1, std::memory_order_relaxed);
+            else if (stolen.isSustainedByPedal())
+                stealCounters.pedalSustainedSteals.fetch_add(1, std::memory_order_relaxed);
+            else
+                stealCounters.heldSteals.fetch_add(1, std::memory_order_relaxed);
+            stealCounters.steals.fetch_add(1, std::memory_order_relaxed);
+
+            stolen.startQuickFadeOut(currentSampleRate);
+        }
+    }
+
+    const int voiceIndex = voicePool.allocate(midiNote);
+    if (voiceIndex == VoicePool::none)
+    {
+        // A burst of steals used up the reserve: skip the note rather than cut a voice
+        stealCounters.droppedNotes.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // The layer's gain rides on the velocity gain
+    auto& voice = streamingVoices[static_cast<size_t>(voiceIndex)];
+    voice.setADSRParameters(audioParams.adsr, audioParams.adsrGeneration);
+    voice.startVoice(sample, midiNote,
+                     static_cast<float>(velocity) / 127.0f * gain, currentSampleRate,
+                     voiceStartCounterGlobal);
+
+    // Working set: count the play; processBlock tracks how far it gets
+    voiceSampleIndex[static_cast<size_t>(voiceIndex)] = sampleIndex;
+    voiceLibraryGeneration[static_cast<size_t>(voiceIndex)] = audioSampleMap->libraryGeneration;
+    if (audioSampleMap->usage != nullptr && static_cast<size_t>(sampleIndex) < audioSampleMap->usage->size())
+    {
+        auto& usage = (*audioSampleMap->usage)[static_cast<size_t>(sampleIndex)];
+        usage.plays.fetch_add(1, std::memory_order_relaxed);
+
+        // Source frames per output frame, as the voice reads it
+        const float playbackRate = static_cast<float>(std::pow(2.0, (midiNote - sample->rootNote) / 12.0)
+                                                      * sample->sampleRate / currentSampleRate);
+        if (playbackRate > usage.peakPlaybackRate.load(std::memory_order_relaxed))
+            usage.peakPlaybackRate.store(playbackRate, std::memory_order_relaxed);
+    }
+}
+
+void SamplerEngine::noteOff(int midiNote)
+{
+    if (midiNote < 0 || midiNote > 127)
+        return;
+
+    for (int v = voicePool.getOldestForNote(midiNote); v != VoicePool::none; v = voicePool.getNextForNote(v))
+    {
+        auto& voice = streamingVoices[static_cast<size_t>(v)];
+        if (voice.isActive())
+        {
+            voice.stopVoice(true);  // Allow tail off
+        }
+    }
+}
+
+void SamplerEngine::noteSustainedByPedal(int midiNote)
+{
+    if (midiNote < 0 || midiNote > 127)
+        return;
+
+    for (int v = voicePool.getOldestForNote(midiNote); v != VoicePool::none; v = voicePool.getNextForNote(v))
+    {
+        auto& voice = streamingVoices[static_cast<size_t>(v)];
+        if (voice.isActive() && !voice.isReleasing())
+            voice.noteReleasedWithPedal(true);
+    }
+}
+
+int SamplerEngine::findVoiceToSteal() const
+{
+    const VoiceStealingPolicy* policy = stealingPolicy.load(std::memory_order_acquire);
+
+    // Oldest first, so ties go to the oldest voice
+    int bestVoice = VoicePool::none;
+    double bestCost = 0.0;
+
+    for (int v = voicePool.getOldestActive(); v != VoicePool::none; v = voicePool.getNextActive(v))
+    {
+        const auto& voice = streamingVoices[static_cast<size_t>(v)];
+        if (!voice.isActive() || voice.isQuickFadingOut())
+            continue;  // Already on its way out
+
+        if (policy == nullptr)
+            return v;
+
+        VoiceStealInfo info;
+        info.isReleasing = voice.isReleasing();
+        info.isSustainedByPedal = voice.isSustainedByPedal();
+        info.isStreamingFromDisk = voice.isStreamingFromDisk();
+        info.velocity = voice.getVelocity();
+        info.currentLevel = voice.getCurrentLevel();
+        info.startCounter = voice.getVoiceStartCounter();
+
+        const double cost = policy->getStealCost(info);
+        if (bestVoice == VoicePool::none || cost < bestCost)
+        {
+            bestVoice = v;
+            bestCost = cost;
+        }
+    }
+
+    return bestVoice;
+}
+
+void SamplerEngine::setVoiceStealingPolicy(std::unique_ptr<VoiceStealingPolicy> policy)
+{
+    if (policy == nullptr)
+        return;
+
+    std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+
+    // The audio thread may be scoring voices with the old policy right now
+    stealingPolicy.store(policy.get(), std::memory_order_release);
+    reclaimer.retire(std::move(currentStealingPolicy));
+    currentStealingPolicy = std::move(policy);
+
+    reclaimer.collect();
+}
+
+SamplerEngine::VoiceStealStats SamplerEngine::getVoiceStealStats() const
+{
+    VoiceStealStats stats;
+    stats.steals = stealCounters.steals.load(std::memory_order_relaxed);
+    stats.releasedSteals = stealCounters.releasedSteals.load(std::memory_order_relaxed);
+    stats.pedalSustainedSteals = stealCounters.pedalSustainedSteals.load(std::memory_order_relaxed);
+    stats.heldSteals = stealCounters.heldSteals.load(std::memory_order_relaxed);
+    stats.droppedNotes = stealCounters.droppedNotes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void SamplerEngine::resetVoiceStealStats()
+{
+    stealCounters.steals.store(0, std::memory_order_relaxed);
+    stealCounters.releasedSteals.store(0, std::memory_order_relaxed);
+    stealCounters.pedalSustainedSteals.store(0, std::memory_order_relaxed);
+    stealCounters.heldSteals.store(0, std::memory_order_relaxed);
+    stealCounters.droppedNotes.store(0, std::memory_order_relaxed);
+}
+
+void SamplerEngine::processBlock(juce::AudioBuffer<float>& buffer)
+{
+    const int numSamples = buffer.getNumSamples();
+    SampleUsageTable* usage = (audioSampleMap != nullptr) ? audioSampleMap->usage.get() : nullptr;
+
+    // Only active voices are visited; free ones get their ADSR at note-on
+    for (int v = voicePool.getOldestActive(); v != VoicePool::none;)
+    {
+        const int next = voicePool.getNextActive(v);
+        auto& voice = streamingVoices[static_cast<size_t>(v)];
+
+        // Re-apply the ADSR only after it changed (keeps custom same-note releases intact)
+        if (voice.getADSRGeneration() != audioParams.adsrGeneration)
+            voice.setADSRParameters(audioParams.adsr, audioParams.adsrGeneration);
+
+        if (voice.isActive())
+        {
+            voice.renderNextBlock(buffer, 0, numSamples);
+
+            // Furthest point reached, for the working set (voices of an older library are skipped),
+            // and the voice's own underruns, for the RAM budget
+            const size_t sampleIndex = static_cast<size_t>(voiceSampleIndex[static_cast<size_t>(v)]);
+            if (usage != nullptr && sampleIndex < usage->size() &&
+                voiceLibraryGeneration[static_cast<size_t>(v)] == audioSampleMap->libraryGeneration)
+            {
+                auto& sampleUsageEntry = (*usage)[sampleIndex];
+                const int64_t position = voice.getSourceReadPosition();
+                if (position > sampleUsageEntry.framesPlayed.load(std::memory_order_relaxed))
+                    sampleUsageEntry.framesPlayed.store(position, std::memory_order_relaxed);
+
+                if (voice.takeUnderran())
+                    sampleUsageEntry.underruns.fetch_add(1, std::memory_order_relaxed);
+
+                // And how late the first refill came, for adaptive sizing
+                const float refillLag = voice.takeRefillLag();
+                if (refillLag > sampleUsageEntry.refillLag.load(std::memory_order_relaxed))
+                    sampleUsageEntry.refillLag.store(refillLag, std::memory_order_relaxed);
+            }
+        }
+
+        // Finished voices (release done, end of sample) go back to the free list
+        if (!voice.isActive())
+            voicePool.release(v);
+
+        v = next;
+    }
+
+    activeVoiceCount.store(voicePool.getNumActive(), std::memory_order_relaxed);
+}
+
+int SamplerEngine::getActiveVoiceCount() const
+{
+    return activeVoiceCount.load(std::memory_order_relaxed);
+}
+
+int SamplerEngine::getStreamingVoiceCount() const
+{
+    int count = 0;
+    for (const auto& voice : streamingVoices)
+    {
+        if (voice.isActive() && voice.needsMoreData())
+            ++count;
+    }
+    return count;
+}
+
+float SamplerEngine::getDiskThroughputMBps() const
+{
+    if (!diskStreamer)
+        return 0.0f;
+
+    return diskStreamer->getThroughputMBps();
+}
+
+int SamplerEngine::getUnderrunCount() const
+{
+    return StreamingVoice::getUnderrunCount();
+}
+
+void SamplerEngine::resetUnderrunCount()
+{
+    StreamingVoice::resetUnderrunCount();
+}
+
+void SamplerEngine::reloadPreloadBuffers()
+{
+    // The preload worker resizes what is loaded: see resizePreloads()
+    preloadWorker->requestWork();
+}
+
+void SamplerEngine::setPreloadBudgetMB(int budgetMB)
+{
+    const int newBudget = juce::jmax(0, budgetMB);
+    if (preloadBudgetMB.exchange(newBudget) != newBudget)
+        preloadWorker->requestWork();  // Rebalances, then resizes what is loaded
+}
+
+void SamplerEngine::setAdaptivePreloadSizing(bool enabled)
+{
+    if (adaptivePreloadSizing.exchange(enabled) != enabled)
+        preloadWorker->requestWork();  // Learned sizes apply (or go) like a budget change
+}
+
+void SamplerEngine::setLockPreloadMemory(bool enabled)
+{
+    preloadArena.setLockMemory(enabled);
+
+    int locked = 0;
+    int failures = 0;
+    for (auto& voice : streamingVoices)
+    {
+        if (voice.setRingLocked(enabled))
+            ++locked;
+        else if (enabled)
+            ++failures;
+    }
+    lockedRings = locked;
+    ringLockFailures = failures;
+
+    if (enabled)
+        touchMappedPreloads();
+
+    reportMemoryLockFailures();
+}
+
+SamplerEngine::MemoryLockStatus SamplerEngine::getMemoryLockStatus() const
+{
+    const auto stats = preloadArena.getStats();
+    MemoryLockStatus status;
+    status.enabled = preloadArena.getLockMemory();
+    status.lockedBytes = stats.lockedBytes + static_cast<int64_t>(lockedRings.load()) *
+                                                 static_cast<int64_t>(streamingVoices.front().getRingBytes());
+    status.lockLimitBytes = MemoryLock::getLockLimit();
+    status.failures = stats.lockFailures + ringLockFailures.load();
+    return status;
+}
+
+void SamplerEngine::touchMappedPreloads()
+{
+    std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+    for (const auto& ss : streamingSamples)
+    {
+        if (ss.preload != nullptr && ss.preload->mapped)
+            touchPreload(*ss.preload);
+    }
+}
+
+void SamplerEngine::reportMemoryLockFailures()
+{
+    // New slabs lock as loads create them, so failures can show up long after the setting
+    if (!preloadArena.getLockMemory())
+    {
+        reportedLockFailures = 0;
+        return;
+    }
+
+    const auto status = getMemoryLockStatus();
+    if (status.failures <= reportedLockFailures)
+        return;
+
+    reportedLockFailures = status.failures;
+    engineDebugLog("Memory lock refused for " + juce::String(status.failures) + " slabs/rings (" +
+                   juce::String(status.lockedBytes / 1024) + " KB locked, RLIMIT_MEMLOCK " +
+                   (status.lockLimitBytes < 0 ? juce::String("unlimited") : juce::String(status.lockLimitBytes / 1024) + " KB") +
+                   "); pre-touched instead. Raise the limit (ulimit -l, limits.conf) to lock them.");
+}
+
+void SamplerEngine::setMemoryPressureResponse(bool enabled)
+{
+    if (memoryPressureResponse.exchange(enabled) == enabled || enabled)
+        return;
+
+    // Off: whatever was given back is restored at once
+    memoryPressureLevel = MemoryPressure::Level::normal;
+    if (memoryPressureStep.exchange(0) != 0)
+    {
+        logMemoryPressure({}, "Memory pressure response off: restoring preloads");
+        preloadWorker->requestWork();
+    }
+}
+
+void SamplerEngine::setMemoryPressureSource(std::function<MemoryPressure::Reading()> source)
+{
+    std::lock_guard<std::mutex> lock(memoryPressureMutex);
+    memoryPressureSource = std::move(source);
+}
+
+std::vector<SamplerEngine::MemoryPressureEvent> SamplerEngine::getMemoryPressureLog() const
+{
+    std::lock_guard<std::mutex> lock(memoryPressureMutex);
+    return { memoryPressureLog.begin(), memoryPressureLog.end() };
+}
+
+void SamplerEngine::logMemoryPressure(const MemoryPressure::Reading& reading, const juce::String& message)
+{
+    MemoryPressureEvent event;
+    event.timeMs = juce::Time::getMillisecondCounter();
+    event.level = memoryPressureLevel.load();
+    event.step = getMemoryPressureStep();
+    event.availableBytes = reading.availableBytes;
+    event.preloadBytes = preloadMemoryBytes.load();
+    event.message = message;
+
+    engineDebugLog(message + " (" + (reading.isKnown() ? juce::String(reading.availableBytes / (1024 * 1024)) + " of " +
+                                                          juce::String(reading.totalBytes / (1024 * 1024)) + " MB available" +
+                                                          (reading.fromCgroup ? " in cgroup" : "")
+                                                        : juce::String("no reading")) +
+                   ", preloads " + juce::String(event.preloadBytes / 1024) + " KB)");
+
+    std::lock_guard<std::mutex> lock(memoryPressureMutex);
+    memoryPressureLog.push_back(std::move(event));
+    while (memoryPressureLog.size() > static_cast<size_t>(maxMemoryPressureEvents))
+        memoryPressureLog.pop_front();
+}
+
+void SamplerEngine::checkMemoryPressure()
+{
+    // Each step gets time to take effect (and its retired preloads to be freed) before the next
+    constexpr juce::uint32 pressureCheckIntervalMs = 500;
+    const auto now = juce::Time::getMillisecondCounter();
+    if (!memoryPressureResponse.load() || now - lastPressureCheckMs < pressureCheckIntervalMs)
+        return;
+    lastPressureCheckMs = now;
+
+    std::function<MemoryPressure::Reading()> source;
+    {
+        std::lock_guard<std::mutex> lock(memoryPressureMutex);
+        source = memoryPressureSource;
+    }
+    const auto reading = source ? source() : MemoryPressure::read();
+
+    const MemoryPressure::Thresholds thresholds;
+    const auto previousLevel = memoryPressureLevel.load();
+    const auto level = MemoryPressure::nextLevel(previousLevel, reading, thresholds);
+    if (level != previousLevel)
+    {
+        memoryPressureLevel = level;
+        logMemoryPressure(reading, "Memory pressure " + MemoryPressure::getLevelName(level));
+    }
+
+    // Low pressure goes as far as minimum preloads, critical all the way. Steps are taken while
+    // memory is still short and undone, last first, once the level allows
+    const int step = memoryPressureStep.load();
+    const int maxStep = static_cast<int>(level == MemoryPressure::Level::critical ? PressureStep::firstStageOnly
+                                       : level == MemoryPressure::Level::low      ? PressureStep::minimumPreloads
+                                                                                  : PressureStep::none);
+    int nextStep = step;
+    if (step > maxStep)
+        nextStep = step - 1;
+    else if (step < maxStep && reading.getAvailableFraction() < thresholds.lowFraction)
+        nextStep = step + 1;
+    if (nextStep == step)
+        return;
+
+    static const char* const takenMessages[] = { "", "Storing preloads compact", "Shrinking preloads to the minimum size",
+                                                 "Keeping only first-stage preloads" };
+    static const char* const undoneMessages[] = { "Restoring float preloads", "Restoring preload sizes",
+                                                  "Reloading all preloads" };
+
+    memoryPressureStep = nextStep;
+    logMemoryPressure(reading, nextStep > step ? takenMessages[nextStep] : undoneMessages[nextStep]);
+    preloadWorker->requestWork();
+}
+
+void SamplerEngine::setCompactPreloads(bool enabled)
+{
+    if (compactPreloadStorage.exchange(enabled) != enabled)
+        preloadWorker->requestWork();  // Converts what is loaded; the budget now fits more frames
+}
+
+SamplerEngine::PreloadAllocation SamplerEngine::getPreloadAllocation() const
+{
+    std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+    return preloadAllocation;
+}
+
+int SamplerEngine::getPreloadSizeFrames(size_t index, int sizeKB) const
+{
+    const int numChannels = sampleTable.numChannels[index];
+    if (numChannels <= 0)
+        return 0;
+
+    const int framesToPreload = sizeKB * 1024 / (numChannels * static_cast<int>(sizeof(float)));
+    return static_cast<int>(std::min(static_cast<int64_t>(framesToPreload), sampleTable.totalFrames[index]));
+}
+
+int SamplerEngine::getTargetPreloadFrames(size_t index) const
+{
+    const auto& ss = streamingSamples[index];
+    const int frames = ss.preloadFrames >= 0 ? ss.preloadFrames : getPreloadSizeFrames(index, preloadSizeKB);
+    if (memoryPressureStep.load() >= static_cast<int>(PressureStep::minimumPreloads))
+        return std::min(frames, getPreloadSizeFrames(index, minPreloadSizeKB));
+    return frames;
+}
+
+int64_t SamplerEngine::getTargetPreloadBytes(size_t index) const
+{
+    const int compactBits = getTargetCompactBits(index);
+    const int bytesPerSample = compactBits != 0 ? compactBits / 8 : static_cast<int>(sizeof(float));
+    return static_cast<int64_t>(getTargetPreloadFrames(index)) * sampleTable.numChannels[index] * bytesPerSample;
+}
+
+bool SamplerEngine::rebalancePreloadBudget()
+{
+    std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+
+    const int64_t budgetBytes = static_cast<int64_t>(preloadBudgetMB.load()) * 1024 * 1024;
+    const bool adaptive = adaptivePreloadSizing.load();
+    const double hostSampleRate = budgetSampleRate.load();
+
+    // Without a budget, learned sizes share what preloadSizeKB would take
+    int64_t limitBytes = budgetBytes;
+
+    std::vector<size_t> indices;
+    std::vector<PreloadBudget::Request> requests;
+    for (size_t i = 0; i < streamingSamples.size(); ++i)
+    {
+        const auto& ss = streamingSamples[i];
+        if (!shouldSampleBePreloaded(i))
+            continue;
+
+        uint32_t plays = 0, underruns = 0;
+        double playbackRate = sampleTable.sampleRates[i] / hostSampleRate;
+        if (sampleUsage != nullptr)
+        {
+            const auto& usage = (*sampleUsage)[i];
+            plays = usage.plays.load(std::memory_order_relaxed);
+            underruns = usage.underruns.load(std::memory_order_relaxed);
+            if (const float peak = usage.peakPlaybackRate.load(std::memory_order_relaxed); peak > 0.0f)
+                playbackRate = peak;
+        }
+
+        PreloadBudget::Request request;
+        const int compactBits = getTargetCompactBits(i);
+        request.minFrames = getPreloadSizeFrames(i, minPreloadSizeKB);
+        request.maxFrames = getPreloadSizeFrames(i, maxPreloadSizeKB);
+        request.bytesPerFrame = sampleTable.numChannels[i] * (compactBits != 0 ? compactBits / 8 : static_cast<int>(sizeof(float)));
+        if (budgetBytes > 0)
+        {
+            request.weight = PreloadBudget::weightFor(request.bytesPerFrame, playbackRate, plays, underruns);
+            if (adaptive)
+                request.weight *= ss.preloadScale;
+        }
+        else if (adaptive)
+        {
+            // Each sample asks for its learned multiple of the knob's size; if they don't all
+            // fit, they are squeezed in proportion to it
+            const int knobFrames = getPreloadSizeFrames(i, preloadSizeKB);
+            limitBytes += static_cast<int64_t>(knobFrames) * request.bytesPerFrame;
+            request.maxFrames = juce::jlimit(request.minFrames, request.maxFrames,
+                                             static_cast<int>(static_cast<float>(knobFrames) * ss.preloadScale));
+            request.weight = static_cast<double>(request.bytesPerFrame) * ss.preloadScale;
+        }
+        indices.push_back(i);
+        requests.push_back(request);
+    }
+
+    std::vector<int> frames(indices.size());
+    PreloadAllocation allocation;
+    allocation.budgetBytes = budgetBytes;
+
+    const bool sized = limitBytes > 0;  // Per sample sizes; otherwise preloadSizeKB for all
+    if (sized)
+    {
+        auto result = PreloadBudget::allocate(requests, limitBytes);
+        allocation.floorsFit = result.floorsFit;
+
+        // Small moves aren't worth a resize: a sample keeps its size if it is within an
+        // eighth of the new one, as long as the total still fits
+        frames = result.frames;
+        int64_t keptBytes = 0;
+        for (size_t k = 0; k < indices.size(); ++k)
+        {
+            const int current = getTargetPreloadFrames(indices[k]);
+            if (std::abs(current - frames[k]) <= frames[k] / 8)
+                frames[k] = current;
+            keptBytes += static_cast<int64_t>(frames[k]) * requests[k].bytesPerFrame;
+        }
+        if (keptBytes > limitBytes)
+            frames = result.frames;
+    }
+    else
+    {
+        for (size_t k = 0; k < indices.size(); ++k)
+            frames[k] = getPreloadSizeFrames(indices[k], preloadSizeKB);
+    }
+
+    bool changed = false;
+    for (auto& ss : streamingSamples)
+    {
+        if (!sized && ss.preloadFrames >= 0)
+        {
+            ss.preloadFrames = -1;
+            changed = true;
+        }
+    }
+
+    allocation.samples = static_cast<int>(indices.size());
+    for (size_t k = 0; k < indices.size(); ++k)
+    {
+        auto& ss = streamingSamples[indices[k]];
+        if (sized && ss.preloadFrames != frames[k])
+        {
+            ss.preloadFrames = frames[k];
+            changed = true;
+        }
+
+        const int64_t bytes = static_cast<int64_t>(frames[k]) * requests[k].bytesPerFrame;
+        const int kb = static_cast<int>((bytes + 1023) / 1024);
+        allocation.allocatedBytes += bytes;
+        allocation.smallestKB = (k == 0) ? kb : juce::jmin(allocation.smallestKB, kb);
+        allocation.largestKB = juce::jmax(allocation.largestKB, kb);
+    }
+
+    preloadAllocation = allocation;
+    return changed;
+}
+
+void SamplerEngine::checkPreloadBudget()
+{
+    // Plays, underruns and refill lag move the budget's weights and the learned sizes:
+    // look again every couple of seconds
+    constexpr juce::uint32 budgetCheckIntervalMs = 2000;
+    const auto now = juce::Time::getMillisecondCounter();
+    const bool adaptive = adaptivePreloadSizing.load();
+    if ((preloadBudgetMB.load() <= 0 && !adaptive) || now - lastBudgetCheckMs < budgetCheckIntervalMs)
+        return;
+    lastBudgetCheckMs = now;
+
+    bool changed = false, learned = false;
+    {
+        std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+        if (libraryStaging || loadStage != LoadStage::Complete)
+            return;  // The job in progress (or the next one) rebalances anyway
+        learned = adaptive && adaptPreloadScales();
+        changed = rebalancePreloadBudget();
+    }
+
+    if (learned)
+        savePreloadProfiles();
+    if (changed)
+        preloadWorker->requestWork();
+}
+
+bool SamplerEngine::adaptPreloadScales()
+{
+    std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+    if (sampleUsage == nullptr || sampleUsage->size() != streamingSamples.size())
+        return false;
+
+    bool changed = false;
+    for (size_t i = 0; i < streamingSamples.size(); ++i)
+    {
+        auto& ss = streamingSamples[i];
+        auto& usage = (*sampleUsage)[i];
+
+        // Only what happened since the last look counts
+        const uint32_t underruns = usage.underruns.load(std::memory_order_relaxed);
+        const bool underran = underruns != ss.adaptedUnderruns;
+        ss.adaptedUnderruns = underruns;
+        const float refillLag = usage.refillLag.exchange(-1.0f, std::memory_order_relaxed);
+
+        const float scale = PreloadProfile::nextScale(ss.preloadScale, underran, refillLag);
+        if (scale != ss.preloadScale)
+        {
+            ss.preloadScale = scale;
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+void SamplerEngine::savePreloadProfiles() const
+{
+    std::vector<PreloadProfile> profiles;
+    {
+        std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+        const auto profileDirectory = getCacheSubdirectory("PreloadProfiles");
+        for (const auto& loaded : libraryLayers)
+            profiles.emplace_back(loaded.layer.folder, profileDirectory);
+
+        for (size_t i = 0; i < streamingSamples.size(); ++i)
+            profiles[sampleTable.libraryLayers[i]].setScale(sampleTable.paths[i].getFile(), streamingSamples[i].preloadScale);
+    }
+
+    // Written outside the lock; a layer loaded twice just writes the same profile twice
+    for (const auto& profile : profiles)
+        profile.save();
+}
+
+void SamplerEngine::setVelocityLayerLimit(int limit)
+{
+    int newLimit = juce::jlimit(1, juce::jmax(1, maxVelocityLayersGlobal), limit);
+    if (newLimit != velocityLayerLimit)
+    {
+        velocityLayerLimit = newLimit;
+        preloadWorker->requestWork();
+    }
+}
+
+void SamplerEngine::setRoundRobinLimit(int limit)
+{
+    int newLimit = juce::jlimit(1, juce::jmax(1, maxRoundRobins), limit);
+    if (newLimit != roundRobinLimit)
+    {
+        roundRobinLimit = newLimit;
+
+        EngineCommand command;
+        command.type = EngineCommand::Type::setRoundRobinLimit;
+        command.intValue = newLimit;
+        pushCommand(command);
+
+        preloadWorker->requestWork();
+    }
+}
+
+bool SamplerEngine::shouldSampleBePreloaded(size_t index) const
+{
+    // Sample should be preloaded if:
     // 1. Its velocity layer index is within the limit (0 to velocityLayerLimit-1)
     // 2. Its round robin is within the limit (1 to roundRobinLimit)
-    return (ss.velocityLayerIndex >= 0 &&
-            ss.velocityLayerIndex < velocityLayerLimit &&
-            ss.roundRobin >= 1 &&
-            ss.roundRobin <= roundRobinLimit);
+    // 3. Under critical memory pressure, it is in the first load stage
+    if (memoryPressureStep.load() >= static_cast<int>(PressureStep::firstStageOnly) &&
+        streamingSamples[index].loadStage != LoadStage::Playable)
+        return false;
+
+    const int libraryLayer = sampleTable.libraryLayers[index];
+    const int velocityLayerIndex = sampleTable.velocityLayerIndices[index];
+    const int roundRobin = sampleTable.roundRobins[index];
+    return (velocityLayerIndex >= 0 &&
+            velocityLayerIndex < getLayerVelocityLimit(libraryLayer) &&
+            roundRobin >= 1 &&
+            roundRobin <= getLayerRoundRobinLimit(libraryLayer));
+}
+
+int SamplerEngine::getLayerVelocityLimit(int layerIndex) const
+{
+    std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+
+    int limit = velocityLayerLimit;
+    if (layerIndex >= 0 && layerIndex < static_cast<int>(libraryLayers.size()))
+    {
+        const int layerLimit = libraryLayers[static_cast<size_t>(layerIndex)].layer.settings.velocityLayerLimit;
+        if (layerLimit > 0)
+            limit = juce::jmin(limit, layerLimit);
+    }
+    return limit;
+}
+
+int SamplerEngine::getLayerRoundRobinLimit(int layerIndex) const
+{
+    std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+
+    int limit = roundRobinLimit;
+    if (layerIndex >= 0 && layerIndex < static_cast<int>(libraryLayers.size()))
+    {
+        const int layerLimit = libraryLayers[static_cast<size_t>(layerIndex)].layer.settings.roundRobinLimit;
+        if (layerLimit > 0)
+            limit = juce::jmin(limit, layerLimit);
+    }
+    return limit;
+}
+
+SamplerEngine::PreloadProgress SamplerEngine::getPreloadProgress() const
+{
+    PreloadProgress progress;
+    progress.inProgress = preloadWorker->isBusy();
+    progress.samplesDone = preloadJobDone.load(std::memory_order_relaxed);
+    progress.samplesTotal = preloadJobTotal.load(std::memory_order_relaxed);
+    return progress;
 }
 
-void SamplerEngine::loadSamplePreloadBuffer(StreamingSample& ss)
+bool SamplerEngine::extendPreload(PreloadedSample& preload)
 {
+    const int frames = preload.getPreloadCapacity();
+    if (preload.preloadSizeFrames >= frames)
+        return true;
+
     auto reader = std::unique_ptr<juce::AudioFormatReader>(
-        formatManager.createReaderFor(juce::File(ss.preload.filePath)));
+        formatManager.createReaderFor(preload.path.getFile()));
     if (!reader)
-        return;
+        return false;
+
+    const int start = preload.preloadSizeFrames;
+    if (preload.compactBits == 0)
+    {
+        if (!reader->read(&preload.preloadBuffer, start, frames - start, preload.fileStartFrame + start, true, true))
+            return false;
+    }
+    else
+    {
+        // Read as float a chunk at a time and stored back as the file's integers
+        constexpr int chunkFrames = 16384;
+        juce::AudioBuffer<float> chunk(preload.numChannels, std::min(chunkFrames, frames - start));
+        for (int position = start; position < frames; position += chunk.getNumSamples())
+        {
+            const int numFrames = std::min(chunk.getNumSamples(), frames - position);
+            if (!reader->read(&chunk, 0, numFrames, preload.fileStartFrame + position, true, true))
+                return false;
 
-    int bytesPerSample = sizeof(float);
-    int preloadBytes = preloadSizeKB * 1024;
-    int framesToPreload = preloadBytes / (ss.preload.numChannels * bytesPerSample);
-    framesToPreload = std::min(framesToPreload, static_cast<int>(ss.preload.totalSampleFrames));
+            for (int channel = 0; channel < preload.numChannels; ++channel)
+                preload.writeCompact(channel, position, chunk.getReadPointer(channel), numFrames);
+        }
+    }
 
-    ss.preload.preloadBuffer.setSize(ss.preload.numChannels, framesToPreload);
-    reader->read(&ss.preload.preloadBuffer, 0, framesToPreload, 0, true, true);
-    ss.preload.preloadSizeFrames = framesToPreload;
+    preload.preloadSizeFrames = frames;
+    return true;
 }
 
-void SamplerEngine::updatePreloadedSamples()
+int64_t SamplerEngine::computePreloadMemoryBytes() const
 {
     std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
 
+    auto bytesOf = [](const PreloadedSample& preload) { return preload.getPreloadBytes(); };
+
+    // Preloads sharing data (sharePreloads) count once, as the largest of them
+    std::map<const void*, int64_t> sharedBytes;
     int64_t totalPreloadBytes = 0;
+    for (const auto& ss : streamingSamples)
+    {
+        if (ss.preload == nullptr)
+            continue;
+
+        const auto bytes = bytesOf(*ss.preload);
+        auto& largest = sharedBytes[preloadData(*ss.preload)];
+        totalPreloadBytes += std::max<int64_t>(0, bytes - largest);
+        largest = std::max(largest, bytes);
+    }
+
+    // The outgoing library is still in RAM until the swap
+    for (const auto& preload : outgoingPreloads)
+        totalPreloadBytes += bytesOf(*preload);
+
+    return totalPreloadBytes;
+}
+
+void SamplerEngine::applyPreloadLimits()
+{
+    const auto startTime = juce::Time::getMillisecondCounter();
+    uint32_t generation = 0;
+    std::vector<size_t> toLoad;
+
+    // Samples leaving the limits stop being playable at once; the velocity map only
+    // widens once every newly included layer is loaded, so no velocity goes silent
+    {
+        std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+        if (libraryStaging)
+            return;  // The published library is on its way out; the loader runs this job after the swap
+        if (libraryLayers.empty())
+            return;  // A setting changed before any load: there is nothing to apply it to, and nothing is complete
+
+        generation = libraryGeneration;
+        rebalancePreloadBudget();  // Resized at the end, once everything is loaded
+
+        std::vector<std::unique_ptr<PreloadedSample>> unloadedPreloads;
+        for (size_t i = 0; i < streamingSamples.size(); ++i)
+        {
+            auto& ss = streamingSamples[i];
+            bool shouldBeLoaded = shouldSampleBePreloaded(i);
+
+            if (shouldBeLoaded && ss.preload == nullptr)
+                toLoad.push_back(i);
+            else if (!shouldBeLoaded && ss.preload != nullptr)
+                unloadedPreloads.push_back(std::move(ss.preload));
+        }
+
+        mapVelocityLayerLimit = std::min(mapVelocityLayerLimit, velocityLayerLimit.load());
+        if (toLoad.empty())
+            mapVelocityLayerLimit = velocityLayerLimit;
+
+        publishSampleMap();
+        retirePreloads(std::move(unloadedPreloads));
+        preloadMemoryBytes = computePreloadMemoryBytes();
+
+        // Load stage order, then most-played notes first, then lower layers and round robins
+        std::stable_sort(toLoad.begin(), toLoad.end(), [this](size_t a, size_t b)
+        {
+            if (streamingSamples[a].loadStage != streamingSamples[b].loadStage)
+                return streamingSamples[a].loadStage < streamingSamples[b].loadStage;
+            const uint32_t playsA = notePlayCounts[sampleTable.midiNotes[a]].load(std::memory_order_relaxed);
+            const uint32_t playsB = notePlayCounts[sampleTable.midiNotes[b]].load(std::memory_order_relaxed);
+            if (playsA != playsB)
+                return playsA > playsB;
+            if (sampleTable.velocityLayerIndices[a] != sampleTable.velocityLayerIndices[b])
+                return sampleTable.velocityLayerIndices[a] < sampleTable.velocityLayerIndices[b];
+            return sampleTable.roundRobins[a] < sampleTable.roundRobins[b];
+        });
+
+        // Every stage before the first one with work left is complete
+        loadStage = toLoad.empty() ? LoadStage::Complete
+                                   : previousStage(streamingSamples[toLoad.front()].loadStage);
+
+        int64_t bytesToLoad = 0;
+        for (size_t index : toLoad)
+            bytesToLoad += getTargetPreloadBytes(index);
+        loadBytesToPreload = loadBytesPreloaded.load() + bytesToLoad;
+    }
+
+    preloadJobDone = 0;
+    preloadJobTotal = static_cast<int>(toLoad.size());
+
+    // Read in parallel batches without holding the lock, publishing every few ms so new
+    // preloads become playable. A batch stays within one load stage.
+    constexpr juce::uint32 publishIntervalMs = 20;
+    constexpr size_t batchSize = 32;
+    auto lastPublishTime = juce::Time::getMillisecondCounter();
     int loadedCount = 0;
-    int unloadedCount = 0;
 
-    for (auto& ss : streamingSamples)
+    for (size_t batchStart = 0; batchStart < toLoad.size();)
     {
-        bool shouldBeLoaded = shouldSampleBePreloaded(ss);
+        if (preloadWorker->threadShouldExit() || preloadWorker->hasPendingRequest())
+            return;  // Superseded: the next run starts over with the newest limits
 
-        if (shouldBeLoaded && !ss.isPreloaded)
+        std::vector<size_t> batch;
+        std::vector<std::unique_ptr<PreloadedSample>> preloads;
         {
-            // Load this sample's preload buffer from disk
-            loadSamplePreloadBuffer(ss);
-            ss.isPreloaded = true;
-            loadedCount++;
+            std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+            if (generation != libraryGeneration)
+                return;
+
+            const LoadStage stage = streamingSamples[toLoad[batchStart]].loadStage;
+            size_t batchEnd = batchStart;
+            while (batchEnd < toLoad.size() && batchEnd - batchStart < batchSize && streamingSamples[toLoad[batchEnd]].loadStage == stage)
+                ++batchEnd;
+            batch.assign(toLoad.begin() + static_cast<std::ptrdiff_t>(batchStart), toLoad.begin() + static_cast<std::ptrdiff_t>(batchEnd));
+            batchStart = batchEnd;
+
+            // Entering a later stage: everything of the earlier ones is in, so say so
+            if (previousStage(stage) > loadStage.load())
+            {
+                publishSampleMap();
+                preloadMemoryBytes = computePreloadMemoryBytes();
+                lastPublishTime = juce::Time::getMillisecondCounter();
+                loadStage = previousStage(stage);
+            }
+
+            // Blocks in note and layer order, as in the first stage, before the parallel reads
+            std::vector<size_t> order(batch.size());
+            for (size_t i = 0; i < order.size(); ++i)
+                order[i] = i;
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+            {
+                return packsBefore(batch[a], batch[b]);
+            });
+
+            preloads.resize(batch.size());
+            for (size_t i : order)
+                preloads[i] = allocatePreload(preloadArena, sampleTable.describe(batch[i]), getTargetPreloadFrames(batch[i]),
+                                              getTargetCompactBits(batch[i]));
         }
-        else if (!shouldBeLoaded && ss.isPreloaded)
+
+        LibraryScanner::forEachInParallel(batch.size(), 0, [&](size_t i)
+        {
+            if (preloads[i] == nullptr || preloadWorker->threadShouldExit() || preloadWorker->hasPendingRequest())
+                return;
+
+            if (!extendPreload(*preloads[i]))
+                preloads[i].reset();
+        });
+
+        if (preloadWorker->threadShouldExit() || preloadWorker->hasPendingRequest())
+            return;
+
+        std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+        if (generation != libraryGeneration)
+            return;
+
+        for (size_t i = 0; i < batch.size(); ++i)
         {
-            // Unload this sample's preload buffer
-            ss.preload.preloadBuffer.setSize(0, 0);  // Free memory
-            ss.preload.preloadSizeFrames = 0;
-            ss.isPreloaded = false;
-            unloadedCount++;
+            auto& ss = streamingSamples[batch[i]];
+            if (preloads[i] != nullptr && ss.preload == nullptr && shouldSampleBePreloaded(batch[i]))
+            {
+                loadBytesPreloaded += preloads[i]->getPreloadBytes();
+                ss.preload = std::move(preloads[i]);
+                ++loadedCount;
+            }
         }
 
-        if (ss.isPreloaded)
+        preloadJobDone += static_cast<int>(batch.size());
+
+        const auto now = juce::Time::getMillisecondCounter();
+        if (now - lastPublishTime >= publishIntervalMs)
         {
-            totalPreloadBytes += static_cast<int64_t>(ss.preload.preloadBuffer.getNumSamples()) *
-                                 static_cast<int64_t>(ss.preload.numChannels) * static_cast<int64_t>(sizeof(float));
+            publishSampleMap();
+            preloadMemoryBytes = computePreloadMemoryBytes();
+            lastPublishTime = now;
         }
     }
 
-    preloadMemoryBytes = totalPreloadBytes;
+    {
+        std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+        if (generation != libraryGeneration)
+            return;
+
+        mapVelocityLayerLimit = velocityLayerLimit;
+        publishSampleMap();
+        preloadMemoryBytes = computePreloadMemoryBytes();
+        loadStage = LoadStage::Complete;
+    }
+
+    const int resizedCount = resizePreloads(generation);
 
-    engineDebugLog("updatePreloadedSamples: velLimit=" + juce::String(velocityLayerLimit) +
-                   " rrLimit=" + juce::String(roundRobinLimit) +
+    engineDebugLog("applyPreloadLimits: velLimit=" + juce::String(velocityLayerLimit.load()) +
+                   " rrLimit=" + juce::String(roundRobinLimit.load()) +
                    " loaded=" + juce::String(loadedCount) +
-                   " unloaded=" + juce::String(unloadedCount) +
-                   " preloadMem=" + juce::String(totalPreloadBytes / 1024) + " KB");
+                   " resized=" + juce::String(resizedCount) +
+                   " preloadMem=" + juce::String(preloadMemoryBytes.load() / 1024) + " KB" +
+                   " time=" + juce::String(juce::Time::getMillisecondCounter() - startTime) + " ms");
+
+    // Nothing is written under memory pressure: the snapshot would hold the reduced preloads
+    if (resizedCount >= 0 && compactPreloads(generation) >= 0 && sharePreloads(generation) >= 0 && memoryPressureStep.load() == 0)
+        writePreloadSnapshot(generation);
+}
+
+bool SamplerEngine::packsBefore(size_t a, size_t b) const
+{
+    const auto& t = sampleTable;
+    return std::make_tuple(t.libraryLayers[a], t.midiNotes[a], t.velocityLayerIndices[a], t.roundRobins[a])
+         < std::make_tuple(t.libraryLayers[b], t.midiNotes[b], t.velocityLayerIndices[b], t.roundRobins[b]);
+}
+
+int SamplerEngine::compactPreloads(uint32_t generation)
+{
+    // Worth it once a quarter of the arena's slabs is unused
+    const auto stats = preloadArena.getStats();
+    if (stats.slabs < 2 || stats.freeBytes * 4 <= stats.reservedBytes)
+        return 0;
+
+    std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+    if (generation != libraryGeneration || libraryStaging)
+        return -1;
+
+    if (preloadArena.beginCompaction() == 0)
+        return 0;
+
+    // Preloads in the sparse slabs move to fresh blocks in note and layer order; the old ones
+    // are retired like resized ones, and their slabs are released once voices let go of them
+    std::vector<size_t> toMove;
+    for (size_t i = 0; i < streamingSamples.size(); ++i)
+    {
+        const auto* preload = streamingSamples[i].preload.get();
+        if (preload != nullptr && !preload->mapped && preload->dataOwner != nullptr &&
+            preloadArena.isEvacuating(preload->dataOwner.get()))
+            toMove.push_back(i);
+    }
+    std::stable_sort(toMove.begin(), toMove.end(), [this](size_t a, size_t b)
+    {
+        return packsBefore(a, b);
+    });
+
+    // Duplicates sharing a block (sharePreloads) keep sharing it once it has moved
+    std::map<const void*, const PreloadedSample*> movedBlocks;
+    std::vector<std::unique_ptr<PreloadedSample>> movedPreloads;
+    for (size_t index : toMove)
+    {
+        auto& ss = streamingSamples[index];
+        const auto& preload = *ss.preload;
+        std::unique_ptr<PreloadedSample> moved;
+        if (auto it = movedBlocks.find(preload.dataOwner.get()); it != movedBlocks.end() &&
+            it->second->compactBits == preload.compactBits && it->second->preloadSizeFrames >= preload.preloadSizeFrames)
+            moved = referToPreload(preload, *it->second, preload.preloadSizeFrames);
+        else
+            moved = resizedPreload(preloadArena, preload, preload.preloadSizeFrames, preload.compactBits);
+        if (moved == nullptr)
+            continue;
+
+        movedBlocks.emplace(preload.dataOwner.get(), moved.get());
+
+        movedPreloads.push_back(std::move(ss.preload));
+        ss.preload = std::move(moved);
+    }
+
+    if (!movedPreloads.empty())
+    {
+        publishSampleMap();
+        retirePreloads(std::move(movedPreloads));
+        preloadMemoryBytes = computePreloadMemoryBytes();
+    }
+
+    engineDebugLog("compactPreloads: moved=" + juce::String(static_cast<int>(toMove.size())) +
+                   " arena=" + juce::String(stats.reservedBytes / 1024) + " KB" +
+                   " used=" + juce::String(stats.usedBytes / 1024) + " KB");
+    return static_cast<int>(toMove.size());
+}
+
+int SamplerEngine::sharePreloads(uint32_t generation)
+{
+    std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+    if (generation != libraryGeneration || libraryStaging)
+        return -1;
+
+    // Candidates by content hash, in pack order
+    std::map<uint64_t, std::vector<size_t>> candidates;
+    for (size_t i = 0; i < streamingSamples.size(); ++i)
+    {
+        if (sampleTable.contentHashes[i] != 0 && streamingSamples[i].preload != nullptr)
+            candidates[sampleTable.contentHashes[i]].push_back(i);
+    }
+
+    std::vector<std::unique_ptr<PreloadedSample>> replacedPreloads;
+    int sharedCount = 0;
+    for (auto& [hash, indices] : candidates)
+    {
+        if (indices.size() < 2)
+            continue;
+
+        std::stable_sort(indices.begin(), indices.end(), [this](size_t a, size_t b)
+        {
+            return packsBefore(a, b);
+        });
+
+        // The longest preload whose memory can be shared (not a heap buffer) is kept; the
+        // others refer to it if their frames really are the same
+        const PreloadedSample* source = nullptr;
+        for (size_t index : indices)
+        {
+            const auto* preload = streamingSamples[index].preload.get();
+            if (preload->dataOwner != nullptr && (source == nullptr || preload->preloadSizeFrames > source->preloadSizeFrames))
+                source = preload;
+        }
+        if (source == nullptr)
+            continue;
+
+        for (size_t index : indices)
+        {
+            auto& ss = streamingSamples[index];
+            const auto& preload = *ss.preload;
+            if (&preload == source || preloadData(preload) == preloadData(*source))
+                continue;  // Already shared
+            if (preload.totalSampleFrames != source->totalSampleFrames || !samePreloadData(preload, *source, preload.preloadSizeFrames))
+                continue;
+
+            auto shared = referToPreload(preload, *source, preload.preloadSizeFrames);
+            replacedPreloads.push_back(std::move(ss.preload));
+            ss.preload = std::move(shared);
+            ++sharedCount;
+        }
+    }
+
+    if (!replacedPreloads.empty())
+    {
+        publishSampleMap();
+        retirePreloads(std::move(replacedPreloads));
+        preloadMemoryBytes = computePreloadMemoryBytes();
+
+        engineDebugLog("sharePreloads: shared=" + juce::String(sharedCount) +
+                       " saved=" + juce::String(getPreloadSharing().savedBytes / 1024) + " KB");
+    }
+    return sharedCount;
+}
+
+SamplerEngine::PreloadSharing SamplerEngine::getPreloadSharing() const
+{
+    std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+
+    // Per distinct data: how many preloads use it, and what they would take on their own
+    struct Use { int preloads = 0; int64_t largestBytes = 0; int64_t totalBytes = 0; };
+    std::map<const void*, Use> uses;
+    for (const auto& ss : streamingSamples)
+    {
+        if (ss.preload == nullptr)
+            continue;
+
+        auto& use = uses[preloadData(*ss.preload)];
+        const auto bytes = ss.preload->getPreloadBytes();
+        ++use.preloads;
+        use.largestBytes = std::max(use.largestBytes, bytes);
+        use.totalBytes += bytes;
+    }
+
+    PreloadSharing sharing;
+    for (const auto& [data, use] : uses)
+    {
+        if (data == nullptr || use.preloads < 2)
+            continue;
+        sharing.sharedSamples += use.preloads - 1;
+        sharing.savedBytes += use.totalBytes - use.largestBytes;
+    }
+    return sharing;
+}
+
+SamplerEngine::SampleMetadata SamplerEngine::getSampleMetadata() const
+{
+    std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+
+    SampleMetadata metadata;
+    metadata.samples = static_cast<int>(sampleTable.size());
+    metadata.tableBytes = sampleTable.getBytes();
+    metadata.rowBytes = static_cast<int64_t>(streamingSamples.capacity() * sizeof(StreamingSample));
+    if (sampleUsage != nullptr)
+        metadata.rowBytes += static_cast<int64_t>(sampleUsage->size() * sizeof(SampleUsage));
+    return metadata;
+}
+
+int SamplerEngine::resizePreloads(uint32_t generation)
+{
+    // Shrinks first (no disk access, and they free RAM), then growth
+    std::vector<size_t> toShrink;
+    std::vector<size_t> toGrow;
+    {
+        std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+        if (generation != libraryGeneration)
+            return -1;
+
+        for (size_t i = 0; i < streamingSamples.size(); ++i)
+        {
+            const auto& ss = streamingSamples[i];
+            if (ss.preload == nullptr)
+                continue;
+
+            // A format change alone converts in memory, like a shrink
+            const int frames = getTargetPreloadFrames(i);
+            if (frames > ss.preload->preloadSizeFrames)
+                toGrow.push_back(i);
+            else if (frames < ss.preload->preloadSizeFrames || getTargetCompactBits(i) != ss.preload->compactBits)
+                toShrink.push_back(i);
+        }
+    }
+
+    if (toShrink.empty() && toGrow.empty())
+        return 0;
+
+    std::vector<size_t> toResize = std::move(toShrink);
+    toResize.insert(toResize.end(), toGrow.begin(), toGrow.end());
+
+    preloadJobDone = 0;
+    preloadJobTotal = static_cast<int>(toResize.size());
+
+    // Like loading: no lock while reading, and each publish swaps in a batch of resized
+    // preloads. Voices keep playing the preload they started with until they finish.
+    constexpr juce::uint32 publishIntervalMs = 20;
+    auto lastPublishTime = juce::Time::getMillisecondCounter();
+    std::vector<std::unique_ptr<PreloadedSample>> replacedPreloads;
+    int resizedCount = 0;
+
+    auto publish = [&]
+    {
+        publishSampleMap();
+        retirePreloads(std::move(replacedPreloads));
+        replacedPreloads.clear();
+        preloadMemoryBytes = computePreloadMemoryBytes();
+        lastPublishTime = juce::Time::getMillisecondCounter();
+    };
+
+    // A new library is loading (mappingsMutex held). The map published before it may still
+    // hold the replaced preloads: while it stays published they go out with it at the swap.
+    auto abandon = [&]
+    {
+        if (libraryStaging)
+            std::move(replacedPreloads.begin(), replacedPreloads.end(), std::back_inserter(outgoingPreloads));
+        else
+            retirePreloads(std::move(replacedPreloads));
+        replacedPreloads.clear();
+        return -1;
+    };
+
+    for (size_t index : toResize)
+    {
+        if (preloadWorker->threadShouldExit() || preloadWorker->hasPendingRequest())
+            break;  // Superseded: the next run resizes what is left
+
+        std::unique_ptr<PreloadedSample> resized;
+        const PreloadedSample* original = nullptr;
+        {
+            std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+            if (generation != libraryGeneration)
+                return abandon();
+
+            const auto& ss = streamingSamples[index];
+            if (ss.preload != nullptr)
+            {
+                original = ss.preload.get();
+                resized = resizedPreload(preloadArena, *ss.preload, getTargetPreloadFrames(index), getTargetCompactBits(index));
+            }
+        }
+
+        // Growth reads only the frames the old preload didn't have
+        if (resized != nullptr && !extendPreload(*resized))
+            resized.reset();
+
+        std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+        if (generation != libraryGeneration)
+            return abandon();
+
+        auto& ss = streamingSamples[index];
+        if (resized != nullptr && ss.preload.get() == original)
+        {
+            replacedPreloads.push_back(std::move(ss.preload));
+            ss.preload = std::move(resized);
+            ++resizedCount;
+        }
+
+        ++preloadJobDone;
+
+        if (juce::Time::getMillisecondCounter() - lastPublishTime >= publishIntervalMs)
+            publish();
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(mappingsMutex);
+    if (generation != libraryGeneration)
+        return abandon();
+
+    publish();
+
+    // The snapshots no longer hold these sizes
+    if (resizedCount > 0)
+    {
+        for (auto& layer : libraryLayers)
+            layer.snapshotConfig.reset();
+    }
+
+    return static_cast<size_t>(preloadJobDone.load()) == toResize.size() ? resizedCount : -1;
 }
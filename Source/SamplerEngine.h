@@ -2,16 +2,31 @@
 
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_audio_formats/juce_audio_formats.h>
+#include <deque>
+#include <functional>
 #include <map>
 #include <vector>
 #include <array>
 #include <memory>
 #include <atomic>
-#include <thread>
 #include <mutex>
+#include <optional>
 #include "DiskStreaming.h"
 #include "StreamingVoice.h"
 #include "DiskStreamer.h"
+#include "SampleLookupTable.h"
+#include "DeferredReclaimer.h"
+#include "VoicePool.h"
+#include "VoiceStealing.h"
+#include "EngineCommandQueue.h"
+#include "PreloadWorker.h"
+#include "LibraryScanner.h"
+#include "WorkingSet.h"
+#include "PreloadSnapshot.h"
+#include "PreloadArena.h"
+#include "PreloadBudget.h"
+#include "SampleTable.h"
+#include "MemoryPressure.h"
 
 struct ADSRParams
 {
@@ -37,33 +52,220 @@ struct NoteMapping
 
 enum class LoadingState { Idle, Loading, Loaded };
 
+// How much of a library's preloads are in RAM (within the current limits).
+// Missing layers and round robins fall back to the nearest loaded sample.
+enum class LoadStage
+{
+    None,       // Nothing playable yet
+    Playable,   // One velocity layer and one round robin per note
+    AllLayers,  // Every velocity layer, first round robin only
+    Complete    // Everything
+};
+
 class SamplerEngine
 {
 public:
     SamplerEngine();
     ~SamplerEngine();
 
+    /**
+     * Brackets one audio callback on the audio thread. It pins the published sample map
+     * for the block, so noteOn(), noteOff(), processBlock() and lookupVelocityLayerIndex()
+     * must be called inside it.
+     */
+    class AudioBlockScope
+    {
+    public:
+        explicit AudioBlockScope(SamplerEngine& e);
+        ~AudioBlockScope();
+
+    private:
+        SamplerEngine& engine;
+        DeferredReclaimer::ReadScope readScope;
+
+        JUCE_DECLARE_NON_COPYABLE(AudioBlockScope)
+    };
+
+    // Layered libraries: several folders loaded as one library. Each layer plays on the keys
+    // and velocities in its ranges, so a note can start one voice per layer; all layers
+    // share the voice pool, the disk streamer and the preload RAM.
+    struct LayerSettings
+    {
+        int lowNote = 0;
+        int highNote = 127;
+        int lowVelocity = 1;
+        int highVelocity = 127;
+        float gain = 1.0f;           // Linear
+        int velocityLayerLimit = 0;  // Further limits the layer (0 = only the engine's limit)
+        int roundRobinLimit = 0;     // Further limits the layer (0 = only the engine's limit)
+        bool trimSilence = false;    // Skip leading and trailing silence (reloads the library when changed)
+        float silenceThresholdDb = -80.0f;  // Level at or below which that silence is found
+    };
+    struct LibraryLayer
+    {
+        juce::File folder;
+        LayerSettings settings;
+    };
+    static constexpr int maxLibraryLayers = 8;
+
     void prepareToPlay(double sampleRate, int samplesPerBlock);
-    void loadSamplesFromFolder(const juce::File& folder);
+    void loadSamplesFromFolder(const juce::File& folder);  // Returns at once; cancels a load in progress. The current library plays on until the new one swaps in
+    void loadLibraryLayers(std::vector<LibraryLayer> layers);  // Same, for a library of several layers (up to maxLibraryLayers)
+    std::vector<LibraryLayer> getLibraryLayers() const;        // As last requested
+
+    // Where library indexes, preload snapshots and profiles are kept: IndexCache, PreloadSnapshots
+    // and PreloadProfiles under root. Empty (the default) means the user's application data folder.
+    // Takes effect from the next load.
+    void setCacheDirectory(const juce::File& root);
+    juce::File getCacheDirectory() const;
+    void setLayerSettings(int layerIndex, const LayerSettings& settings);  // Ranges and gain apply to the next note-on; limits preload in the background; trimming reloads
     void noteOn(int midiNote, int velocity, int roundRobin, int sampleOffset = 0);
     void noteOff(int midiNote);
+    void noteSustainedByPedal(int midiNote);  // Key released while the sustain pedal is down
     void processBlock(juce::AudioBuffer<float>& buffer);
 
+    // Lock-free getVelocityLayerIndex() for the audio thread (inside an AudioBlockScope)
+    int lookupVelocityLayerIndex(int midiNote, int velocity) const;
+
     bool isLoaded() const;
     bool isLoading() const { return loadingState == LoadingState::Loading; }
     LoadingState getLoadingState() const { return loadingState; }
+    LoadStage getLoadStage() const { return loadStage.load(); }  // Of the newest library: loaded (and swapped in) once Playable; later stages fill in behind
+
+    // Progress of the current library load, from the folder scan until the last stage is in
+    struct LoadProgress
+    {
+        bool inProgress = false;
+        int filesTotal = 0;              // Audio files found in the folder
+        int filesScanned = 0;            // Headers read, or taken from the index cache
+        int64_t bytesPreloaded = 0;      // Preload data read so far
+        int64_t bytesToPreload = 0;      // Preload data the limits ask for (0 while scanning)
+        double secondsRemaining = -1.0;  // Estimate for the current phase, -1 = unknown yet
+    };
+    LoadProgress getLoadProgress() const;
+
+    // What this session played (for the plugin state). A working set given before a load
+    // is preloaded with stage 1, then its streamed regions are read ahead into the OS file
+    // cache, so a reopened session plays cleanly from the first bar.
+    WorkingSet getWorkingSet() const;
+    void setWorkingSet(WorkingSet workingSet);  // Applied by the next load
     juce::String getLoadedFolderPath() const { return loadedFolderPath; }
     int64_t getTotalInstrumentFileSize() const { return totalInstrumentFileSize.load(); }
     int64_t getPreloadMemoryBytes() const { return preloadMemoryBytes.load(); }
 
-    // ADSR controls
+    // ADSR controls (message thread; reaches the audio thread through the command queue)
     void setADSR(float attack, float decay, float sustain, float release);
     ADSRParams getADSR() const { return adsrParams; }
 
     // Preload size control (in KB, range 32-1024)
-    int getPreloadSizeKB() const { return preloadSizeKB; }
-    void setPreloadSizeKB(int sizeKB) { preloadSizeKB = juce::jlimit(32, 1024, sizeKB); }
-    void reloadPreloadBuffers();  // Reload all preloaded samples with current preloadSizeKB
+    static constexpr int minPreloadSizeKB = 32;
+    static constexpr int maxPreloadSizeKB = 1024;
+    int getPreloadSizeKB() const { return preloadSizeKB.load(); }
+    void setPreloadSizeKB(int sizeKB) { preloadSizeKB.store(juce::jlimit(minPreloadSizeKB, maxPreloadSizeKB, sizeKB)); }
+    void reloadPreloadBuffers();  // Resize loaded preloads to preloadSizeKB in the background (growth reads only the new tail)
+
+    // Preload RAM budget: instead of preloadSizeKB for every sample, the preloads share at most
+    // this much RAM, sized by PreloadBudget from each sample's plays, playback rate, length and
+    // underruns. Rebalanced in the background while the session plays. 0 = off.
+    void setPreloadBudgetMB(int budgetMB);
+    int getPreloadBudgetMB() const { return preloadBudgetMB.load(); }
+
+    struct PreloadAllocation
+    {
+        int64_t budgetBytes = 0;     // 0 = no budget
+        int64_t allocatedBytes = 0;  // RAM the preloads within the limits take once loaded
+        int samples = 0;             // Samples within the limits
+        int smallestKB = 0;          // Smallest and largest of their preloads
+        int largestKB = 0;
+        bool floorsFit = true;       // False if the budget can't give every sample minPreloadSizeKB
+    };
+    PreloadAllocation getPreloadAllocation() const;  // As of the last rebalance
+
+    // Adaptive preload sizing: each sample's preload grows after it underruns or the disk's
+    // first refill arrives late, and shrinks after plays the disk kept well ahead of. The sizes
+    // stay within the RAM budget, or without one, the RAM preloadSizeKB would take; they are
+    // learned per library (PreloadProfile) and used again the next time it loads.
+    void setAdaptivePreloadSizing(bool enabled);
+    bool isAdaptivePreloadSizing() const { return adaptivePreloadSizing.load(); }
+
+    // Preload memory: preloads read from disk live in PreloadArena slabs, packed in note and
+    // layer order; limit changes compact slabs that fell below half use. Huge pages are optional
+    // (transparent or reserved huge pages on Linux) and apply to slabs created after the change.
+    void setPreloadHugePages(PreloadArena::HugePages mode) { preloadArena.setHugePages(mode); }
+    PreloadArena::HugePages getPreloadHugePages() const { return preloadArena.getHugePages(); }
+    PreloadArena::Stats getPreloadArenaStats() const { return preloadArena.getStats(); }
+
+    // Memory locking: pins the preload arena's slabs and the voices' ring buffers into RAM, so
+    // the OS can't page them out under memory pressure and a note-on never takes a page fault.
+    // What the OS refuses to lock (RLIMIT_MEMLOCK) is pre-touched instead, and counted and
+    // logged as a failure. Preloads mapped from a snapshot are pre-touched, not locked.
+    // Message thread.
+    struct MemoryLockStatus
+    {
+        bool enabled = false;
+        int64_t lockedBytes = 0;      // Arena slabs and voice rings locked into RAM
+        int64_t lockLimitBytes = -1;  // RLIMIT_MEMLOCK (-1 = unlimited or unknown)
+        int failures = 0;             // Slabs and rings pre-touched because the lock was refused
+    };
+    void setLockPreloadMemory(bool enabled);
+    bool getLockPreloadMemory() const { return preloadArena.getLockMemory(); }
+    MemoryLockStatus getMemoryLockStatus() const;
+
+    // Compact preloads: 16- and 24-bit files keep their preloads as integers in the file's own
+    // depth, converted to float as voices read them, for half (16-bit) or three quarters (24-bit)
+    // of the RAM. Float files are unaffected. Loaded preloads convert in memory when it changes.
+    void setCompactPreloads(bool enabled);
+    bool getCompactPreloads() const { return compactPreloadStorage.load(); }
+
+    // Duplicate samples: files whose audio is identical (same content hash from the scan, and
+    // the same preloaded frames) share one preload instead of holding copies. Reports how many
+    // samples refer to another's preload and the RAM that saves.
+    struct PreloadSharing
+    {
+        int sharedSamples = 0;
+        int64_t savedBytes = 0;
+    };
+    PreloadSharing getPreloadSharing() const;
+
+    // Sample metadata: what the loaded library's per-sample bookkeeping takes, apart from
+    // preload data. The fixed part is columns (SampleTable) with interned paths; the rest is
+    // each sample's mutable row and usage counters.
+    struct SampleMetadata
+    {
+        int samples = 0;
+        int64_t tableBytes = 0;  // Columns and interned paths
+        int64_t rowBytes = 0;    // Mutable rows and usage counters
+        int64_t getBytesPerSample() const { return samples > 0 ? (tableBytes + rowBytes) / samples : 0; }
+    };
+    SampleMetadata getSampleMetadata() const;
+
+    // Memory pressure: when the machine (or the process' cgroup) runs low on RAM, the engine
+    // gives preload memory back in a fixed order, one step per check while the shortage lasts,
+    // and undoes the steps in reverse once it clears. Every level change and step is logged.
+    // On by default; readings are Linux only (MemoryPressure).
+    enum class PressureStep
+    {
+        none,
+        compactPreloads,  // Float preloads of 16/24-bit files kept as integers, as with setCompactPreloads
+        minimumPreloads,  // Every preload shrunk to minPreloadSizeKB (low pressure goes this far)
+        firstStageOnly    // Only load stage 1 preloaded; other layers and round robins borrow it (critical)
+    };
+    struct MemoryPressureEvent
+    {
+        juce::uint32 timeMs = 0;
+        MemoryPressure::Level level = MemoryPressure::Level::normal;
+        PressureStep step = PressureStep::none;  // In effect from this event on
+        int64_t availableBytes = -1;             // -1 = unknown
+        int64_t preloadBytes = 0;                // Preload RAM at the time
+        juce::String message;
+    };
+    static constexpr int maxMemoryPressureEvents = 64;
+    void setMemoryPressureResponse(bool enabled);  // Off undoes any steps taken
+    bool getMemoryPressureResponse() const { return memoryPressureResponse.load(); }
+    MemoryPressure::Level getMemoryPressureLevel() const { return memoryPressureLevel.load(); }
+    PressureStep getMemoryPressureStep() const { return static_cast<PressureStep>(memoryPressureStep.load()); }
+    std::vector<MemoryPressureEvent> getMemoryPressureLog() const;  // Oldest first, the last maxMemoryPressureEvents
+    void setMemoryPressureSource(std::function<MemoryPressure::Reading()> source);  // Null = MemoryPressure::read()
 
     // Streaming activity info (for UI)
     int getActiveVoiceCount() const;
@@ -71,8 +273,22 @@ public:
     float getDiskThroughputMBps() const; // Current disk throughput in MB/s
     int getUnderrunCount() const;        // Total buffer underruns
     void resetUnderrunCount();           // Reset underrun counter
+    int getPendingReclaimCount() const { return reclaimer.getNumPending(); }  // Replaced maps, preloads and policies not yet freed
+
+    // Voice stealing (policy may be replaced at any time; the old one is freed once unused)
+    struct VoiceStealStats
+    {
+        int steals = 0;                // Voices faded out to make room
+        int releasedSteals = 0;        // ...that were release tails
+        int pedalSustainedSteals = 0;  // ...that were held by the sustain pedal
+        int heldSteals = 0;            // ...whose key was still down
+        int droppedNotes = 0;          // Note-ons skipped because every voice was fading out
+    };
+    void setVoiceStealingPolicy(std::unique_ptr<VoiceStealingPolicy> policy);
+    VoiceStealStats getVoiceStealStats() const;
+    void resetVoiceStealStats();
 
-    // Query sample configuration for UI
+    // Query sample configuration for UI (of the first layer)
     bool isNoteAvailable(int midiNote) const;  // Has samples or valid fallback
     bool noteHasOwnSamples(int midiNote) const;  // Has its own samples (not fallback)
     std::vector<int> getVelocityLayers(int midiNote) const;  // Get velocity values for a note
@@ -80,19 +296,30 @@ public:
     int getHighestAvailableNote() const;
     int getMaxVelocityLayers(int startNote, int endNote) const;  // Max layers in range
     int getVelocityLayerIndex(int midiNote, int velocity) const;  // Index of layer for velocity (0-based)
-    int getMaxRoundRobins() const { return maxRoundRobins; }  // Max RR positions found in samples
-    int getMaxVelocityLayersGlobal() const { return maxVelocityLayersGlobal; }  // Max velocity layers found across all notes
+    int getMaxRoundRobins() const { return maxRoundRobins; }  // Max RR positions found in samples (of any layer)
+    int getMaxVelocityLayersGlobal() const { return maxVelocityLayersGlobal; }  // Max velocity layers found across all notes (of any layer)
+
+    // Velocity layer and round robin limit changes are applied by a background job:
+    // new preloads load most-played notes first and become playable as they arrive
+    struct PreloadProgress
+    {
+        bool inProgress = false;
+        int samplesDone = 0;
+        int samplesTotal = 0;
+    };
+    PreloadProgress getPreloadProgress() const;
 
     // Velocity layer limit (1 to maxVelocityLayersGlobal)
     void setVelocityLayerLimit(int limit);
-    int getVelocityLayerLimit() const { return velocityLayerLimit; }
+    int getVelocityLayerLimit() const { return velocityLayerLimit.load(); }
 
     // Round robin limit (1 to maxRoundRobins)
     void setRoundRobinLimit(int limit);
-    int getRoundRobinLimit() const { return roundRobinLimit; }
+    int getRoundRobinLimit() const { return roundRobinLimit.load(); }
+    int getAudioRoundRobinLimit() const { return audioParams.roundRobinLimit; }  // Audio thread copy
 
     // Same-note retrigger release time (for experimentation)
-    void setSameNoteReleaseTime(float seconds) { sameNoteReleaseTime = juce::jlimit(0.01f, 5.0f, seconds); }
+    void setSameNoteReleaseTime(float seconds);
     float getSameNoteReleaseTime() const { return sameNoteReleaseTime; }
 
     // Parse note name to MIDI note number (e.g., "C4" -> 60, "G#6" -> 104)
@@ -105,7 +332,7 @@ public:
 
 private:
 
-    std::map<int, NoteMapping> noteMappings; // Key: MIDI note number
+    std::map<int, NoteMapping> noteMappings; // Key: MIDI note number. The first layer's, for the UI queries
 
     ADSRParams adsrParams;
 
@@ -116,11 +343,26 @@ private:
 
     // Async loading
     std::atomic<LoadingState> loadingState{LoadingState::Idle};
-    std::unique_ptr<std::thread> loadingThread;
+    std::atomic<LoadStage> loadStage{LoadStage::None};
+    std::unique_ptr<PreloadWorker> loadWorker;  // Runs the newest requested load; newer requests cancel it
+    std::vector<LibraryLayer> requestedLayers;  // Guarded by mappingsMutex
+
+    // Hot swap: while a load builds the next library, the previous one stays published and
+    // playable. Its preloads wait here until the next library's first stage swaps in.
+    std::vector<std::unique_ptr<PreloadedSample>> outgoingPreloads;  // Guarded by mappingsMutex
+    bool libraryStaging = false;  // streamingSamples is the next library, not yet published. Guarded by mappingsMutex
+
+    // Load progress (reset when a load starts)
+    std::atomic<int> loadFilesTotal{0};
+    std::atomic<int> loadFilesScanned{0};
+    std::atomic<int64_t> loadBytesPreloaded{0};
+    std::atomic<int64_t> loadBytesToPreload{0};
+    std::atomic<juce::uint32> loadScanStartMs{0};
+    std::atomic<juce::uint32> loadPreloadStartMs{0};
     mutable std::recursive_mutex mappingsMutex;  // mutable + recursive for nested const method calls
 
     // Preload size
-    int preloadSizeKB = 64;  // Default 64KB, configurable 32-1024KB
+    std::atomic<int> preloadSizeKB{64};  // Default 64KB, configurable 32-1024KB
 
     // Max round-robin positions found in loaded samples
     int maxRoundRobins = 1;
@@ -129,43 +371,199 @@ private:
     int maxVelocityLayersGlobal = 1;
 
     // Velocity layer limit (user-adjustable, 1 to maxVelocityLayersGlobal)
-    int velocityLayerLimit = 1;
+    std::atomic<int> velocityLayerLimit{1};
+    int mapVelocityLayerLimit = 1;  // Limit the published map uses (lags while raising). Guarded by mappingsMutex
 
     // Round robin limit (user-adjustable, 1 to maxRoundRobins)
-    int roundRobinLimit = 1;
+    std::atomic<int> roundRobinLimit{1};
 
     // Polyphonic same-note: max voices allowed per note before oldest is faded out
     static constexpr int maxVoicesPerNote = 4;
     uint64_t voiceStartCounterGlobal = 0;  // Incremented each time a voice starts
-    float sameNoteReleaseTime = 0.3f;      // Release time for same-note retrigger (seconds)
+    float sameNoteReleaseTime = 0.3f;      // Release time for same-note retrigger (seconds, message thread copy)
+
+    // Parameters as the audio thread sees them. Only ever written by draining
+    // commandQueue at the top of a block (or in prepareToPlay, before audio starts).
+    struct AudioParameters
+    {
+        juce::ADSR::Parameters adsr;
+        uint32_t adsrGeneration = 0;      // Moves on every ADSR change; voices re-apply only then
+        float sameNoteReleaseTime = 0.3f;
+        int roundRobinLimit = 1;
+    };
+    AudioParameters audioParams;
+    EngineCommandQueue commandQueue;
 
     // Streaming voices
     std::array<StreamingVoice, StreamingConstants::maxStreamingVoices> streamingVoices;
 
+    // Free/active/per-note voice lists, so note events and rendering scale with
+    // active voices rather than capacity (audio thread only)
+    VoicePool voicePool{StreamingConstants::maxStreamingVoices};
+    std::array<int, StreamingConstants::maxStreamingVoices> voiceSampleIndex{};            // For usage tracking
+    std::array<uint32_t, StreamingConstants::maxStreamingVoices> voiceLibraryGeneration{}; // Library of that index
+    std::atomic<int> activeVoiceCount{0};  // Published for the UI
+
+    // Voice stealing: steals start once fewer than stealReserveVoices are free, so the
+    // stolen voice can always fade out while the new note takes a reserve voice
+    static constexpr int stealReserveVoices = 16;
+    std::unique_ptr<VoiceStealingPolicy> currentStealingPolicy;  // Guarded by mappingsMutex
+    std::atomic<const VoiceStealingPolicy*> stealingPolicy{nullptr};
+    struct StealCounters
+    {
+        std::atomic<int> steals{0};
+        std::atomic<int> releasedSteals{0};
+        std::atomic<int> pedalSustainedSteals{0};
+        std::atomic<int> heldSteals{0};
+        std::atomic<int> droppedNotes{0};
+    };
+    StealCounters stealCounters;
+
+    // Layers of the library in streamingSamples (loader/UI threads only, guarded by mappingsMutex)
+    struct LoadedLayer
+    {
+        LibraryLayer layer;
+        std::map<int, NoteMapping> noteMappings;                // Key: MIDI note number
+        std::optional<PreloadSnapshot::Config> snapshotConfig;  // What the layer's preload snapshot holds
+    };
+    std::vector<LoadedLayer> libraryLayers;
+
     // Background disk streaming thread
     std::unique_ptr<DiskStreamer> diskStreamer;
 
-    // Preloaded samples for streaming
+    // Sample library (loader/UI threads only, guarded by mappingsMutex). What is fixed per
+    // sample lives in sampleTable's columns; its row here is only what changes while loaded.
     struct StreamingSample
     {
-        PreloadedSample preload;
-        int midiNote = 0;
-        int velocity = 0;
-        int roundRobin = 0;
-        int velocityLayerIndex = -1;  // Which layer this sample belongs to (0-based)
-        bool isPreloaded = false;     // Whether preload buffer is currently loaded
+        std::unique_ptr<PreloadedSample> preload;  // Published preload (null = not preloaded)
+        int preloadFrames = -1;       // Size the RAM budget gives its preload (-1 = preloadSizeKB's)
+        float preloadScale = 1.0f;    // Learned by adaptive sizing (PreloadProfile)
+        uint32_t adaptedUnderruns = 0;  // Its usage's underruns as of the last adaptation
+        LoadStage loadStage = LoadStage::Complete;  // Stage whose completion needs this preload
     };
+    SampleTable sampleTable;  // Indexed like streamingSamples
     std::vector<StreamingSample> streamingSamples;
 
+    // Session usage per sample, indexed like streamingSamples. One table per library,
+    // shared by all of its maps; only the audio thread writes it (adaptive sizing resets refillLag).
+    struct SampleUsage
+    {
+        std::atomic<uint32_t> plays{0};
+        std::atomic<int64_t> framesPlayed{0};  // Furthest frame any voice reached
+        std::atomic<uint32_t> underruns{0};    // Blocks a voice of it underran
+        std::atomic<float> peakPlaybackRate{0.0f};  // Fastest it was read (source frames per output frame)
+        std::atomic<float> refillLag{-1.0f};        // Worst since the last adaptation, which resets it
+    };
+    using SampleUsageTable = std::vector<SampleUsage>;
+    std::shared_ptr<SampleUsageTable> sampleUsage;  // Guarded by mappingsMutex
+    WorkingSet restoredWorkingSet;                  // Until the next load applies it. Guarded by mappingsMutex
+
+    // Immutable snapshot of everything note-on needs. Rebuilt off the audio thread
+    // whenever mappings, limits or the preloaded set change, then published with an
+    // atomic pointer swap. Replaced maps and preloads are freed by the reclaimer once
+    // no audio block, disk pass or voice can still reach them.
+    struct LayerMap
+    {
+        SampleLookupTable lookup;  // Over the layer's own samples only
+        int lowNote = 0, highNote = 127;
+        int lowVelocity = 1, highVelocity = 127;
+        float gain = 1.0f;
+        int roundRobinLimit = 0;   // Round robins beyond it wrap around (0 = none)
+    };
+    struct SampleMap
+    {
+        std::vector<LayerMap> layers;                 // Like libraryLayers
+        std::vector<const PreloadedSample*> samples;  // Indexed by lookup results
+        std::shared_ptr<SampleUsageTable> usage;      // Indexed like samples (null between libraries)
+        uint32_t libraryGeneration = 0;
+    };
+    std::unique_ptr<SampleMap> currentSampleMap;               // Guarded by mappingsMutex
+    std::atomic<const SampleMap*> publishedSampleMap{nullptr};
+    const SampleMap* audioSampleMap = nullptr;                 // Pinned for the current audio block
+    DeferredReclaimer reclaimer;
+
+    // Background application of limit changes
+    std::unique_ptr<PreloadWorker> preloadWorker;
+    uint32_t libraryGeneration = 0;  // Bumped when streamingSamples is replaced. Guarded by mappingsMutex
+    std::array<std::atomic<uint32_t>, 128> notePlayCounts{};  // Note-ons per note, for load priority
+    std::atomic<int> preloadJobDone{0};
+    std::atomic<int> preloadJobTotal{0};
+
+    // Every preload read from disk (snapshot preloads are mapped instead)
+    PreloadArena preloadArena;
+
+    // Preload RAM budget
+    std::atomic<int> preloadBudgetMB{0};
+    std::atomic<double> budgetSampleRate{44100.0};  // Host rate, for playback rates of unplayed samples
+    PreloadAllocation preloadAllocation;            // Guarded by mappingsMutex
+    juce::uint32 lastBudgetCheckMs = 0;             // PreloadWorker thread only
+    std::atomic<bool> adaptivePreloadSizing{false};
+    std::atomic<bool> compactPreloadStorage{false};
+
+    // Memory locking (the arena keeps its own part)
+    std::atomic<int> lockedRings{0};
+    std::atomic<int> ringLockFailures{0};
+    std::atomic<int> reportedLockFailures{0};
+    void touchMappedPreloads();    // Faults in the pages of snapshot-mapped preloads
+    void reportMemoryLockFailures();
+
+    // Memory pressure response
+    std::atomic<bool> memoryPressureResponse{true};
+    std::atomic<MemoryPressure::Level> memoryPressureLevel{MemoryPressure::Level::normal};
+    std::atomic<int> memoryPressureStep{0};  // PressureStep in effect
+    juce::uint32 lastPressureCheckMs = 0;    // PreloadWorker thread only
+    mutable std::mutex memoryPressureMutex;
+
+    juce::File cacheDirectory;  // Guarded by mappingsMutex
+    juce::File getCacheSubdirectory(const char* name) const;  // Empty (component default) if no cache directory is set
+    std::function<MemoryPressure::Reading()> memoryPressureSource;  // Guarded by memoryPressureMutex
+    std::deque<MemoryPressureEvent> memoryPressureLog;              // Guarded by memoryPressureMutex
+    void checkMemoryPressure();  // PreloadWorker housekeeping
+    void logMemoryPressure(const MemoryPressure::Reading& reading, const juce::String& message);
+
+    // Preload snapshot: once a library is complete each layer's preloads are written to disk,
+    // and the next load with the same configuration maps them instead of reading each sample
+    std::atomic<bool> snapshotWriteInProgress{false};  // Retired preloads stay allocated meanwhile
+
     // Format manager for streaming
     juce::AudioFormatManager formatManager;
 
     // Internal methods
-    void loadSamplesInBackground(const juce::String& folderPath);
-    const StreamingSample* findStreamingSample(int midiNote, int velocity, int roundRobin) const;
+    void runRequestedLoad();  // loadWorker job
+    void loadSamplesInBackground(const std::vector<LibraryLayer>& layers);
+    std::vector<LibraryScanner::ScannedSample> scanLibraryFolder(const LibraryLayer& layer);  // Empty if cancelled
+    bool isLoadCancelled() const;
+    void assignLoadStages();
+    void applyRestoredWorkingSet();
+    void warmStreamedRegions(const std::vector<size_t>& sampleIndices);
+    PreloadSnapshot::Config getPreloadSnapshotConfig(int layerIndex) const;
+    int adoptSnapshotPreloads();
+    void writePreloadSnapshot(uint32_t generation);  // PreloadWorker, once a library is complete
+    void startLayerVoice(int midiNote, int velocity, int sampleIndex, float gain, int voicesPerNote);  // Audio thread
+    int findVoiceToSteal() const;
+    void pushCommand(const EngineCommand& command);
+    void applyPendingCommands();  // Audio thread
+    void publishSampleMap();
+    void retirePreloads(std::vector<std::unique_ptr<PreloadedSample>> preloads);
 
     // Selective preloading methods
-    bool shouldSampleBePreloaded(const StreamingSample& ss) const;
-    void updatePreloadedSamples();
-    void loadSamplePreloadBuffer(StreamingSample& ss);
+    bool shouldSampleBePreloaded(size_t index) const;
+    int getLayerVelocityLimit(int layerIndex) const;   // The engine's limit, or the layer's if lower
+    int getLayerRoundRobinLimit(int layerIndex) const;
+    void applyPreloadLimits();  // PreloadWorker job
+    int resizePreloads(uint32_t generation);  // Number resized, -1 if superseded
+    int compactPreloads(uint32_t generation);  // Number moved, -1 if superseded
+    int sharePreloads(uint32_t generation);    // Number newly shared, -1 if superseded
+    bool packsBefore(size_t a, size_t b) const;  // Arena order: layer, note, velocity, round robin
+    int getPreloadSizeFrames(size_t index, int sizeKB) const;  // LibraryScanner::getPreloadSizeFrames() from the table
+    int getTargetPreloadFrames(size_t index) const;
+    int getTargetCompactBits(size_t index) const { return compactPreloadsWanted() ? sampleTable.integerBits[index] : 0; }
+    bool compactPreloadsWanted() const { return compactPreloadStorage.load() || memoryPressureStep.load() >= static_cast<int>(PressureStep::compactPreloads); }
+    int64_t getTargetPreloadBytes(size_t index) const;
+    bool rebalancePreloadBudget();  // Sets preloadFrames; true if any size changed
+    void checkPreloadBudget();      // PreloadWorker housekeeping
+    bool adaptPreloadScales();      // Learns from usage since the last call; true if any scale changed
+    void savePreloadProfiles() const;
+    bool extendPreload(PreloadedSample& preload);  // Read the frames between preloadSizeFrames and the preload's capacity
+    int64_t computePreloadMemoryBytes() const;
 };
@@ -1,4 +1,5 @@
 #include "StreamingVoice.h"
+#include "MemoryLock.h"
 
 // Static underrun counter definition
 std::atomic<int> StreamingVoice::underrunCount{0};
@@ -12,23 +13,74 @@ static void voiceDebugLog(const juce::String& msg)
     logFile.appendText("[" + timestamp + "] " + msg + "\n");
 }
 
+void StreamingVoice::PagesDeleter::operator()(float* data) const
+{
+    MemoryLock::freePages(data);
+}
+
 StreamingVoice::StreamingVoice()
 {
-    // Allocate ring buffer for stereo audio
-    ringBuffer.setSize(2, StreamingConstants::ringBufferFrames);
+    // Allocate ring buffer for stereo audio: both channels in one page-aligned block
+    constexpr int numChannels = 2;
+    const size_t pageSize = MemoryLock::getPageSize();
+    const size_t channelBytes = (static_cast<size_t>(StreamingConstants::ringBufferFrames) * sizeof(float) + pageSize - 1) / pageSize * pageSize;
+    ringStorage.reset(static_cast<float*>(MemoryLock::allocatePages(channelBytes * numChannels)));
+
+    if (ringStorage != nullptr)
+    {
+        float* channels[numChannels];
+        for (int ch = 0; ch < numChannels; ++ch)
+            channels[ch] = ringStorage.get() + static_cast<size_t>(ch) * channelBytes / sizeof(float);
+
+        ringStorageBytes = channelBytes * numChannels;
+        ringBuffer.setDataToReferTo(channels, numChannels, StreamingConstants::ringBufferFrames);
+    }
+    else
+    {
+        ringBuffer.setSize(numChannels, StreamingConstants::ringBufferFrames);  // Never locked
+    }
     ringBuffer.clear();
 }
 
-StreamingVoice::~StreamingVoice() = default;
+StreamingVoice::~StreamingVoice()
+{
+    setRingLocked(false);
+}
+
+bool StreamingVoice::setRingLocked(bool shouldLock)
+{
+    if (shouldLock == ringLocked)
+        return ringLocked;
+
+    if (!shouldLock)
+    {
+        MemoryLock::unlock(ringStorage.get(), ringStorageBytes);
+        ringLocked = false;
+        return false;
+    }
+
+    // One range, so the lock is all or nothing
+    ringLocked = ringStorage != nullptr && MemoryLock::lock(ringStorage.get(), ringStorageBytes);
+    if (!ringLocked)
+    {
+        // The disk thread may be filling the ring, so only read it in
+        const size_t channelBytes = static_cast<size_t>(ringBuffer.getNumSamples()) * sizeof(float);
+        for (int ch = 0; ch < ringBuffer.getNumChannels(); ++ch)
+            MemoryLock::touch(ringBuffer.getWritePointer(ch), channelBytes, false);
+    }
+
+    return ringLocked;
+}
 
 void StreamingVoice::prepareToPlay(double sampleRate, int /*samplesPerBlock*/)
 {
     adsr.setSampleRate(sampleRate);
 }
 
-void StreamingVoice::setADSRParameters(const juce::ADSR::Parameters& params)
+void StreamingVoice::setADSRParameters(const juce::ADSR::Parameters& params, uint32_t generation)
 {
     adsr.setParameters(params);
+    adsrGeneration = generation;
 }
 
 void StreamingVoice::startVoice(const PreloadedSample* sample, int midiNote, float vel, double hostSampleRate, uint64_t startCounter)
@@ -36,7 +88,7 @@ void StreamingVoice::startVoice(const PreloadedSample* sample, int midiNote, flo
     if (sample == nullptr || !sample->isValid())
         return;
 
-    currentSample = sample;
+    currentSample.store(sample, std::memory_order_release);
     playingNote = midiNote;
     velocity = vel;
     voiceStartCounter = startCounter;
@@ -61,25 +113,32 @@ void StreamingVoice::startVoice(const PreloadedSample* sample, int midiNote, flo
     isUnderrunning = false;
     underrunFadePosition = 0;
     sustainedByPedal = false;
+    released = false;
+    currentLevel = 0.0f;
     isQuickFading = false;
     quickFadeLevel = 1.0f;
     quickFadeDecrement = 0.0f;
 
-    // Copy preload buffer into beginning of ring buffer
-    const auto& preload = sample->preloadBuffer;
-    int preloadFrames = preload.getNumSamples();
+    // Copy preload buffer into beginning of ring buffer (compact preloads convert to float here)
+    int preloadFrames = sample->getPreloadCapacity();
     int framesToCopy = std::min(preloadFrames, StreamingConstants::ringBufferFrames);
 
     ringBuffer.clear();
-    for (int ch = 0; ch < std::min(preload.getNumChannels(), ringBuffer.getNumChannels()); ++ch)
+    for (int ch = 0; ch < std::min(sample->numChannels, ringBuffer.getNumChannels()); ++ch)
     {
-        ringBuffer.copyFrom(ch, 0, preload, ch, 0, framesToCopy);
+        sample->readPreload(ch, 0, ringBuffer.getWritePointer(ch), framesToCopy);
     }
 
     // Set initial write position after preloaded data
     writePosition.store(framesToCopy, std::memory_order_release);
     fileReadPosition.store(framesToCopy, std::memory_order_release);
 
+    awaitingFirstRefill = sample->needsStreaming() && framesToCopy > 0;
+    initialBufferedFrames = framesToCopy;
+    lowestBufferedFrames = framesToCopy;
+    refillLag = -1.0f;
+    underran = false;
+
     // Start envelope
     adsr.noteOn();
 
@@ -93,7 +152,7 @@ void StreamingVoice::startVoice(const PreloadedSample* sample, int midiNote, flo
     active.store(true, std::memory_order_release);
 
     voiceDebugLog("StreamingVoice::startVoice - note=" + juce::String(midiNote)
-                 + " sample=" + sample->name
+                 + " sample=" + sample->path.getFileName()
                  + " totalFrames=" + juce::String(sample->totalSampleFrames)
                  + " preloadFrames=" + juce::String(sample->preloadSizeFrames)
                  + " needsStreaming=" + juce::String(sample->needsStreaming() ? "YES" : "no")
@@ -105,6 +164,7 @@ void StreamingVoice::stopVoice(bool allowTailOff)
     if (allowTailOff)
     {
         adsr.noteOff();
+        released = true;
     }
     else
     {
@@ -120,6 +180,7 @@ void StreamingVoice::stopVoiceWithCustomRelease(float releaseSeconds, double sam
     adsr.setParameters(params);
     adsr.setSampleRate(sampleRate);
     adsr.noteOff();
+    released = true;
 }
 
 void StreamingVoice::startQuickFadeOut(double sampleRate)
@@ -139,7 +200,9 @@ void StreamingVoice::reset()
     adsr.reset();
     playingNote = -1;
     sustainedByPedal = false;
-    currentSample = nullptr;
+    released = false;
+    currentLevel = 0.0f;
+    currentSample.store(nullptr, std::memory_order_release);
     isQuickFading = false;
     quickFadeLevel = 1.0f;
     quickFadeDecrement = 0.0f;
@@ -155,6 +218,7 @@ void StreamingVoice::noteReleasedWithPedal(bool pedalDown)
     else
     {
         adsr.noteOff();
+        released = true;
     }
 }
 
@@ -164,9 +228,16 @@ void StreamingVoice::setSustainPedal(bool isDown)
     {
         sustainedByPedal = false;
         adsr.noteOff();
+        released = true;
     }
 }
 
+bool StreamingVoice::isStreamingFromDisk() const
+{
+    const PreloadedSample* sample = currentSample.load(std::memory_order_relaxed);
+    return sample != nullptr && sample->needsStreaming() && !hasReachedEndOfFile() && !hasReadError();
+}
+
 int StreamingVoice::samplesAvailable() const
 {
     int64_t read = readPosition.load(std::memory_order_acquire);
@@ -191,7 +262,8 @@ void StreamingVoice::advanceWritePosition(int frames)
 
 void StreamingVoice::checkAndRequestData()
 {
-    if (currentSample == nullptr || !currentSample->needsStreaming())
+    const PreloadedSample* sample = currentSample.load(std::memory_order_relaxed);
+    if (sample == nullptr || !sample->needsStreaming())
         return;
 
     if (hasReachedEndOfFile() || hasReadError())
@@ -204,6 +276,20 @@ void StreamingVoice::checkAndRequestData()
     }
 }
 
+float StreamingVoice::takeRefillLag()
+{
+    const float lag = refillLag;
+    refillLag = -1.0f;
+    return lag;
+}
+
+bool StreamingVoice::takeUnderran()
+{
+    const bool result = underran;
+    underran = false;
+    return result;
+}
+
 float StreamingVoice::readFromRingBuffer(int channel, int ringPos)
 {
     // Wrap position within ring buffer
@@ -216,16 +302,25 @@ float StreamingVoice::readFromRingBuffer(int channel, int ringPos)
 
 void StreamingVoice::renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
 {
-    if (!active.load(std::memory_order_acquire) || currentSample == nullptr)
+    const PreloadedSample* playingSample = currentSample.load(std::memory_order_relaxed);
+    if (!active.load(std::memory_order_acquire) || playingSample == nullptr)
         return;
 
     const int numOutputChannels = outputBuffer.getNumChannels();
-    const int numSourceChannels = currentSample->numChannels;
-    const int64_t totalSourceFrames = currentSample->totalSampleFrames;
-    const bool isStreaming = currentSample->needsStreaming();
+    const int numSourceChannels = playingSample->numChannels;
+    const int64_t totalSourceFrames = playingSample->totalSampleFrames;
+    const bool isStreaming = playingSample->needsStreaming();
 
     int64_t currentReadPos = readPosition.load(std::memory_order_acquire);
     int64_t currentWritePos = writePosition.load(std::memory_order_acquire);
+    float blockEndLevel = currentLevel;
+
+    // The disk's first refill has landed: how much of the preload was used up by then
+    if (awaitingFirstRefill && currentWritePos > initialBufferedFrames)
+    {
+        refillLag = 1.0f - static_cast<float>(lowestBufferedFrames) / static_cast<float>(initialBufferedFrames);
+        awaitingFirstRefill = false;
+    }
 
     for (int sample = 0; sample < numSamples; ++sample)
     {
@@ -267,6 +362,13 @@ void StreamingVoice::renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int
                     isUnderrunning = true;
                     underrunFadePosition = 0;
                     underrunCount.fetch_add(1, std::memory_order_relaxed);
+                    underran = true;
+
+                    if (awaitingFirstRefill)
+                    {
+                        refillLag = 1.0f;  // The whole preload played and no refill came
+                        awaitingFirstRefill = false;
+                    }
                 }
             }
         }
@@ -304,9 +406,8 @@ void StreamingVoice::renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int
             if (!isStreaming)
             {
                 // Small sample - read directly from preload buffer
-                const auto& preload = currentSample->preloadBuffer;
-                sample0 = preload.getSample(sourceChannel, static_cast<int>(pos0));
-                sample1 = preload.getSample(sourceChannel, static_cast<int>(pos1));
+                sample0 = playingSample->getPreloadSample(sourceChannel, static_cast<int>(pos0));
+                sample1 = playingSample->getPreloadSample(sourceChannel, static_cast<int>(pos1));
             }
             else
             {
@@ -325,6 +426,7 @@ void StreamingVoice::renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int
             float finalGain = velocity * envelopeValue * underrunFade;
             if (isQuickFading)
                 finalGain *= quickFadeLevel;
+            blockEndLevel = finalGain;
 
             outputBuffer.addSample(ch, startSample + sample, interpolated * finalGain);
         }
@@ -343,12 +445,18 @@ void StreamingVoice::renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int
         }
     }
 
+    currentLevel = blockEndLevel;
+
     // Update atomic read position after processing block
     if (isStreaming)
     {
         readPosition.store(static_cast<int64_t>(sourceSamplePosition), std::memory_order_release);
         checkAndRequestData();
 
+        // Until then the preload is all there is: remember how low it got
+        if (awaitingFirstRefill)
+            lowestBufferedFrames = std::min(lowestBufferedFrames, static_cast<int>(currentWritePos - currentReadPos));
+
         // Periodic debug logging of ring buffer state
         static int debugBlockCounter = 0;
         if (++debugBlockCounter % 100 == 0)  // Every ~2 seconds at 512 samples/block
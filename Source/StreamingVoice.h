@@ -3,6 +3,7 @@
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_audio_formats/juce_audio_formats.h>
 #include <atomic>
+#include <memory>
 #include "DiskStreaming.h"
 
 /**
@@ -31,6 +32,13 @@ public:
     uint64_t getVoiceStartCounter() const { return voiceStartCounter; }
     bool isQuickFadingOut() const { return isQuickFading; }
 
+    // Voice stealing inputs (audio thread)
+    bool isReleasing() const { return released; }       // Key (and pedal) up, envelope in release
+    float getVelocity() const { return velocity; }
+    float getCurrentLevel() const { return currentLevel; }  // Output gain at the end of the last block
+    bool isStreamingFromDisk() const;                   // Still reading its sample from disk
+    int64_t getSourceReadPosition() const { return readPosition.load(std::memory_order_relaxed); }  // Frames consumed (streaming voices)
+
     // Audio thread interface
     void renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples);
     bool isActive() const { return active.load(std::memory_order_acquire); }
@@ -41,8 +49,9 @@ public:
     void setSustainPedal(bool isDown);
     bool isSustainedByPedal() const { return sustainedByPedal; }
 
-    // ADSR
-    void setADSRParameters(const juce::ADSR::Parameters& params);
+    // ADSR (generation = the engine's ADSR change counter these parameters came from)
+    void setADSRParameters(const juce::ADSR::Parameters& params, uint32_t generation);
+    uint32_t getADSRGeneration() const { return adsrGeneration; }
     void prepareToPlay(double sampleRate, int samplesPerBlock);
 
     // Ring buffer access for disk thread (thread-safe)
@@ -66,19 +75,36 @@ public:
     void setReadError(bool error) { readError.store(error, std::memory_order_release); }
     bool hasReadError() const { return readError.load(std::memory_order_acquire); }
 
+    // Share of its preload the voice played before the disk's first refill arrived (1 if it
+    // underran first), once per play; -1 until then or if it isn't streaming. Audio thread.
+    float takeRefillLag();
+
+    // True if the voice started underrunning since the last call. Audio thread.
+    bool takeUnderran();
+
     // Underrun tracking (shared across all voices)
     static int getUnderrunCount() { return underrunCount.load(std::memory_order_relaxed); }
     static void resetUnderrunCount() { underrunCount.store(0, std::memory_order_relaxed); }
 
-    // Sample info for disk thread
-    const PreloadedSample* getCurrentSample() const { return currentSample; }
+    // Pin the ring buffer into RAM (MemoryLock), or unpin it. Returns true if it is locked;
+    // if the OS refuses, the ring is pre-touched instead and false is returned. Not the audio thread.
+    bool setRingLocked(bool shouldLock);
+    size_t getRingBytes() const { return static_cast<size_t>(ringBuffer.getNumChannels() * ringBuffer.getNumSamples()) * sizeof(float); }
+
+    // Sample info for disk thread (and for deciding when a retired sample can be freed)
+    const PreloadedSample* getCurrentSample() const { return currentSample.load(std::memory_order_acquire); }
 
 private:
     // Current sample being played (set at voice start, read by disk thread)
-    const PreloadedSample* currentSample = nullptr;
+    std::atomic<const PreloadedSample*> currentSample{nullptr};
 
-    // Ring buffer for streaming audio (stereo capable)
+    // Ring buffer for streaming audio (stereo capable). It refers to ringStorage: pages of
+    // its own, so locking or unlocking one voice's ring never touches another's pages.
+    struct PagesDeleter { void operator()(float* data) const; };
+    std::unique_ptr<float, PagesDeleter> ringStorage;
+    size_t ringStorageBytes = 0;
     juce::AudioBuffer<float> ringBuffer;
+    bool ringLocked = false;
 
     // Lock-free SPSC (Single Producer Single Consumer) positions
     std::atomic<int64_t> readPosition{0};   // Audio thread owns writes
@@ -102,12 +128,22 @@ private:
 
     // Envelope
     juce::ADSR adsr;
+    uint32_t adsrGeneration = 0;
     bool sustainedByPedal = false;
+    bool released = false;
+    float currentLevel = 0.0f;
 
     // Underrun protection
     bool isUnderrunning = false;
     int underrunFadePosition = 0;
 
+    // Refill lag: how low the ring buffer got before the first refill
+    bool awaitingFirstRefill = false;
+    int initialBufferedFrames = 0;
+    int lowestBufferedFrames = 0;
+    float refillLag = -1.0f;
+    bool underran = false;  // This voice's own underruns, for its sample's budget weight and adaptive size
+
     // Quick fade for same-note voice stealing (10ms)
     bool isQuickFading = false;
     float quickFadeLevel = 1.0f;
@@ -0,0 +1,113 @@
+#include "VoicePool.h"
+
+VoicePool::VoicePool(int numVoices)
+    : activeNext(static_cast<size_t>(numVoices)),
+      activePrev(static_cast<size_t>(numVoices)),
+      noteNext(static_cast<size_t>(numVoices)),
+      notePrev(static_cast<size_t>(numVoices)),
+      voiceNote(static_cast<size_t>(numVoices))
+{
+    reset();
+}
+
+void VoicePool::reset()
+{
+    const int numVoices = getNumVoices();
+
+    // Free list in slot order, so the first notes get the lowest slots
+    for (int i = 0; i < numVoices; ++i)
+    {
+        const size_t slot = static_cast<size_t>(i);
+        activeNext[slot] = static_cast<int16_t>(i + 1 < numVoices ? i + 1 : none);
+        activePrev[slot] = none;
+        noteNext[slot] = none;
+        notePrev[slot] = none;
+        voiceNote[slot] = -1;
+    }
+
+    freeHead = numVoices > 0 ? 0 : none;
+    activeHead = none;
+    activeTail = none;
+    numActive = 0;
+
+    noteHead.fill(none);
+    noteTail.fill(none);
+    noteCount.fill(0);
+}
+
+int VoicePool::allocate(int midiNote)
+{
+    if (freeHead == none || midiNote < 0 || midiNote > 127)
+        return none;
+
+    const int voice = freeHead;
+    const size_t slot = static_cast<size_t>(voice);
+    freeHead = activeNext[slot];
+
+    // Append to the active list
+    activeNext[slot] = none;
+    activePrev[slot] = static_cast<int16_t>(activeTail);
+    if (activeTail != none)
+        activeNext[static_cast<size_t>(activeTail)] = static_cast<int16_t>(voice);
+    else
+        activeHead = voice;
+    activeTail = voice;
+
+    // Append to the note's list
+    const size_t note = static_cast<size_t>(midiNote);
+    noteNext[slot] = none;
+    notePrev[slot] = noteTail[note];
+    if (noteTail[note] != none)
+        noteNext[static_cast<size_t>(noteTail[note])] = static_cast<int16_t>(voice);
+    else
+        noteHead[note] = static_cast<int16_t>(voice);
+    noteTail[note] = static_cast<int16_t>(voice);
+    ++noteCount[note];
+
+    voiceNote[slot] = static_cast<int16_t>(midiNote);
+    ++numActive;
+    return voice;
+}
+
+void VoicePool::release(int voice)
+{
+    if (voice < 0 || voice >= getNumVoices() || !isActive(voice))
+        return;
+
+    const size_t slot = static_cast<size_t>(voice);
+
+    // Unlink from the active list
+    const int prev = activePrev[slot];
+    const int next = activeNext[slot];
+    if (prev != none)
+        activeNext[static_cast<size_t>(prev)] = static_cast<int16_t>(next);
+    else
+        activeHead = next;
+    if (next != none)
+        activePrev[static_cast<size_t>(next)] = static_cast<int16_t>(prev);
+    else
+        activeTail = prev;
+
+    // Unlink from the note's list
+    const size_t note = static_cast<size_t>(voiceNote[slot]);
+    const int notePrevVoice = notePrev[slot];
+    const int noteNextVoice = noteNext[slot];
+    if (notePrevVoice != none)
+        noteNext[static_cast<size_t>(notePrevVoice)] = static_cast<int16_t>(noteNextVoice);
+    else
+        noteHead[note] = static_cast<int16_t>(noteNextVoice);
+    if (noteNextVoice != none)
+        notePrev[static_cast<size_t>(noteNextVoice)] = static_cast<int16_t>(notePrevVoice);
+    else
+        noteTail[note] = static_cast<int16_t>(notePrevVoice);
+    --noteCount[note];
+
+    // Push onto the free list (reused first, while its ring buffer is still in cache)
+    voiceNote[slot] = -1;
+    activePrev[slot] = none;
+    noteNext[slot] = none;
+    notePrev[slot] = none;
+    activeNext[slot] = static_cast<int16_t>(freeHead);
+    freeHead = voice;
+    --numActive;
+}
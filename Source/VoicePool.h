@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * VoicePool tracks which voice slots are free, active, and playing each note,
+ * using intrusive doubly linked lists over slot indices.
+ *
+ * - Free list: slots ready for a new note (most recently released first)
+ * - Active list: every sounding slot, oldest first
+ * - Note lists: active slots per MIDI note, oldest first
+ *
+ * All operations are O(1) except iteration, which only visits the slots in the
+ * list being walked. Audio thread only; nothing allocates after construction.
+ */
+class VoicePool
+{
+public:
+    static constexpr int none = -1;
+
+    explicit VoicePool(int numVoices);
+
+    /** Mark every slot free */
+    void reset();
+
+    /** Take a free slot for midiNote (appended as the newest voice), or none if all are in use */
+    int allocate(int midiNote);
+
+    /** Return an active slot to the free list */
+    void release(int voice);
+
+    bool isActive(int voice) const { return voiceNote[static_cast<size_t>(voice)] >= 0; }
+    int getNote(int voice) const { return voiceNote[static_cast<size_t>(voice)]; }
+
+    int getNumVoices() const { return static_cast<int>(voiceNote.size()); }
+    int getNumActive() const { return numActive; }
+    int getNumActiveForNote(int midiNote) const { return noteCount[static_cast<size_t>(midiNote)]; }
+
+    // Iteration (oldest first). Fetch the next slot before releasing the current one.
+    int getOldestActive() const { return activeHead; }
+    int getNextActive(int voice) const { return activeNext[static_cast<size_t>(voice)]; }
+    int getOldestForNote(int midiNote) const { return noteHead[static_cast<size_t>(midiNote)]; }
+    int getNextForNote(int voice) const { return noteNext[static_cast<size_t>(voice)]; }
+
+private:
+    // Active list links (free slots reuse activeNext as the free list link)
+    std::vector<int16_t> activeNext, activePrev;
+    std::vector<int16_t> noteNext, notePrev;
+    std::vector<int16_t> voiceNote;  // -1 = free
+
+    int activeHead = none;
+    int activeTail = none;
+    int freeHead = none;
+    int numActive = 0;
+
+    std::array<int16_t, 128> noteHead{};
+    std::array<int16_t, 128> noteTail{};
+    std::array<int16_t, 128> noteCount{};
+};
@@ -0,0 +1,29 @@
+#include "VoiceStealing.h"
+
+double OldestVoiceStealingPolicy::getStealCost(const VoiceStealInfo& voice) const
+{
+    return static_cast<double>(voice.startCounter);
+}
+
+double CostAwareStealingPolicy::getStealCost(const VoiceStealInfo& voice) const
+{
+    double stateWeight = weights.heldWeight;
+    double level = voice.velocity;
+
+    if (voice.isReleasing)
+    {
+        stateWeight = weights.releasedWeight;
+        level = voice.currentLevel;
+    }
+    else if (voice.isSustainedByPedal)
+    {
+        stateWeight = weights.pedalSustainedWeight;
+        level = voice.currentLevel;
+    }
+
+    double cost = stateWeight * level;
+    if (voice.isStreamingFromDisk)
+        cost *= weights.streamingFactor;
+
+    return cost;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+/** What a stealing policy knows about a candidate voice */
+struct VoiceStealInfo
+{
+    bool isReleasing = false;         // Key (and pedal) up, envelope in release
+    bool isSustainedByPedal = false;  // Key up but held by the sustain pedal
+    bool isStreamingFromDisk = false; // Still costs disk bandwidth
+    float velocity = 0.0f;            // 0-1
+    float currentLevel = 0.0f;        // Output gain at the end of the last block
+    uint64_t startCounter = 0;        // Lower = older
+};
+
+/**
+ * VoiceStealingPolicy decides which voice to steal when the voice pool is full:
+ * the candidate with the lowest cost loses. Ties go to the oldest voice.
+ *
+ * getStealCost() runs on the audio thread: no locks, allocation or I/O.
+ */
+class VoiceStealingPolicy
+{
+public:
+    virtual ~VoiceStealingPolicy() = default;
+
+    virtual double getStealCost(const VoiceStealInfo& voice) const = 0;
+};
+
+/** Steals the oldest voice regardless of what it is playing */
+class OldestVoiceStealingPolicy : public VoiceStealingPolicy
+{
+public:
+    double getStealCost(const VoiceStealInfo& voice) const override;
+};
+
+/**
+ * Steals the voice that is least audible and cheapest to keep:
+ * - released tails before pedal-sustained notes before held keys
+ * - quieter before louder (current envelope level for released voices,
+ *   velocity for held ones, whose envelope may still be in its attack)
+ * - voices streaming from disk are slightly preferred, freeing bandwidth
+ */
+class CostAwareStealingPolicy : public VoiceStealingPolicy
+{
+public:
+    struct Weights
+    {
+        double releasedWeight = 1.0;
+        double pedalSustainedWeight = 4.0;
+        double heldWeight = 16.0;
+        double streamingFactor = 0.75;  // Cost multiplier for voices reading from disk
+    };
+
+    CostAwareStealingPolicy() = default;
+    explicit CostAwareStealingPolicy(const Weights& w) : weights(w) {}
+
+    double getStealCost(const VoiceStealInfo& voice) const override;
+
+private:
+    Weights weights;
+};
@@ -0,0 +1,68 @@
+#include "WorkingSet.h"
+#include <algorithm>
+
+void WorkingSet::sortByPriority()
+{
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b)
+    {
+        if (a.plays != b.plays)
+            return a.plays > b.plays;
+        return a.framesPlayed > b.framesPlayed;
+    });
+}
+
+juce::String WorkingSet::toString() const
+{
+    if (entries.empty())
+        return {};
+
+    auto sorted = *this;
+    sorted.sortByPriority();
+    const size_t count = std::min(sorted.entries.size(), maxEntries);
+
+    juce::MemoryOutputStream out;
+    out.writeByte(static_cast<char>(formatVersion));
+    out.writeInt(static_cast<int>(count));
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto& entry = sorted.entries[i];
+        out.writeByte(static_cast<char>(juce::jlimit(0, 127, entry.midiNote)));
+        out.writeByte(static_cast<char>(juce::jlimit(0, 127, entry.velocity)));
+        out.writeShort(static_cast<short>(juce::jlimit(0, 32767, entry.roundRobin)));
+        out.writeInt(static_cast<int>(std::min<uint32_t>(entry.plays, 0x7fffffff)));
+        out.writeInt(static_cast<int>(juce::jlimit<int64_t>(0, 0x7fffffff, entry.framesPlayed)));
+    }
+
+    return out.getMemoryBlock().toBase64Encoding();
+}
+
+WorkingSet WorkingSet::fromString(const juce::String& text)
+{
+    WorkingSet result;
+
+    juce::MemoryBlock data;
+    if (text.isEmpty() || !data.fromBase64Encoding(text) || data.getSize() < 5)
+        return result;
+
+    juce::MemoryInputStream in(data, false);
+    if (in.readByte() != formatVersion)
+        return result;
+
+    const int count = in.readInt();
+    constexpr int64_t entryBytes = 12;
+    if (count < 0 || static_cast<size_t>(count) > maxEntries || in.getTotalLength() - in.getPosition() != count * entryBytes)
+        return result;
+
+    result.entries.resize(static_cast<size_t>(count));
+    for (auto& entry : result.entries)
+    {
+        entry.midiNote = in.readByte();
+        entry.velocity = in.readByte();
+        entry.roundRobin = in.readShort();
+        entry.plays = static_cast<uint32_t>(in.readInt());
+        entry.framesPlayed = in.readInt();
+    }
+
+    return result;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cstdint>
+#include <vector>
+
+/**
+ * WorkingSet is the part of a library a session actually played: which samples,
+ * how often, and how far into each file. It is saved with the plugin state so
+ * the next load can warm exactly those samples before anything else.
+ *
+ * Samples are identified by (note, velocity, round robin) from their file names,
+ * so the set survives the library moving to another folder.
+ *
+ * Stored as base64 of a small binary record per sample (12 bytes), keeping the
+ * plugin state compact even for sessions that touch thousands of samples.
+ */
+class WorkingSet
+{
+public:
+    struct Entry
+    {
+        int midiNote = 0;
+        int velocity = 0;
+        int roundRobin = 0;
+        uint32_t plays = 0;
+        int64_t framesPlayed = 0;  // Furthest frame into the file any voice reached
+    };
+
+    static constexpr int formatVersion = 1;
+    static constexpr size_t maxEntries = 8192;  // Most-played first beyond this
+
+    std::vector<Entry> entries;
+
+    /** Most-played first, then furthest played */
+    void sortByPriority();
+
+    juce::String toString() const;
+
+    /** Empty set if the string is empty, malformed or from a newer version */
+    static WorkingSet fromString(const juce::String& text);
+};
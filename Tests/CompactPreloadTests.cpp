@@ -0,0 +1,181 @@
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "../Source/LibraryScanner.h"
+#include "../Source/SamplerEngine.h"
+#include "../Source/StreamingVoice.h"
+#include "TestAudioFiles.h"
+
+//==============================================================================
+// Compact Preload Tests
+//==============================================================================
+class CompactPreloadTests : public juce::UnitTest
+{
+public:
+    CompactPreloadTests() : juce::UnitTest("Compact Preloads") {}
+
+    void runTest() override
+    {
+        beginTest("16- and 24-bit samples round trip exactly");
+        {
+            for (int bits : { 16, 24 })
+            {
+                const float scale = bits == 16 ? 32768.0f : 8388608.0f;
+                const std::vector<float> values = { 0.0f, 1.0f / scale, -1.0f / scale, 0.5f, -1.0f,
+                                                    (scale - 1.0f) / scale, 12345.0f / scale, -23456.0f / scale };
+
+                std::vector<char> storage(values.size() * 2 * static_cast<size_t>(bits / 8));
+                PreloadedSample preload;
+                preload.numChannels = 2;
+                preload.compactBits = bits;
+                preload.compactData = storage.data();
+                preload.compactFrames = static_cast<int>(values.size());
+
+                const std::vector<float> negated = [&] { auto v = values; for (auto& x : v) x = -x; return v; }();
+                preload.writeCompact(0, 0, values.data(), preload.compactFrames);
+                preload.writeCompact(1, 0, negated.data(), preload.compactFrames);
+                expect(preload.getPreloadBytes() == static_cast<int64_t>(storage.size()));
+
+                std::vector<float> read(values.size());
+                preload.readPreload(0, 0, read.data(), preload.compactFrames);
+                for (size_t i = 0; i < values.size(); ++i)
+                {
+                    expect(read[i] == values[i]);
+                    expect(preload.getPreloadSample(1, static_cast<int>(i)) == juce::jlimit(-1.0f, (scale - 1.0f) / scale, -values[i]));
+                }
+
+                // Out of range clips instead of wrapping
+                const float loud[] = { 1.5f, -1.5f };
+                preload.writeCompact(0, 0, loud, 2);
+                expect(preload.getPreloadSample(0, 0) == (scale - 1.0f) / scale);
+                expect(preload.getPreloadSample(0, 1) == -1.0f);
+            }
+        }
+
+        TestAudioFiles::TempFolder library("HammerSamplerCompactPreloads");
+        for (auto note : { "C4", "D4" })
+            for (auto velocity : { "064", "127" })
+                TestAudioFiles::writeRampWav(library.folder.getChildFile(juce::String(note) + "_" + velocity + "_01.wav"), 2000);
+
+        beginTest("A voice plays a compact preload exactly like a float one");
+        {
+            juce::AudioFormatManager formatManager;
+            formatManager.registerBasicFormats();
+            LibraryScanner::Options options;
+            options.parseFileName = &SamplerEngine::parseFileName;
+            auto scanned = LibraryScanner(formatManager).scan(library.folder, options);
+            expect(!scanned.empty());
+            const auto decoded = TestAudioFiles::decodePreload(scanned.front().info, 64);
+            expect(decoded != nullptr);
+            const auto& floatPreload = *decoded;
+            expect(floatPreload.integerBits == 16);
+
+            std::vector<char> storage(static_cast<size_t>(floatPreload.preloadSizeFrames) * 2 * 2);
+            PreloadedSample compact = scanned.front().info;
+            compact.compactBits = 16;
+            compact.compactData = storage.data();
+            compact.compactFrames = floatPreload.preloadSizeFrames;
+            compact.preloadSizeFrames = floatPreload.preloadSizeFrames;
+            for (int channel = 0; channel < 2; ++channel)
+                compact.writeCompact(channel, 0, floatPreload.preloadBuffer.getReadPointer(channel), compact.compactFrames);
+
+            auto render = [](const PreloadedSample& sample)
+            {
+                StreamingVoice voice;
+                voice.prepareToPlay(44100.0, 512);
+                voice.setADSRParameters({ 0.0f, 0.0f, 1.0f, 0.1f }, 1);
+                juce::AudioBuffer<float> buffer(2, 512);
+                buffer.clear();
+                voice.startVoice(&sample, sample.rootNote + 3, 1.0f, 44100.0);  // Interpolated
+                voice.renderNextBlock(buffer, 0, 512);
+                return buffer;
+            };
+
+            const auto expected = render(floatPreload);
+            const auto actual = render(compact);
+            expect(expected.getMagnitude(0, 512) > 0.0f);
+            for (int channel = 0; channel < 2; ++channel)
+                expect(std::memcmp(expected.getReadPointer(channel), actual.getReadPointer(channel), 512 * sizeof(float)) == 0);
+        }
+
+        beginTest("The engine keeps 16-bit preloads in half the RAM, converts them and maps compact snapshots");
+        {
+            TestAudioFiles::TempFolder cache("HammerSamplerCompactPreloadCache");
+            const auto snapshotFolder = cache.folder.getChildFile("PreloadSnapshots");
+
+            constexpr int64_t floatBytes = 4 * 2000 * 2 * 4;
+
+            auto playNote = [](SamplerEngine& engine)
+            {
+                juce::AudioBuffer<float> buffer(2, 512);
+                buffer.clear();
+                SamplerEngine::AudioBlockScope audioBlock(engine);
+                engine.noteOn(62, 100, 1);
+                engine.processBlock(buffer);
+
+                // Let the voice finish so the next play starts alone
+                engine.noteOff(62);
+                juce::AudioBuffer<float> tail(2, 512);
+                for (int block = 0; block < 1000 && engine.getActiveVoiceCount() > 0; ++block)
+                    engine.processBlock(tail);
+                return buffer;
+            };
+
+            SamplerEngine floatEngine;
+            floatEngine.setCacheDirectory(cache.folder);
+            floatEngine.prepareToPlay(44100.0, 512);
+            floatEngine.setVelocityLayerLimit(2);
+            floatEngine.loadSamplesFromFolder(library.folder);
+            expect(TestAudioFiles::waitFor([&] { return floatEngine.getLoadStage() == LoadStage::Complete && !floatEngine.getPreloadProgress().inProgress; }));
+            expect(floatEngine.getPreloadMemoryBytes() == floatBytes);
+            const auto expected = playNote(floatEngine);
+            expect(expected.getMagnitude(0, 512) > 0.0f);
+
+            auto matchesFloat = [&](const juce::AudioBuffer<float>& buffer)
+            {
+                for (int channel = 0; channel < 2; ++channel)
+                    if (std::memcmp(expected.getReadPointer(channel), buffer.getReadPointer(channel), 512 * sizeof(float)) != 0)
+                        return false;
+                return true;
+            };
+
+            {
+                SamplerEngine engine;
+                engine.setCacheDirectory(cache.folder);
+                engine.prepareToPlay(44100.0, 512);
+                engine.setVelocityLayerLimit(2);
+                engine.setCompactPreloads(true);
+                engine.loadSamplesFromFolder(library.folder);
+                expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete && !engine.getPreloadProgress().inProgress; }));
+                expect(engine.getPreloadMemoryBytes() == floatBytes / 2);
+                expect(engine.getPreloadArenaStats().usedBytes == floatBytes / 2);
+                expect(matchesFloat(playNote(engine)));
+
+                // The compact snapshot is written once the library is complete
+                expect(TestAudioFiles::waitFor([&] { return snapshotFolder.findChildFiles(juce::File::findFiles, false, "*_c.snap").size() == 1; }));
+
+                // Off and on again: converted in memory both ways
+                engine.setCompactPreloads(false);
+                expect(TestAudioFiles::waitFor([&] { return engine.getPreloadMemoryBytes() == floatBytes; }));
+                expect(matchesFloat(playNote(engine)));
+                engine.setCompactPreloads(true);
+                expect(TestAudioFiles::waitFor([&] { return engine.getPreloadMemoryBytes() == floatBytes / 2; }));
+                expect(matchesFloat(playNote(engine)));
+                expect(TestAudioFiles::waitFor([&] { return !engine.getPreloadProgress().inProgress; }));
+            }
+
+            // The next compact load maps the snapshot instead of reading the files
+            SamplerEngine reopened;
+            reopened.setCacheDirectory(cache.folder);
+            reopened.prepareToPlay(44100.0, 512);
+            reopened.setVelocityLayerLimit(2);
+            reopened.setCompactPreloads(true);
+            reopened.loadSamplesFromFolder(library.folder);
+            expect(TestAudioFiles::waitFor([&] { return reopened.getLoadStage() == LoadStage::Complete && !reopened.getPreloadProgress().inProgress; }));
+            expect(reopened.getPreloadMemoryBytes() == floatBytes / 2);
+            expect(reopened.getPreloadArenaStats().blocks == 0);  // All mapped
+            expect(matchesFloat(playNote(reopened)));
+        }
+    }
+};
+
+static CompactPreloadTests compactPreloadTests;
@@ -0,0 +1,174 @@
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <thread>
+#include "../Source/DeferredReclaimer.h"
+#include "../Source/SamplerEngine.h"
+#include "TestAudioFiles.h"
+
+//==============================================================================
+// Deferred Reclaimer Tests
+//==============================================================================
+class DeferredReclaimerTests : public juce::UnitTest
+{
+public:
+    DeferredReclaimerTests() : juce::UnitTest("Deferred Reclamation") {}
+
+    void runTest() override
+    {
+        beginTest("An object in use waits for its users, then for readers that reached it through them");
+        {
+            DeferredReclaimer reclaimer;
+            std::atomic<int> destroyed{0};
+            std::atomic<bool> voicePlaying{true};
+
+            reclaimer.retire(std::make_unique<Tracked>(destroyed), [&voicePlaying] { return voicePlaying.load(); });
+            expectEquals(reclaimer.collect(), 1);
+
+            // The disk thread reads the voice's sample, then the voice stops mid-pass
+            {
+                DeferredReclaimer::ReadScope diskPass(reclaimer, DeferredReclaimer::diskThreadReader);
+                voicePlaying = false;
+                expectEquals(reclaimer.collect(), 1);
+                expectEquals(destroyed.load(), 0);
+            }
+            expectEquals(reclaimer.collect(), 0);
+            expectEquals(destroyed.load(), 1);
+
+            // Let go with no reader inside a pass: freed by that very collect
+            voicePlaying = true;
+            reclaimer.retire(std::make_unique<Tracked>(destroyed), [&voicePlaying] { return voicePlaying.load(); });
+            expectEquals(reclaimer.collect(), 1);
+            voicePlaying = false;
+            expectEquals(reclaimer.collect(), 0);
+            expectEquals(destroyed.load(), 2);
+        }
+
+        beginTest("Limits, preload sizes and formats change continuously while notes play");
+        {
+            // Four notes x three velocities x three round robins, all longer than their preloads
+            TestAudioFiles::TempFolder library("HammerSamplerReclaimStress");
+            TestAudioFiles::TempFolder cache("HammerSamplerReclaimStressCache");
+            constexpr int numSamples = 4 * 3 * 3;
+            for (const char* note : { "C4", "D4", "E4", "F4" })
+                for (const char* velocity : { "40", "80", "127" })
+                    for (const char* roundRobin : { "01", "02", "03" })
+                        TestAudioFiles::writeRampWav(library.folder.getChildFile(juce::String(note) + "_" + velocity + "_" + roundRobin + ".wav"), 60000);
+
+            // A smaller library to switch to: a load abandons whatever resize is in progress
+            TestAudioFiles::TempFolder otherLibrary("HammerSamplerReclaimStressOther");
+            for (const char* note : { "C4", "E4" })
+                for (const char* velocity : { "64", "127" })
+                    TestAudioFiles::writeRampWav(otherLibrary.folder.getChildFile(juce::String(note) + "_" + velocity + "_01.wav"), 60000);
+
+            std::atomic<double> availableFraction{0.5};
+            SamplerEngine engine;
+            engine.setCacheDirectory(cache.folder);
+            engine.setMemoryPressureSource([&availableFraction]
+            {
+                MemoryPressure::Reading reading;
+                reading.totalBytes = 1024 * 1024 * 1024;
+                reading.availableBytes = static_cast<int64_t>(availableFraction.load() * static_cast<double>(reading.totalBytes));
+                return reading;
+            });
+            engine.prepareToPlay(44100.0, 256);
+            engine.loadSamplesFromFolder(library.folder);
+            expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete && !engine.getPreloadProgress().inProgress; }));
+
+            // Every change a user (or memory pressure) can make that retires, resizes or replaces preloads
+            std::atomic<bool> playing{true};
+            std::atomic<int> changes{0};
+            std::thread control([&]
+            {
+                std::mt19937 random(75);
+                while (playing.load())
+                {
+                    switch (random() % 7)
+                    {
+                        case 0: engine.setVelocityLayerLimit(1 + static_cast<int>(random() % 3)); break;
+                        case 1: engine.setRoundRobinLimit(1 + static_cast<int>(random() % 3)); break;
+                        case 2: engine.setPreloadSizeKB(32 << (random() % 4)); engine.reloadPreloadBuffers(); break;
+                        case 3: engine.setCompactPreloads(random() % 2 == 0); break;
+                        case 4: engine.setPreloadBudgetMB(static_cast<int>(random() % 2)); break;
+                        case 5: engine.loadSamplesFromFolder(random() % 2 == 0 ? otherLibrary.folder : library.folder); break;
+                        default: availableFraction = (random() % 3 == 0) ? 0.03 : 0.5; break;
+                    }
+                    ++changes;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2 + random() % 10));
+                }
+            });
+
+            // Notes start and stop every few blocks, so voices hold every generation of preload
+            std::mt19937 random(42);
+            juce::AudioBuffer<float> buffer(2, 256);
+            bool clean = true;
+            const auto end = juce::Time::getMillisecondCounter() + 3000;
+            for (int block = 0; juce::Time::getMillisecondCounter() < end; ++block)
+            {
+                {
+                    SamplerEngine::AudioBlockScope audioBlock(engine);
+                    const int note = 60 + 2 * static_cast<int>(random() % 3) + (random() % 4 == 0 ? 5 : 0);
+                    if (block % 3 == 0)
+                        engine.noteOn(note, 1 + static_cast<int>(random() % 127), 1);
+                    else if (block % 7 == 0)
+                        engine.noteOff(note);
+                    engine.processBlock(buffer);
+                }
+
+                // A full voice stack of ramps peaks well under this; garbage read from freed memory rarely does
+                for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                    for (int i = 0; i < buffer.getNumSamples(); ++i)
+                        clean = clean && std::isfinite(buffer.getSample(channel, i)) && std::abs(buffer.getSample(channel, i)) < 1024.0f;
+                juce::Thread::sleep(1);  // About real time for the disk thread
+            }
+
+            playing = false;
+            control.join();
+            expect(clean);
+            expectGreaterThan(changes.load(), 100);
+
+            // Everything retired is freed once the voices finish
+            for (int note : { 60, 62, 64, 65 })
+            {
+                SamplerEngine::AudioBlockScope audioBlock(engine);
+                engine.noteOff(note);
+            }
+            expect(TestAudioFiles::waitFor([&]
+            {
+                SamplerEngine::AudioBlockScope audioBlock(engine);
+                engine.processBlock(buffer);
+                return engine.getActiveVoiceCount() == 0;
+            }));
+            expect(TestAudioFiles::waitFor([&] { return engine.getPendingReclaimCount() == 0; }));
+
+            // And the library ends up exactly as the final settings say
+            engine.loadSamplesFromFolder(library.folder);
+            expect(TestAudioFiles::waitFor([&] { return !engine.isLoading() && engine.getLoadStage() == LoadStage::Complete; }, 10000));
+            availableFraction = 0.5;
+            engine.setMemoryPressureResponse(false);
+            engine.setVelocityLayerLimit(3);
+            engine.setRoundRobinLimit(3);
+            engine.setPreloadBudgetMB(0);
+            engine.setCompactPreloads(false);
+            engine.setPreloadSizeKB(64);
+            engine.reloadPreloadBuffers();
+            expect(TestAudioFiles::waitFor([&]
+            {
+                return !engine.getPreloadProgress().inProgress && engine.getLoadStage() == LoadStage::Complete &&
+                       engine.getPreloadMemoryBytes() == int64_t(numSamples) * 64 * 1024;
+            }, 10000));
+        }
+    }
+
+private:
+    struct Tracked
+    {
+        explicit Tracked(std::atomic<int>& counter) : destroyed(counter) {}
+        ~Tracked() { ++destroyed; }
+        std::atomic<int>& destroyed;
+    };
+};
+
+static DeferredReclaimerTests deferredReclaimerTests;
@@ -0,0 +1,116 @@
+#include <juce_core/juce_core.h>
+#include <thread>
+#include "../Source/EngineCommandQueue.h"
+
+//==============================================================================
+// Engine Command Queue Tests
+//==============================================================================
+class EngineCommandQueueTests : public juce::UnitTest
+{
+public:
+    EngineCommandQueueTests() : juce::UnitTest("Engine Command Queue") {}
+
+    void runTest() override
+    {
+        beginTest("Only changed parameters drain, in type order");
+        {
+            EngineCommandQueue queue;
+            expect(queue.drain([](const EngineCommand&) {}) == 0);
+
+            queue.push(makeCommand(3));
+            queue.push(makeADSR(0.5f));
+
+            std::vector<EngineCommand::Type> drained;
+            int count = queue.drain([&](const EngineCommand& c) { drained.push_back(c.type); });
+
+            expect(count == 2);
+            expect(drained == std::vector<EngineCommand::Type>({ EngineCommand::Type::setADSR, EngineCommand::Type::setRoundRobinLimit }));
+            expect(queue.drain([](const EngineCommand&) {}) == 0);
+        }
+
+        beginTest("Changes made while nothing drains coalesce, and none is lost");
+        {
+            EngineCommandQueue queue;
+            for (int i = 0; i < 10000; ++i)
+            {
+                queue.push(makeCommand(i));
+                queue.push(makeADSR(static_cast<float>(i)));
+            }
+
+            int limit = -1;
+            float attack = -1.0f;
+            int count = queue.drain([&](const EngineCommand& c)
+            {
+                if (c.type == EngineCommand::Type::setRoundRobinLimit)
+                    limit = c.intValue;
+                else
+                    attack = c.floatValues[0];
+            });
+
+            expect(count == 2);
+            expect(limit == 9999 && attack == 9999.0f);
+        }
+
+        beginTest("Concurrent producers and consumer");
+        {
+            EngineCommandQueue queue;
+            constexpr int perProducer = 20000;
+            std::atomic<int> producersDone{0};
+            bool untorn = true;
+            bool noRepeats = true;
+            float lastAttack = -1.0f;
+
+            // Every value is pushed once; all four floats of a command are the same
+            auto produce = [&](int offset)
+            {
+                for (int i = 0; i < perProducer; ++i)
+                    queue.push(makeADSR(static_cast<float>(offset + i)));
+                ++producersDone;
+            };
+
+            auto consume = [&](const EngineCommand& c)
+            {
+                for (float value : c.floatValues)
+                    untorn = untorn && value == c.floatValues[0];
+                noRepeats = noRepeats && c.floatValues[0] != lastAttack;
+                lastAttack = c.floatValues[0];
+            };
+
+            std::thread producerA(produce, 0);
+            std::thread producerB(produce, perProducer);
+
+            while (producersDone.load() < 2)
+            {
+                queue.drain(consume);
+                std::this_thread::yield();
+            }
+
+            producerA.join();
+            producerB.join();
+            queue.drain(consume);
+
+            expect(untorn);
+            expect(noRepeats);  // Never the same change twice
+            expect(lastAttack == static_cast<float>(perProducer - 1) || lastAttack == static_cast<float>(2 * perProducer - 1));
+        }
+    }
+
+private:
+    static EngineCommand makeCommand(int value)
+    {
+        EngineCommand command;
+        command.type = EngineCommand::Type::setRoundRobinLimit;
+        command.intValue = value;
+        return command;
+    }
+
+    static EngineCommand makeADSR(float value)
+    {
+        EngineCommand command;
+        command.type = EngineCommand::Type::setADSR;
+        command.floatValues = { value, value, value, value };
+        return command;
+    }
+};
+
+static EngineCommandQueueTests engineCommandQueueTests;
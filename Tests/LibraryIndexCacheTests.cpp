@@ -0,0 +1,210 @@
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "../Source/LibraryIndexCache.h"
+#include "../Source/LibraryScanner.h"
+#include "../Source/SamplerEngine.h"
+#include "TestAudioFiles.h"
+
+//==============================================================================
+// Library Index Cache Tests
+//==============================================================================
+class LibraryIndexCacheTests : public juce::UnitTest
+{
+public:
+    LibraryIndexCacheTests() : juce::UnitTest("Library Index Cache") {}
+
+    void runTest() override
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        TestAudioFiles::TempFolder library("HammerSamplerIndexLibrary");
+        TestAudioFiles::TempFolder cacheFolder("HammerSamplerIndexCache");
+        const auto& folder = library.folder;
+
+        const auto c4 = folder.getChildFile("C4_100_01.wav");
+        const auto d4 = folder.getChildFile("Strings/D4_064_02.wav");
+        TestAudioFiles::writeRampWav(c4, 50000);
+        TestAudioFiles::writeRampWav(d4, 1000, 48000);
+
+        LibraryScanner::Options options;
+        options.parseFileName = &SamplerEngine::parseFileName;
+
+        // What the engine stores after a scan
+        auto indexScan = [&](LibraryIndexCache& cache, const std::vector<LibraryScanner::ScannedSample>& scanned)
+        {
+            std::vector<LibraryIndexCache::Entry> entries;
+            for (const auto& sample : scanned)
+            {
+                auto entry = cache.makeEntry(sample.info.path.getFile());
+                entry.midiNote = sample.midiNote;
+                entry.velocity = sample.velocity;
+                entry.roundRobin = sample.roundRobin;
+                entry.totalFrames = sample.info.totalSampleFrames;
+                entry.sampleRate = sample.info.sampleRate;
+                entry.numChannels = sample.info.numChannels;
+                entry.dataOffset = sample.dataOffset;
+                entries.push_back(entry);
+            }
+            cache.setEntries(std::move(entries));
+        };
+
+        beginTest("Scan finds the WAV data offset");
+        {
+            auto scanned = LibraryScanner(formatManager).scan(folder, options);
+            expect(scanned.size() == 2);
+            for (const auto& sample : scanned)
+                expect(sample.dataOffset == 44);  // Canonical 44-byte header
+        }
+
+        beginTest("Round trip through disk");
+        {
+            LibraryIndexCache cache(folder, cacheFolder.folder);
+            expect(!cache.load());  // Nothing saved yet
+
+            indexScan(cache, LibraryScanner(formatManager).scan(folder, options));
+            expect(cache.save());
+            expect(cache.getIndexFile().existsAsFile());
+
+            LibraryIndexCache reloaded(folder, cacheFolder.folder);
+            expect(reloaded.load());
+            expect(reloaded.getEntries().size() == 2);
+
+            const auto* entry = reloaded.find(d4);
+            expect(entry != nullptr);
+            if (entry != nullptr)
+            {
+                expect(entry->midiNote == 62 && entry->velocity == 64 && entry->roundRobin == 2);
+                expect(entry->totalFrames == 1000);
+                expect(entry->sampleRate == 48000.0);
+                expect(entry->numChannels == 2);
+                expect(entry->dataOffset == 44);
+            }
+        }
+
+        beginTest("Changed, new and removed files are rescanned");
+        {
+            LibraryIndexCache cache(folder, cacheFolder.folder);
+            expect(cache.load());
+
+            // Same name, new size and time; a new file alongside
+            TestAudioFiles::writeRampWav(c4, 30000);
+            c4.setLastModificationTime(juce::Time(c4.getLastModificationTime().toMilliseconds() + 2000));
+            const auto e4 = folder.getChildFile("E4_100_01.wav");
+            TestAudioFiles::writeRampWav(e4, 2000);
+
+            juce::Array<juce::File> filesToScan;
+            for (const auto& file : LibraryScanner::findAudioFiles(folder, true))
+            {
+                if (cache.find(file) == nullptr)
+                    filesToScan.add(file);
+            }
+
+            expect(filesToScan.size() == 2);
+            expect(filesToScan.contains(c4) && filesToScan.contains(e4));
+            expect(cache.find(d4) != nullptr);
+
+            auto rescanned = LibraryScanner(formatManager).scanFiles(filesToScan, options);
+            expect(rescanned.size() == 2);
+            if (rescanned.size() == 2)
+                expect(rescanned[0].info.totalSampleFrames == 30000);
+
+            // A deleted file simply stops matching
+            e4.deleteFile();
+            expect(cache.find(e4) == nullptr);
+        }
+
+        beginTest("Corrupt, truncated and foreign indexes are rejected");
+        {
+            LibraryIndexCache cache(folder, cacheFolder.folder);
+            indexScan(cache, LibraryScanner(formatManager).scan(folder, options));
+            expect(cache.save());
+
+            juce::MemoryBlock saved;
+            expect(cache.getIndexFile().loadFileAsData(saved));
+
+            // Truncated inside the last entry
+            cache.getIndexFile().replaceWithData(saved.getData(), saved.getSize() - 3);
+            expect(!LibraryIndexCache(folder, cacheFolder.folder).load());
+
+            // Future format version
+            auto bumped = saved;
+            bumped[4] = static_cast<char>(LibraryIndexCache::formatVersion + 1);
+            cache.getIndexFile().replaceWithData(bumped.getData(), bumped.getSize());
+            expect(!LibraryIndexCache(folder, cacheFolder.folder).load());
+
+            cache.getIndexFile().replaceWithText("not an index");
+            LibraryIndexCache garbage(folder, cacheFolder.folder);
+            expect(!garbage.load());
+            expect(garbage.getEntries().empty());
+
+            // Another library never sees this one's index
+            cache.getIndexFile().replaceWithData(saved.getData(), saved.getSize());
+            expect(LibraryIndexCache(folder, cacheFolder.folder).load());
+            expect(!LibraryIndexCache(folder.getChildFile("Strings"), cacheFolder.folder).load());
+        }
+
+        beginTest("Data offset of other layouts");
+        {
+            // WAV with a LIST chunk before the data, and a minimal AIFF
+            juce::MemoryOutputStream wav;
+            wav.write("RIFF\0\0\0\0WAVE", 12);
+            wav.write("LIST", 4); wav.writeInt(5); wav.write("abcde\0", 6);  // Odd size is padded
+            wav.write("data", 4); wav.writeInt(0);
+            juce::MemoryInputStream wavStream(wav.getData(), wav.getDataSize(), false);
+            expect(LibraryScanner::findDataOffset(wavStream) == 34);
+
+            const char aiff[] = { 'F','O','R','M', 0,0,0,0, 'A','I','F','F',
+                                  'S','S','N','D', 0,0,0,8, 0,0,0,4, 0,0,0,0 };
+            juce::MemoryInputStream aiffStream(aiff, sizeof(aiff), false);
+            expect(LibraryScanner::findDataOffset(aiffStream) == 32);
+
+            juce::MemoryInputStream garbage("nothing here", 12, false);
+            expect(LibraryScanner::findDataOffset(garbage) == -1);
+        }
+
+        beginTest("Files that aren't samples are indexed, and not reopened until they change");
+        {
+            TestAudioFiles::TempFolder engineLibrary("HammerSamplerIndexNotSamples");
+            TestAudioFiles::TempFolder cache("HammerSamplerIndexNotSamplesCache");
+            const auto e4 = engineLibrary.folder.getChildFile("E4_100_01.wav");
+            TestAudioFiles::writeRampWav(engineLibrary.folder.getChildFile("C4_100_01.wav"), 2000);
+            TestAudioFiles::writeRampWav(engineLibrary.folder.getChildFile("readme.wav"), 2000);  // Name doesn't parse
+            e4.replaceWithText("not audio");                                                      // Doesn't open
+
+            auto load = [&]
+            {
+                auto engine = std::make_unique<SamplerEngine>();
+                engine->setCacheDirectory(cache.folder);
+                engine->loadSamplesFromFolder(engineLibrary.folder);
+                expect(TestAudioFiles::waitFor([&] { return engine->getLoadStage() == LoadStage::Complete; }));
+                return engine;
+            };
+
+            const auto indexFile = LibraryIndexCache(engineLibrary.folder, cache.folder.getChildFile("IndexCache")).getIndexFile();
+            {
+                const auto engine = load();
+                expect(engine->noteHasOwnSamples(60) && !engine->noteHasOwnSamples(64));
+
+                LibraryIndexCache index(engineLibrary.folder, cache.folder.getChildFile("IndexCache"));
+                expect(index.load());
+                expect(index.getEntries().size() == 3);
+                expect(index.find(e4) != nullptr && !index.find(e4)->isSample);
+            }
+
+            // Nothing changed: the index is current and isn't rewritten
+            expect(indexFile.setLastModificationTime(juce::Time(juce::Time::currentTimeMillis() - 60000)));
+            const auto backdated = indexFile.getLastModificationTime().toMilliseconds();
+            load();
+            expect(indexFile.getLastModificationTime().toMilliseconds() == backdated);
+
+            // Once the file changes it is scanned again
+            TestAudioFiles::writeRampWav(e4, 2000);
+            e4.setLastModificationTime(juce::Time(e4.getLastModificationTime().toMilliseconds() + 2000));
+            expect(load()->noteHasOwnSamples(64));
+            expect(indexFile.getLastModificationTime().toMilliseconds() != backdated);
+        }
+    }
+};
+
+static LibraryIndexCacheTests libraryIndexCacheTests;
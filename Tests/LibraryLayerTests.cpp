@@ -0,0 +1,126 @@
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "../Source/SamplerEngine.h"
+#include "TestAudioFiles.h"
+
+//==============================================================================
+// Library Layer Tests
+//==============================================================================
+class LibraryLayerTests : public juce::UnitTest
+{
+public:
+    LibraryLayerTests() : juce::UnitTest("Library Layers") {}
+
+    void runTest() override
+    {
+        // Two small libraries over the same notes: C4 and D4, two velocity layers each
+        TestAudioFiles::TempFolder piano("HammerSamplerLayerPiano");
+        TestAudioFiles::TempFolder strings("HammerSamplerLayerStrings");
+        TestAudioFiles::TempFolder cache("HammerSamplerLayerCache");
+        for (auto* folder : { &piano.folder, &strings.folder })
+            for (auto note : { "C4", "D4" })
+                for (auto velocity : { "064", "127" })
+                    TestAudioFiles::writeRampWav(folder->getChildFile(juce::String(note) + "_" + velocity + "_01.wav"), 2000);
+
+        constexpr int64_t preloadBytes = 2000 * 2 * 4;
+
+        beginTest("Layers load together and start one voice each");
+        {
+            SamplerEngine::LibraryLayer stringsLayer{ strings.folder, {} };
+            stringsLayer.settings.lowNote = 60;
+            stringsLayer.settings.highNote = 61;
+            stringsLayer.settings.lowVelocity = 100;
+
+            SamplerEngine engine;
+            engine.setCacheDirectory(cache.folder);
+            engine.prepareToPlay(44100.0, 512);
+            engine.loadLibraryLayers({ { piano.folder, {} }, stringsLayer });
+            expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete; }));
+            expect(engine.getPreloadMemoryBytes() == 8 * preloadBytes);
+            expect(engine.getLoadedFolderPath() == piano.folder.getFullPathName());
+
+            auto voicesStartedBy = [&](int note, int velocity)
+            {
+                const int before = engine.getActiveVoiceCount();
+                SamplerEngine::AudioBlockScope audioBlock(engine);
+                engine.noteOn(note, velocity, 1);
+                return engine.getActiveVoiceCount() - before;
+            };
+
+            expect(voicesStartedBy(60, 127) == 2);  // Both layers
+            expect(voicesStartedBy(62, 127) == 1);  // Above the strings' key range
+            expect(voicesStartedBy(61, 64) == 1);   // Below the strings' velocity range
+        }
+
+        beginTest("Layer gain scales its voices");
+        {
+            auto firstBlockLevel = [&](float gain)
+            {
+                SamplerEngine::LibraryLayer layer{ piano.folder, {} };
+                layer.settings.gain = gain;
+
+                SamplerEngine engine;
+                engine.setCacheDirectory(cache.folder);
+                engine.prepareToPlay(44100.0, 512);
+                engine.loadLibraryLayers({ layer });
+                expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete; }));
+
+                juce::AudioBuffer<float> buffer(2, 512);
+                buffer.clear();
+                SamplerEngine::AudioBlockScope audioBlock(engine);
+                engine.noteOn(60, 127, 1);
+                engine.processBlock(buffer);
+                return buffer.getMagnitude(0, 512);
+            };
+
+            const float full = firstBlockLevel(1.0f);
+            const float half = firstBlockLevel(0.5f);
+            expect(full > 0.0f);
+            expectWithinAbsoluteError(half, full * 0.5f, full * 0.01f);
+        }
+
+        beginTest("Layer limits preload only what the layer plays");
+        {
+            SamplerEngine::LibraryLayer stringsLayer{ strings.folder, {} };
+            stringsLayer.settings.velocityLayerLimit = 1;
+
+            SamplerEngine engine;
+            engine.setCacheDirectory(cache.folder);
+            engine.loadLibraryLayers({ { piano.folder, {} }, stringsLayer });
+            expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete; }));
+            expect(engine.getPreloadMemoryBytes() == 6 * preloadBytes);
+
+            // Lifting the layer's limit loads the rest in the background
+            stringsLayer.settings.velocityLayerLimit = 0;
+            engine.setLayerSettings(1, stringsLayer.settings);
+            expect(TestAudioFiles::waitFor([&] { return engine.getPreloadMemoryBytes() == 8 * preloadBytes; }));
+            expect(engine.getLibraryLayers()[1].settings.velocityLayerLimit == 0);
+        }
+
+        beginTest("Layer settings are kept within range");
+        {
+            SamplerEngine::LibraryLayer layer{ piano.folder, {} };
+            layer.settings.lowNote = 90;
+            layer.settings.highNote = 200;
+            layer.settings.lowVelocity = 0;
+            layer.settings.highVelocity = -5;
+            layer.settings.gain = -1.0f;
+
+            SamplerEngine engine;
+            engine.setCacheDirectory(cache.folder);
+            engine.loadLibraryLayers({ layer });
+
+            const auto settings = engine.getLibraryLayers().front().settings;
+            expect(settings.lowNote == 90 && settings.highNote == 127);
+            expect(settings.lowVelocity == 1 && settings.highVelocity == 1);
+            expect(settings.gain == 0.0f);
+
+            // A missing folder loads nothing
+            engine.loadLibraryLayers({ layer, { piano.folder.getChildFile("Missing"), {} } });
+            expect(engine.getLibraryLayers().size() == 1);
+            expect(TestAudioFiles::waitFor([&] { return engine.isLoaded(); }));
+        }
+    }
+};
+
+static LibraryLayerTests libraryLayerTests;
@@ -0,0 +1,81 @@
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "../Source/LibraryScanner.h"
+#include "../Source/SamplerEngine.h"
+#include "TestAudioFiles.h"
+
+//==============================================================================
+// Library Scanner Tests
+//==============================================================================
+class LibraryScannerTests : public juce::UnitTest
+{
+public:
+    LibraryScannerTests() : juce::UnitTest("Library Scanner") {}
+
+    void runTest() override
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        TestAudioFiles::TempFolder library("HammerSamplerScannerTest");
+        const auto& folder = library.folder;
+
+        // Two notes in the root, one in a subfolder, plus files that must be skipped
+        TestAudioFiles::writeRampWav(folder.getChildFile("C4_100_01.wav"), 50000);
+        TestAudioFiles::writeRampWav(folder.getChildFile("C4_100_02.wav"), 1000);
+        TestAudioFiles::writeRampWav(folder.getChildFile("Strings/D4_064_01.wav"), 20000);
+        TestAudioFiles::writeRampWav(folder.getChildFile("not_a_sample_name.wav"), 1000);
+        folder.getChildFile("E4_100_01.wav").replaceWithText("not audio");
+
+        LibraryScanner::Options options;
+        options.parseFileName = &SamplerEngine::parseFileName;
+
+        beginTest("Recursive scan of headers in one pass");
+        {
+            auto scanned = LibraryScanner(formatManager).scan(folder, options);
+            expect(scanned.size() == 3);
+
+            if (scanned.size() == 3)
+            {
+                // Sorted by path: root files, then the subfolder
+                expect(scanned[0].midiNote == 60 && scanned[0].roundRobin == 1);
+                expect(scanned[1].midiNote == 60 && scanned[1].roundRobin == 2);
+                expect(scanned[2].midiNote == 62 && scanned[2].velocity == 64);
+
+                expect(scanned[0].info.totalSampleFrames == 50000);
+                expect(scanned[0].info.numChannels == 2);
+                expect(scanned[0].info.sampleRate == 44100.0);
+                expect(scanned[0].fileSize == folder.getChildFile("C4_100_01.wav").getSize());
+
+                // In the same open: where the audio starts, and a hash of it
+                expect(scanned[0].dataOffset == 44 && scanned[2].dataOffset == 44);
+                expect(scanned[0].contentHash != 0 && scanned[0].contentHash != scanned[1].contentHash);
+
+                // 64KB of stereo float = 8192 frames, or the whole file if shorter
+                expect(LibraryScanner::getPreloadSizeFrames(scanned[0].info, 64) == 8192);
+                expect(LibraryScanner::getPreloadSizeFrames(scanned[1].info, 64) == 1000);
+            }
+        }
+
+        beginTest("Non-recursive, single thread");
+        {
+            auto flatOptions = options;
+            flatOptions.recursive = false;
+            flatOptions.numThreads = 1;
+
+            auto scanned = LibraryScanner(formatManager).scan(folder, flatOptions);
+            expect(scanned.size() == 2);
+            for (const auto& sample : scanned)
+                expect(sample.info.totalSampleFrames > 0);
+        }
+
+        beginTest("Empty and missing folders");
+        {
+            TestAudioFiles::TempFolder empty("HammerSamplerScannerEmpty");
+            expect(LibraryScanner(formatManager).scan(empty.folder, options).empty());
+            expect(LibraryScanner(formatManager).scan(folder.getChildFile("missing"), options).empty());
+        }
+    }
+};
+
+static LibraryScannerTests libraryScannerTests;
@@ -0,0 +1,135 @@
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "../Source/MemoryLock.h"
+#include "../Source/PreloadArena.h"
+#include "../Source/SamplerEngine.h"
+#include "../Source/StreamingVoice.h"
+#include "TestAudioFiles.h"
+
+//==============================================================================
+// Memory Lock Tests
+//==============================================================================
+class MemoryLockTests : public juce::UnitTest
+{
+public:
+    MemoryLockTests() : juce::UnitTest("Memory Lock") {}
+
+    void runTest() override
+    {
+        constexpr size_t megabyte = 1024 * 1024;
+
+        beginTest("Locking and touching leave the data alone");
+        {
+            std::vector<char> data(3 * MemoryLock::pageBytes + 100);
+            for (size_t i = 0; i < data.size(); ++i)
+                data[i] = static_cast<char>(i * 7);
+
+            const bool locked = MemoryLock::lock(data.data(), data.size());
+            MemoryLock::touch(data.data(), data.size(), false);
+            MemoryLock::touch(data.data(), data.size(), true);
+            if (locked)
+                MemoryLock::unlock(data.data(), data.size());
+
+            bool intact = true;
+            for (size_t i = 0; i < data.size(); ++i)
+                intact = intact && data[i] == static_cast<char>(i * 7);
+            expect(intact);
+
+            expect(MemoryLock::lock(nullptr, 0));  // Nothing to lock always succeeds
+            expect(MemoryLock::getLockLimit() >= -1);
+        }
+
+        beginTest("Page allocations start on a page and come zeroed");
+        {
+            const size_t pageSize = MemoryLock::getPageSize();
+            expect(pageSize >= MemoryLock::pageBytes && (pageSize & (pageSize - 1)) == 0);
+
+            auto* data = static_cast<char*>(MemoryLock::allocatePages(pageSize + 100));
+            expect(data != nullptr && reinterpret_cast<uintptr_t>(data) % pageSize == 0);
+
+            bool zeroed = true;
+            for (size_t i = 0; data != nullptr && i < 2 * pageSize; ++i)  // Rounded up to whole pages
+                zeroed = zeroed && data[i] == 0;
+            expect(zeroed);
+            MemoryLock::freePages(data);
+        }
+
+        beginTest("Arena slabs are locked or pre-touched, now and as they are created");
+        {
+            PreloadArena arena;
+            auto first = arena.allocate(megabyte);
+            std::memset(first.get(), 0x33, megabyte);
+
+            // Each slab either locks or counts as a failure; its blocks keep their data
+            arena.setLockMemory(true);
+            expect(arena.getLockMemory());
+            auto stats = arena.getStats();
+            expect(stats.lockedBytes / static_cast<int64_t>(PreloadArena::slabBytes) + stats.lockFailures == 1);
+            expect(static_cast<unsigned char>(static_cast<char*>(first.get())[megabyte - 1]) == 0x33);
+
+            auto big = arena.allocate(PreloadArena::slabBytes);  // Its own slab, locked on creation
+            std::memset(big.get(), 0x44, PreloadArena::slabBytes);
+            stats = arena.getStats();
+            expect(stats.slabs == 2);
+            expect((stats.lockedBytes > 0 ? 1 : 0) + stats.lockFailures >= 1);
+            expect(stats.lockedBytes <= stats.reservedBytes);
+
+            arena.setLockMemory(false);
+            stats = arena.getStats();
+            expect(stats.lockedBytes == 0 && stats.lockFailures == 0);
+        }
+
+        beginTest("A voice locks its ring all or nothing, on pages no other voice shares");
+        {
+            StreamingVoice voice;
+            for (int channel = 0; channel < 2; ++channel)
+                expect(reinterpret_cast<uintptr_t>(voice.getWritePointer(channel)) % MemoryLock::getPageSize() == 0);
+
+            const bool locked = voice.setRingLocked(true);
+            expect(voice.setRingLocked(true) == locked);  // Already done
+            expect(!voice.setRingLocked(false));
+            expect(voice.getRingBytes() == static_cast<size_t>(2 * StreamingConstants::ringBufferFrames) * sizeof(float));
+        }
+
+        beginTest("The engine locks its preloads and rings and reports what the OS refused");
+        {
+            TestAudioFiles::TempFolder library("HammerSamplerMemoryLock");
+            TestAudioFiles::TempFolder cache("HammerSamplerMemoryLockCache");
+            for (auto note : { "C4", "D4" })
+                TestAudioFiles::writeRampWav(library.folder.getChildFile(juce::String(note) + "_127_01.wav"), 50000);
+
+            SamplerEngine engine;
+            engine.setCacheDirectory(cache.folder);
+            engine.prepareToPlay(44100.0, 512);
+            engine.setLockPreloadMemory(true);
+            engine.loadSamplesFromFolder(library.folder);
+            expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete && !engine.getPreloadProgress().inProgress; }));
+
+            // Every ring and slab is accounted for one way or the other
+            const auto status = engine.getMemoryLockStatus();
+            const auto stats = engine.getPreloadArenaStats();
+            const auto ringBytes = static_cast<int64_t>(StreamingVoice().getRingBytes());
+            expect(status.enabled);
+            expect(stats.slabs == 1);
+            const int64_t lockedRings = (status.lockedBytes - stats.lockedBytes) / ringBytes;
+            expect((status.lockedBytes - stats.lockedBytes) % ringBytes == 0);
+            expect(lockedRings + (status.failures - stats.lockFailures) == StreamingConstants::maxStreamingVoices);
+            expect(stats.lockedBytes / static_cast<int64_t>(PreloadArena::slabBytes) + stats.lockFailures == 1);
+
+            juce::AudioBuffer<float> buffer(2, 512);
+            buffer.clear();
+            {
+                SamplerEngine::AudioBlockScope audioBlock(engine);
+                engine.noteOn(60, 100, 1);
+                engine.processBlock(buffer);
+            }
+            expect(buffer.getMagnitude(0, 512) > 0.0f);
+
+            engine.setLockPreloadMemory(false);
+            const auto unlocked = engine.getMemoryLockStatus();
+            expect(!unlocked.enabled && unlocked.lockedBytes == 0 && unlocked.failures == 0);
+        }
+    }
+};
+
+static MemoryLockTests memoryLockTests;
@@ -0,0 +1,161 @@
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "../Source/MemoryPressure.h"
+#include "../Source/SamplerEngine.h"
+#include "TestAudioFiles.h"
+
+//==============================================================================
+// Memory Pressure Tests
+//==============================================================================
+class MemoryPressureTests : public juce::UnitTest
+{
+public:
+    MemoryPressureTests() : juce::UnitTest("Memory Pressure") {}
+
+    void runTest() override
+    {
+        using Level = MemoryPressure::Level;
+        constexpr int64_t mb = 1024 * 1024;
+
+        beginTest("meminfo and cgroup files parse into readings, and the tighter one wins");
+        {
+            const auto system = MemoryPressure::parseMeminfo("MemTotal:       16384000 kB\n"
+                                                             "MemFree:         1024000 kB\n"
+                                                             "MemAvailable:    4096000 kB\n"
+                                                             "Buffers:          204800 kB\n");
+            expect(system.isKnown() && !system.fromCgroup);
+            expect(system.totalBytes == int64_t(16384000) * 1024 && system.availableBytes == int64_t(4096000) * 1024);
+            expect(!MemoryPressure::parseMeminfo("MemTotal: 100 kB\n").isKnown());  // Kernels before 3.14
+
+            // v2: 2 GB limit, 1.9 GB used of which 100 MB is inactive file cache
+            const auto cgroup = MemoryPressure::parseCgroup("2147483648\n", juce::String(2048 * mb - 148 * mb) + "\n",
+                                                            "anon 1900000000\nfile 300000000\ninactive_file " + juce::String(100 * mb) + "\n");
+            expect(cgroup.isKnown() && cgroup.fromCgroup);
+            expect(cgroup.totalBytes == 2048 * mb && cgroup.availableBytes == 248 * mb);
+
+            // v1 names its counter total_inactive_file; no limit reads "max" or about 2^63
+            expect(MemoryPressure::parseCgroup("1073741824", "1073741824", "total_inactive_file 1048576").availableBytes == mb);
+            expect(!MemoryPressure::parseCgroup("max\n", "1000", "").isKnown());
+            expect(!MemoryPressure::parseCgroup("9223372036854771712", "1000", "").isKnown());
+            expect(!MemoryPressure::parseCgroup("", "", "").isKnown());
+
+            expect(MemoryPressure::tighter(system, cgroup).fromCgroup);
+            expect(!MemoryPressure::tighter(system, {}).fromCgroup && MemoryPressure::tighter({}, cgroup).fromCgroup);
+            expect(!MemoryPressure::tighter({}, {}).isKnown());
+        }
+
+        beginTest("Levels rise at their threshold and fall only once clear of it");
+        {
+            auto at = [](double fraction)
+            {
+                MemoryPressure::Reading reading;
+                reading.totalBytes = 1000000;
+                reading.availableBytes = static_cast<int64_t>(fraction * 1000000.0);
+                return reading;
+            };
+
+            expect(MemoryPressure::nextLevel(Level::normal, at(0.5)) == Level::normal);
+            expect(MemoryPressure::nextLevel(Level::normal, at(0.12)) == Level::normal);
+            expect(MemoryPressure::nextLevel(Level::normal, at(0.08)) == Level::low);
+            expect(MemoryPressure::nextLevel(Level::normal, at(0.02)) == Level::critical);
+
+            expect(MemoryPressure::nextLevel(Level::critical, at(0.08)) == Level::critical);
+            expect(MemoryPressure::nextLevel(Level::critical, at(0.12)) == Level::low);
+            expect(MemoryPressure::nextLevel(Level::low, at(0.12)) == Level::low);
+            expect(MemoryPressure::nextLevel(Level::low, at(0.2)) == Level::normal);
+
+            expect(MemoryPressure::nextLevel(Level::critical, MemoryPressure::Reading()) == Level::normal);
+        }
+
+        beginTest("The engine gives preload memory back in order under pressure, and restores it after");
+        {
+            // Two notes x two velocities x two round robins of 16-bit audio, longer than any preload
+            TestAudioFiles::TempFolder library("HammerSamplerMemoryPressure");
+            TestAudioFiles::TempFolder cache("HammerSamplerMemoryPressureCache");
+            for (const char* note : { "C4", "D4" })
+                for (const char* velocity : { "40", "127" })
+                    for (const char* roundRobin : { "01", "02" })
+                        TestAudioFiles::writeRampWav(library.folder.getChildFile(juce::String(note) + "_" + velocity + "_" + roundRobin + ".wav"), 100000);
+
+            std::atomic<double> availableFraction{0.5};
+            SamplerEngine engine;
+            engine.setCacheDirectory(cache.folder);
+            engine.setMemoryPressureSource([&availableFraction]
+            {
+                MemoryPressure::Reading reading;
+                reading.totalBytes = 16384 * mb;
+                reading.availableBytes = static_cast<int64_t>(availableFraction.load() * 16384.0) * mb;
+                return reading;
+            });
+            engine.prepareToPlay(44100.0, 512);
+            engine.loadSamplesFromFolder(library.folder);
+            expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete && !engine.getPreloadProgress().inProgress; }));
+
+            constexpr int64_t fullBytes = 8 * 64 * 1024;     // 64 KB of floats each
+            constexpr int64_t minimumBytes = 8 * 16 * 1024;  // 32 KB worth of frames, as 16-bit
+            constexpr int64_t firstStageBytes = 2 * 16 * 1024;  // One layer and round robin per note
+            expect(engine.getPreloadMemoryBytes() == fullBytes);
+            expect(engine.getMemoryPressureStep() == SamplerEngine::PressureStep::none);
+            expect(engine.getMemoryPressureLog().empty());
+
+            auto settled = [&](SamplerEngine::PressureStep step, int64_t bytes)
+            {
+                return TestAudioFiles::waitFor([&]
+                {
+                    return engine.getMemoryPressureStep() == step && !engine.getPreloadProgress().inProgress &&
+                           engine.getPreloadMemoryBytes() == bytes;
+                }, 10000);
+            };
+
+            // Low: compact, then the minimum size
+            availableFraction = 0.08;
+            expect(settled(SamplerEngine::PressureStep::minimumPreloads, minimumBytes));
+            {
+                const auto log = engine.getMemoryPressureLog();
+                expect(log.size() == 3);
+                expect(log[0].level == Level::low && log[0].step == SamplerEngine::PressureStep::none);
+                expect(log[1].step == SamplerEngine::PressureStep::compactPreloads);
+                expect(log[2].step == SamplerEngine::PressureStep::minimumPreloads);
+                expect(log[0].availableBytes == 1310 * mb && log[1].preloadBytes == fullBytes);
+            }
+
+            // Critical: first stage only, and every note still plays
+            availableFraction = 0.03;
+            expect(settled(SamplerEngine::PressureStep::firstStageOnly, firstStageBytes));
+            expect(engine.getMemoryPressureLevel() == Level::critical);
+            {
+                SamplerEngine::AudioBlockScope audioBlock(engine);
+                engine.noteOn(60, 20, 1);
+                engine.noteOn(62, 127, 1);
+            }
+            expectEquals(engine.getActiveVoiceCount(), 2);
+            {
+                SamplerEngine::AudioBlockScope audioBlock(engine);
+                engine.noteOff(60);
+                engine.noteOff(62);
+            }
+
+            // Easing into the low band restores the last step only; clearing restores the rest
+            availableFraction = 0.12;
+            expect(settled(SamplerEngine::PressureStep::minimumPreloads, minimumBytes));
+            availableFraction = 0.5;
+            expect(settled(SamplerEngine::PressureStep::none, fullBytes));
+            {
+                const auto log = engine.getMemoryPressureLog();
+                expect(log.back().level == Level::normal && log.back().step == SamplerEngine::PressureStep::none);
+                expect(log.back().message == "Restoring float preloads");
+            }
+
+            // Switching the response off restores at once
+            availableFraction = 0.03;
+            expect(TestAudioFiles::waitFor([&] { return engine.getMemoryPressureStep() != SamplerEngine::PressureStep::none; }));
+            engine.setMemoryPressureResponse(false);
+            expect(engine.getMemoryPressureStep() == SamplerEngine::PressureStep::none);
+            expect(settled(SamplerEngine::PressureStep::none, fullBytes));
+            juce::Thread::sleep(700);
+            expect(engine.getMemoryPressureStep() == SamplerEngine::PressureStep::none);
+        }
+    }
+};
+
+static MemoryPressureTests memoryPressureTests;
@@ -0,0 +1,172 @@
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "../Source/PreloadArena.h"
+#include "../Source/SamplerEngine.h"
+#include "TestAudioFiles.h"
+
+//==============================================================================
+// Preload Arena Tests
+//==============================================================================
+class PreloadArenaTests : public juce::UnitTest
+{
+public:
+    PreloadArenaTests() : juce::UnitTest("Preload Arena") {}
+
+    void runTest() override
+    {
+        constexpr size_t megabyte = 1024 * 1024;
+
+        beginTest("Blocks are aligned, packed and counted");
+        {
+            PreloadArena arena;
+            auto a = arena.allocate(1000);
+            auto b = arena.allocate(5000);
+            expect(a != nullptr && b != nullptr);
+            expect(reinterpret_cast<uintptr_t>(a.get()) % PreloadArena::alignment == 0);
+            expect(reinterpret_cast<uintptr_t>(b.get()) % PreloadArena::alignment == 0);
+            expect(static_cast<char*>(b.get()) == static_cast<char*>(a.get()) + PreloadArena::roundUp(1000));  // Next to each other
+
+            std::memset(b.get(), 0x5a, 5000);  // Writable
+
+            auto stats = arena.getStats();
+            expect(stats.slabs == 1 && stats.blocks == 2);
+            expect(stats.reservedBytes == static_cast<int64_t>(PreloadArena::slabBytes));
+            expect(stats.usedBytes == static_cast<int64_t>(PreloadArena::roundUp(1000) + PreloadArena::roundUp(5000)));
+            expect(stats.freeBytes == stats.reservedBytes - stats.usedBytes);
+            expect(stats.fragmentation == 0.0f);
+        }
+
+        beginTest("Freed ranges merge and empty slabs are released");
+        {
+            PreloadArena arena;
+            auto a = arena.allocate(megabyte);
+            auto b = arena.allocate(megabyte);
+            auto c = arena.allocate(megabyte);
+            auto* first = a.get();
+
+            // A hole in the middle: the free space is in two pieces
+            b.reset();
+            expect(arena.getStats().fragmentation > 0.0f);
+
+            // The hole is reused first
+            auto d = arena.allocate(megabyte);
+            expect(static_cast<char*>(d.get()) == static_cast<char*>(first) + megabyte);
+
+            // Merging both neighbours leaves one free range
+            d.reset();
+            a.reset();
+            auto stats = arena.getStats();
+            expect(stats.blocks == 1);
+            auto e = arena.allocate(2 * megabyte);
+            expect(e.get() == first);
+
+            c.reset();
+            e.reset();
+            expect(arena.getStats().slabs == 0);
+            expect(arena.getStats().reservedBytes == 0);
+        }
+
+        beginTest("Large blocks get their own slab, and blocks outlive the arena");
+        {
+            std::shared_ptr<void> survivor;
+            {
+                PreloadArena arena;
+                auto big = arena.allocate(PreloadArena::slabBytes + 1);
+                auto stats = arena.getStats();
+                expect(stats.slabs == 1);
+                expect(stats.reservedBytes == static_cast<int64_t>(PreloadArena::slabBytes + PreloadArena::hugePageBytes));
+
+                survivor = arena.allocate(64);
+                expect(arena.getStats().slabs == 1);  // Fits after the big block
+            }
+            std::memset(survivor.get(), 0, 64);
+            survivor.reset();
+        }
+
+        beginTest("Compaction marks sparse slabs only when the rest has room");
+        {
+            PreloadArena arena;
+            constexpr int blocksPerSlab = static_cast<int>(PreloadArena::slabBytes / megabyte);
+
+            std::vector<std::shared_ptr<void>> blocks;
+            for (int i = 0; i < blocksPerSlab + 4; ++i)
+                blocks.push_back(arena.allocate(megabyte));
+            expect(arena.getStats().slabs == 2);
+
+            // The second slab is a quarter full, but the first has no room for it
+            expect(arena.beginCompaction() == 0);
+
+            // Emptying most of the first slab makes room
+            for (int i = 0; i < 10; ++i)
+                blocks[static_cast<size_t>(i)].reset();
+            expect(arena.beginCompaction() == 1);
+            expect(arena.isEvacuating(blocks.back().get()));
+            expect(!arena.isEvacuating(blocks[10].get()));
+
+            // New blocks stay out of the marked slab
+            auto moved = arena.allocate(megabyte);
+            expect(!arena.isEvacuating(moved.get()));
+            expect(arena.getStats().slabs == 2);
+        }
+
+        beginTest("Huge pages are a request, not a requirement");
+        {
+            for (auto mode : { PreloadArena::HugePages::transparent, PreloadArena::HugePages::reserved })
+            {
+                PreloadArena arena;
+                arena.setHugePages(mode);
+                expect(arena.getHugePages() == mode);
+                auto block = arena.allocate(megabyte);
+                expect(block != nullptr);
+                expect(reinterpret_cast<uintptr_t>(block.get()) % PreloadArena::alignment == 0);
+                std::memset(block.get(), 1, megabyte);
+
+                // Without a reserved pool, reserved falls back to transparent huge pages
+                const auto stats = arena.getStats();
+                expect(stats.hugePageSlabs <= 1 && stats.reservedHugePageSlabs <= stats.hugePageSlabs);
+                if (mode == PreloadArena::HugePages::transparent)
+                    expect(stats.reservedHugePageSlabs == 0);
+            }
+        }
+
+        beginTest("The engine's preloads live in the arena and compact after a limit change");
+        {
+            // Twenty 1 MB preloads: sixteen fill the first slab, four spill into a second
+            TestAudioFiles::TempFolder library("HammerSamplerPreloadArena");
+            TestAudioFiles::TempFolder cache("HammerSamplerPreloadArenaCache");
+            for (auto note : { "C4", "C#4", "D4", "D#4", "E4", "F4", "F#4", "G4", "G#4", "A4" })
+                for (auto velocity : { "064", "127" })
+                    TestAudioFiles::writeRampWav(library.folder.getChildFile(juce::String(note) + "_" + velocity + "_01.wav"), 140000);
+
+            SamplerEngine engine;
+            engine.setCacheDirectory(cache.folder);
+            engine.prepareToPlay(44100.0, 512);
+            engine.setPreloadSizeKB(1024);
+            engine.loadSamplesFromFolder(library.folder);
+            expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete && !engine.getPreloadProgress().inProgress; }));
+
+            auto stats = engine.getPreloadArenaStats();
+            expect(stats.blocks == 20);
+            expect(stats.slabs == 2);
+            expect(stats.usedBytes == engine.getPreloadMemoryBytes());
+
+            // Stage 1 loaded the upper layer into the first slab; dropping it leaves both slabs
+            // sparse, and the lower layer's spilled preloads move into the first one
+            engine.setVelocityLayerLimit(1);
+            expect(TestAudioFiles::waitFor([&] { return engine.getPreloadArenaStats().slabs == 1; }));
+            stats = engine.getPreloadArenaStats();
+            expect(stats.blocks == 10);
+            expect(stats.usedBytes == engine.getPreloadMemoryBytes());
+
+            // Still playable
+            juce::AudioBuffer<float> buffer(2, 512);
+            buffer.clear();
+            SamplerEngine::AudioBlockScope audioBlock(engine);
+            engine.noteOn(69, 100, 1);
+            engine.processBlock(buffer);
+            expect(buffer.getMagnitude(0, 512) > 0.0f);
+        }
+    }
+};
+
+static PreloadArenaTests preloadArenaTests;
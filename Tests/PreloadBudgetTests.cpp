@@ -0,0 +1,123 @@
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "../Source/PreloadBudget.h"
+#include "../Source/SamplerEngine.h"
+#include "TestAudioFiles.h"
+
+//==============================================================================
+// Preload Budget Tests
+//==============================================================================
+class PreloadBudgetTests : public juce::UnitTest
+{
+public:
+    PreloadBudgetTests() : juce::UnitTest("Preload Budget") {}
+
+    void runTest() override
+    {
+        auto request = [](int minFrames, int maxFrames, double weight)
+        {
+            PreloadBudget::Request r;
+            r.minFrames = minFrames;
+            r.maxFrames = maxFrames;
+            r.bytesPerFrame = 8;  // Stereo float
+            r.weight = weight;
+            return r;
+        };
+
+        beginTest("A budget that covers everything gives every sample its cap");
+        {
+            auto result = PreloadBudget::allocate({ request(1000, 5000, 1.0), request(1000, 3000, 2.0) }, 1 << 20);
+            expect(result.floorsFit);
+            expect(result.frames[0] == 5000 && result.frames[1] == 3000);
+            expect(result.allocatedBytes == 8 * 8000);
+        }
+
+        beginTest("What is left after the floors goes out by weight");
+        {
+            // 8000 bytes of floors, 32000 to share 1:3
+            auto result = PreloadBudget::allocate({ request(500, 100000, 1.0), request(500, 100000, 3.0) }, 40000);
+            expect(result.frames[0] == 500 + 1000);
+            expect(result.frames[1] == 500 + 3000);
+            expect(result.allocatedBytes <= 40000);
+        }
+
+        beginTest("Capped samples pass their share on");
+        {
+            // The short sample can take only 100 more frames; the rest goes to the others
+            auto result = PreloadBudget::allocate({ request(500, 600, 1.0), request(500, 100000, 1.0), request(500, 100000, 1.0) }, 48000);
+            expect(result.frames[0] == 600);
+            expect(result.frames[1] == result.frames[2]);
+            expect(result.allocatedBytes <= 48000);
+            expect(result.allocatedBytes > 48000 - 3 * 8);  // Only rounding is left over
+        }
+
+        beginTest("Floors shrink together when they don't fit");
+        {
+            auto result = PreloadBudget::allocate({ request(1000, 2000, 1.0), request(3000, 4000, 1.0) }, 16000);
+            expect(!result.floorsFit);
+            expect(result.frames[0] == 500 && result.frames[1] == 1500);
+            expect(result.allocatedBytes <= 16000);
+
+            auto empty = PreloadBudget::allocate({ request(1000, 2000, 1.0) }, 0);
+            expect(empty.frames[0] == 0 && empty.allocatedBytes == 0);
+        }
+
+        beginTest("Plays, playback rate, channels and underruns raise the weight");
+        {
+            const double base = PreloadBudget::weightFor(8, 1.0, 0, 0);
+            expect(PreloadBudget::weightFor(8, 1.0, 10, 0) > base);
+            expect(PreloadBudget::weightFor(8, 2.0, 0, 0) == 2.0 * base);
+            expect(PreloadBudget::weightFor(4, 1.0, 0, 0) == 0.5 * base);
+            expect(PreloadBudget::weightFor(8, 1.0, 0, 2) > base);
+            expect(PreloadBudget::weightFor(8, 1.0, 0, 100) == PreloadBudget::weightFor(8, 1.0, 0, 8));  // Capped
+            expect(PreloadBudget::weightFor(8, 1.0, 1000, 0) < 20.0 * base);  // Plays count less and less
+        }
+
+        beginTest("The engine keeps preloads within the budget and rebalances as notes play");
+        {
+            // Four long stereo samples: 1 MB can't give each of them the 1024 KB cap
+            TestAudioFiles::TempFolder library("HammerSamplerPreloadBudget");
+            TestAudioFiles::TempFolder cache("HammerSamplerPreloadBudgetCache");
+            for (auto note : { "C4", "D4", "E4", "F4" })
+                TestAudioFiles::writeRampWav(library.folder.getChildFile(juce::String(note) + "_127_01.wav"), 200000);
+
+            constexpr int64_t budgetBytes = 1024 * 1024;
+
+            SamplerEngine engine;
+            engine.setCacheDirectory(cache.folder);
+            engine.prepareToPlay(44100.0, 512);
+            engine.setPreloadBudgetMB(1);
+            engine.loadSamplesFromFolder(library.folder);
+            expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete && !engine.getPreloadProgress().inProgress; }));
+
+            auto allocation = engine.getPreloadAllocation();
+            expect(allocation.budgetBytes == budgetBytes);
+            expect(allocation.samples == 4);
+            expect(allocation.floorsFit);
+            expect(allocation.allocatedBytes <= budgetBytes);
+            expect(allocation.smallestKB == allocation.largestKB);  // Nothing played yet: equal shares
+            expect(engine.getPreloadMemoryBytes() == allocation.allocatedBytes);
+
+            // C4 gets played: the next rebalance gives it a larger share
+            juce::AudioBuffer<float> buffer(2, 512);
+            for (int i = 0; i < 10; ++i)
+            {
+                SamplerEngine::AudioBlockScope audioBlock(engine);
+                engine.noteOn(60, 127, 1);
+                engine.processBlock(buffer);
+            }
+
+            expect(TestAudioFiles::waitFor([&] { return engine.getPreloadAllocation().largestKB > engine.getPreloadAllocation().smallestKB; }));
+            expect(TestAudioFiles::waitFor([&] { return !engine.getPreloadProgress().inProgress
+                                     && engine.getPreloadMemoryBytes() == engine.getPreloadAllocation().allocatedBytes; }));
+            expect(engine.getPreloadMemoryBytes() <= budgetBytes);
+
+            // Off again: back to preloadSizeKB for every sample
+            engine.setPreloadBudgetMB(0);
+            expect(TestAudioFiles::waitFor([&] { return engine.getPreloadMemoryBytes() == 4 * 64 * 1024; }));
+            expect(engine.getPreloadAllocation().budgetBytes == 0);
+        }
+    }
+};
+
+static PreloadBudgetTests preloadBudgetTests;
@@ -0,0 +1,131 @@
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "../Source/PreloadProfile.h"
+#include "../Source/SamplerEngine.h"
+#include "../Source/StreamingVoice.h"
+#include "TestAudioFiles.h"
+
+//==============================================================================
+// Preload Profile Tests
+//==============================================================================
+class PreloadProfileTests : public juce::UnitTest
+{
+public:
+    PreloadProfileTests() : juce::UnitTest("Preload Profile") {}
+
+    void runTest() override
+    {
+        beginTest("Underruns and late refills grow the scale, early refills shrink it");
+        {
+            expect(PreloadProfile::nextScale(1.0f, true, -1.0f) == 2.0f);
+            expect(PreloadProfile::nextScale(1.0f, false, 0.9f) == 1.25f);
+            expect(PreloadProfile::nextScale(1.0f, false, 0.1f) < 1.0f);
+            expect(PreloadProfile::nextScale(1.0f, false, 0.5f) == 1.0f);   // Comfortable: kept
+            expect(PreloadProfile::nextScale(1.0f, false, -1.0f) == 1.0f);  // Nothing streamed: kept
+            expect(PreloadProfile::nextScale(PreloadProfile::maxScale, true, 1.0f) == PreloadProfile::maxScale);
+            expect(PreloadProfile::nextScale(PreloadProfile::minScale, false, 0.0f) == PreloadProfile::minScale);
+        }
+
+        beginTest("A voice measures how much preload it used before the first refill, and its own underruns");
+        {
+            PreloadedSample sample;
+            sample.path = SamplePath::intern(juce::String("ramp.wav"));
+            sample.totalSampleFrames = 100000;
+            sample.preloadBuffer.setSize(2, 8192);
+            sample.preloadBuffer.clear();
+            sample.preloadSizeFrames = 8192;
+
+            StreamingVoice voice;
+            voice.prepareToPlay(44100.0, 512);
+            voice.setADSRParameters({ 0.0f, 0.0f, 1.0f, 0.1f }, 1);
+            juce::AudioBuffer<float> buffer(2, 512);
+
+            voice.startVoice(&sample, sample.rootNote, 1.0f, 44100.0);
+            voice.renderNextBlock(buffer, 0, 512);
+            voice.renderNextBlock(buffer, 0, 512);
+            expect(voice.takeRefillLag() < 0.0f);  // Still waiting for the disk
+
+            // The refill lands with 1024 of 8192 frames played
+            voice.advanceWritePosition(4096);
+            voice.renderNextBlock(buffer, 0, 512);
+            expectWithinAbsoluteError(voice.takeRefillLag(), 0.125f, 0.001f);
+            expect(voice.takeRefillLag() < 0.0f);  // Once per play
+            expect(!voice.takeUnderran());
+
+            // No refill at all: the preload runs out
+            voice.startVoice(&sample, sample.rootNote, 1.0f, 44100.0);
+            for (int block = 0; block < 17 && voice.isActive(); ++block)
+                voice.renderNextBlock(buffer, 0, 512);
+            expect(voice.takeRefillLag() == 1.0f);
+
+            // The underrun is recorded on the voice itself, once
+            expect(voice.takeUnderran());
+            expect(!voice.takeUnderran());
+        }
+
+        TestAudioFiles::TempFolder library("HammerSamplerPreloadProfile");
+        TestAudioFiles::TempFolder profileFolder("HammerSamplerPreloadProfileCache");
+        for (auto note : { "C4", "D4", "E4", "F4" })
+            TestAudioFiles::writeRampWav(library.folder.getChildFile(juce::String(note) + "_127_01.wav"), 200000);
+        const auto c4 = library.folder.getChildFile("C4_127_01.wav");
+
+        beginTest("Profile round trip");
+        {
+            PreloadProfile profile(library.folder, profileFolder.folder);
+            profile.setScale(c4, 3.0f);
+            profile.setScale(library.folder.getChildFile("D4_127_01.wav"), 100.0f);
+            profile.setScale(library.folder.getChildFile("E4_127_01.wav"), 1.0f);
+            expect(profile.getScales().size() == 2);  // Scale 1 isn't stored
+            expect(profile.save());
+
+            PreloadProfile reloaded(library.folder, profileFolder.folder);
+            expect(reloaded.load());
+            expect(reloaded.getScale(c4) == 3.0f);
+            expect(reloaded.getScale(library.folder.getChildFile("D4_127_01.wav")) == PreloadProfile::maxScale);
+            expect(reloaded.getScale(library.folder.getChildFile("F4_127_01.wav")) == 1.0f);
+
+            // Another folder's profile, or a damaged one, isn't used
+            expect(!PreloadProfile(library.folder.getChildFile("Other"), profileFolder.folder).load());
+            juce::MemoryBlock data;
+            reloaded.getProfileFile().loadFileAsData(data);
+            reloaded.getProfileFile().replaceWithData(data.getData(), data.getSize() - 3);
+            expect(!PreloadProfile(library.folder, profileFolder.folder).load());
+
+            // Nothing learned: no file
+            PreloadProfile empty(library.folder, profileFolder.folder);
+            expect(empty.save());
+            expect(!empty.getProfileFile().existsAsFile());
+        }
+
+        beginTest("The engine sizes preloads from a library's profile within the knob's RAM");
+        {
+            // Four long stereo samples at 64 KB; C4 learned it needs four times that
+            TestAudioFiles::TempFolder cache("HammerSamplerPreloadProfileEngine");
+            PreloadProfile profile(library.folder, cache.folder.getChildFile("PreloadProfiles"));
+            profile.setScale(c4, 4.0f);
+            expect(profile.save());
+
+            constexpr int64_t knobBytes = 4 * 64 * 1024;
+
+            SamplerEngine engine;
+            engine.setCacheDirectory(cache.folder);
+            engine.prepareToPlay(44100.0, 512);
+            engine.setAdaptivePreloadSizing(true);
+            engine.loadSamplesFromFolder(library.folder);
+            expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete && !engine.getPreloadProgress().inProgress; }));
+
+            auto allocation = engine.getPreloadAllocation();
+            expect(allocation.budgetBytes == 0);
+            expect(allocation.samples == 4);
+            expect(allocation.allocatedBytes <= knobBytes);
+            expect(allocation.largestKB > 64 && allocation.smallestKB < 64);
+            expect(engine.getPreloadMemoryBytes() == allocation.allocatedBytes);
+
+            // Off again: back to the knob's size for every sample
+            engine.setAdaptivePreloadSizing(false);
+            expect(TestAudioFiles::waitFor([&] { return engine.getPreloadMemoryBytes() == knobBytes; }));
+        }
+    }
+};
+
+static PreloadProfileTests preloadProfileTests;
@@ -0,0 +1,107 @@
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "../Source/LibraryScanner.h"
+#include "../Source/SamplerEngine.h"
+#include "TestAudioFiles.h"
+
+//==============================================================================
+// Preload Sharing Tests
+//==============================================================================
+class PreloadSharingTests : public juce::UnitTest
+{
+public:
+    PreloadSharingTests() : juce::UnitTest("Preload Sharing") {}
+
+    void runTest() override
+    {
+        // C4 and D4 are the same recording under two names; E4 starts the same but differs
+        // within the preload, and F4 is a different sound altogether
+        TestAudioFiles::TempFolder library("HammerSamplerPreloadSharing");
+        constexpr int numFrames = 50000;
+        TestAudioFiles::writeWav(library.folder.getChildFile("C4_127_01.wav"), 2, numFrames, 44100, TestAudioFiles::rampValue);
+        TestAudioFiles::writeWav(library.folder.getChildFile("D4_127_01.wav"), 2, numFrames, 44100, TestAudioFiles::rampValue);
+        TestAudioFiles::writeWav(library.folder.getChildFile("E4_127_01.wav"), 2, numFrames, 44100, [](int channel, int frame)
+        {
+            return frame == 3000 ? 0.0f : TestAudioFiles::rampValue(channel, frame);
+        });
+        TestAudioFiles::writeWav(library.folder.getChildFile("F4_127_01.wav"), 2, numFrames, 44100, [](int, int frame)
+        {
+            return static_cast<float>(frame % 100) / 200.0f;
+        });
+
+        beginTest("The scan hashes each file's audio, not its name");
+        {
+            juce::AudioFormatManager formatManager;
+            formatManager.registerBasicFormats();
+            LibraryScanner::Options options;
+            options.parseFileName = &SamplerEngine::parseFileName;
+            const auto scanned = LibraryScanner(formatManager).scan(library.folder, options);
+            expect(scanned.size() == 4);
+
+            for (const auto& sample : scanned)
+                expect(sample.contentHash != 0);
+            expect(scanned[0].contentHash == scanned[1].contentHash);
+            expect(scanned[0].contentHash == scanned[2].contentHash);  // Only the start is hashed
+            expect(scanned[0].contentHash != scanned[3].contentHash);
+        }
+
+        beginTest("Identical samples share one preload, and the engine reports the RAM saved");
+        {
+            TestAudioFiles::TempFolder cache("HammerSamplerPreloadSharingCache");
+            const auto snapshotFolder = cache.folder.getChildFile("PreloadSnapshots");
+
+            constexpr int64_t preloadBytes = 64 * 1024;  // The default preload size, all shorter than the files
+
+            auto playNote = [](SamplerEngine& engine, int note)
+            {
+                juce::AudioBuffer<float> buffer(2, 512);
+                buffer.clear();
+                SamplerEngine::AudioBlockScope audioBlock(engine);
+                engine.noteOn(note, 100, 1);
+                engine.processBlock(buffer);
+
+                engine.noteOff(note);
+                juce::AudioBuffer<float> tail(2, 512);
+                for (int block = 0; block < 1000 && engine.getActiveVoiceCount() > 0; ++block)
+                    engine.processBlock(tail);
+                return buffer;
+            };
+
+            auto checkEngine = [&](SamplerEngine& engine)
+            {
+                expect(TestAudioFiles::waitFor([&] { return engine.getPreloadSharing().sharedSamples == 1; }));
+                expect(engine.getPreloadSharing().savedBytes == preloadBytes);
+                expect(engine.getPreloadMemoryBytes() == 3 * preloadBytes);
+
+                // Each note plays at its own root, so the shared pair sounds the same
+                const auto c4 = playNote(engine, 60);
+                const auto d4 = playNote(engine, 62);
+                expect(c4.getMagnitude(0, 512) > 0.0f);
+                for (int channel = 0; channel < 2; ++channel)
+                    expect(std::memcmp(c4.getReadPointer(channel), d4.getReadPointer(channel), 512 * sizeof(float)) == 0);
+            };
+
+            {
+                SamplerEngine engine;
+                engine.setCacheDirectory(cache.folder);
+                engine.prepareToPlay(44100.0, 512);
+                engine.loadSamplesFromFolder(library.folder);
+                expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete && !engine.getPreloadProgress().inProgress; }));
+                checkEngine(engine);
+                expect(TestAudioFiles::waitFor([&] { return snapshotFolder.findChildFiles(juce::File::findFiles, false, "*.snap").size() == 1; }));
+            }
+
+            // Reopened: hashes from the index cache, preloads mapped from the snapshot
+            {
+                SamplerEngine engine;
+                engine.setCacheDirectory(cache.folder);
+                engine.prepareToPlay(44100.0, 512);
+                engine.loadSamplesFromFolder(library.folder);
+                expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete && !engine.getPreloadProgress().inProgress; }));
+                checkEngine(engine);
+            }
+        }
+    }
+};
+
+static PreloadSharingTests preloadSharingTests;
@@ -0,0 +1,200 @@
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "../Source/PreloadSnapshot.h"
+#include "../Source/LibraryScanner.h"
+#include "../Source/SamplerEngine.h"
+#include "TestAudioFiles.h"
+
+//==============================================================================
+// Preload Snapshot Tests
+//==============================================================================
+class PreloadSnapshotTests : public juce::UnitTest
+{
+public:
+    PreloadSnapshotTests() : juce::UnitTest("Preload Snapshot") {}
+
+    void runTest() override
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        TestAudioFiles::TempFolder library("HammerSamplerSnapshotLibrary");
+        TestAudioFiles::TempFolder snapshotFolder("HammerSamplerSnapshots");
+        const auto& folder = library.folder;
+
+        const auto c4 = folder.getChildFile("C4_100_01.wav");
+        const auto d4 = folder.getChildFile("Strings/D4_064_02.wav");
+        TestAudioFiles::writeRampWav(c4, 50000);
+        TestAudioFiles::writeRampWav(d4, 1001);  // Shorter than the preload: kept whole
+
+        PreloadSnapshot::Config config;
+        config.preloadSizeKB = 64;
+        config.velocityLayerLimit = 2;
+        config.roundRobinLimit = 2;
+
+        LibraryScanner::Options options;
+        options.parseFileName = &SamplerEngine::parseFileName;
+
+        auto scanned = LibraryScanner(formatManager).scan(folder, options);
+        expect(scanned.size() == 2);
+
+        // Decoded preloads, in scan order
+        std::vector<std::unique_ptr<PreloadedSample>> decodedPreloads;
+        std::vector<const PreloadedSample*> preloads;
+        for (const auto& sample : scanned)
+        {
+            decodedPreloads.push_back(TestAudioFiles::decodePreload(sample.info, config.preloadSizeKB));
+            preloads.push_back(decodedPreloads.back().get());
+        }
+
+        beginTest("Mapped preloads match decoded ones");
+        {
+            PreloadSnapshot writer(folder, config, snapshotFolder.folder);
+            expect(!writer.open());  // Nothing written yet
+            expect(writer.write(preloads));
+            expect(writer.getSnapshotFile().existsAsFile());
+
+            PreloadSnapshot snapshot(folder, config, snapshotFolder.folder);
+            expect(snapshot.open());
+            expect(snapshot.getNumEntries() == 2);
+
+            for (size_t i = 0; i < scanned.size(); ++i)
+            {
+                const auto& sample = scanned[i];
+                auto mapped = snapshot.createPreload(sample.info);
+                expect(mapped != nullptr);
+                if (mapped == nullptr)
+                    continue;
+
+                const auto& decoded = decodedPreloads[i]->preloadBuffer;
+                expect(mapped->dataOwner != nullptr);
+                expect(mapped->preloadSizeFrames == decodedPreloads[i]->preloadSizeFrames);
+                expect(mapped->preloadBuffer.getNumChannels() == decoded.getNumChannels());
+                expect(mapped->preloadBuffer.getNumSamples() == decoded.getNumSamples());
+                expect(mapped->path == sample.info.path && mapped->rootNote == sample.info.rootNote);
+
+                for (int channel = 0; channel < decoded.getNumChannels(); ++channel)
+                {
+                    const float* data = mapped->preloadBuffer.getReadPointer(channel);
+                    expect(reinterpret_cast<uintptr_t>(data) % PreloadSnapshot::dataAlignment == 0);
+                    expect(std::memcmp(data, decoded.getReadPointer(channel),
+                                       sizeof(float) * static_cast<size_t>(decoded.getNumSamples())) == 0);
+                }
+            }
+        }
+
+        beginTest("Preloads keep the mapping alive");
+        {
+            std::unique_ptr<PreloadedSample> mapped;
+            {
+                PreloadSnapshot snapshot(folder, config, snapshotFolder.folder);
+                expect(snapshot.open());
+                mapped = snapshot.createPreload(scanned[0].info);
+            }
+
+            // Rewriting the file on disk doesn't disturb a mapping in use
+            expect(PreloadSnapshot(folder, config, snapshotFolder.folder).write(preloads));
+
+            expect(mapped != nullptr);
+            if (mapped != nullptr)
+                expect(mapped->preloadBuffer.getSample(0, 100) == decodedPreloads[0]->preloadBuffer.getSample(0, 100));
+        }
+
+        beginTest("Other configurations and changed files are not used");
+        {
+            auto larger = config;
+            larger.preloadSizeKB = 128;
+            expect(!PreloadSnapshot(folder, larger, snapshotFolder.folder).open());
+
+            auto fewerLayers = config;
+            fewerLayers.velocityLayerLimit = 1;
+            expect(!PreloadSnapshot(folder, fewerLayers, snapshotFolder.folder).open());
+            expect(!PreloadSnapshot(folder.getChildFile("Strings"), config, snapshotFolder.folder).open());
+
+            PreloadSnapshot snapshot(folder, config, snapshotFolder.folder);
+            expect(snapshot.open());
+
+            // A file the snapshot doesn't hold
+            auto stranger = scanned[0].info;
+            stranger.path = SamplePath::intern(folder.getChildFile("E4_100_01.wav"));
+            expect(snapshot.createPreload(stranger) == nullptr);
+
+            // Same name, new contents
+            TestAudioFiles::writeRampWav(d4, 900);
+            d4.setLastModificationTime(juce::Time(d4.getLastModificationTime().toMilliseconds() + 2000));
+            expect(snapshot.createPreload(scanned[1].info) == nullptr);
+            expect(snapshot.createPreload(scanned[0].info) != nullptr);
+        }
+
+        beginTest("One snapshot per library");
+        {
+            auto smaller = config;
+            smaller.preloadSizeKB = 32;
+            PreloadSnapshot other(folder, smaller, snapshotFolder.folder);
+            expect(other.write(preloads));
+
+            expect(other.getSnapshotFile().existsAsFile());
+            expect(!PreloadSnapshot(folder, config, snapshotFolder.folder).getSnapshotFile().existsAsFile());
+        }
+
+        beginTest("Corrupt, truncated and cancelled snapshots are rejected");
+        {
+            PreloadSnapshot writer(folder, config, snapshotFolder.folder);
+            expect(writer.write(preloads));
+
+            juce::MemoryBlock saved;
+            expect(writer.getSnapshotFile().loadFileAsData(saved));
+
+            // Cut off inside the sample data
+            writer.getSnapshotFile().replaceWithData(saved.getData(), saved.getSize() - 100);
+            expect(!PreloadSnapshot(folder, config, snapshotFolder.folder).open());
+
+            writer.getSnapshotFile().replaceWithText("not a snapshot");
+            expect(!PreloadSnapshot(folder, config, snapshotFolder.folder).open());
+
+            // Cancelled before the first sample: nothing is left on disk
+            writer.getSnapshotFile().deleteFile();
+            expect(!writer.write(preloads, [] { return true; }));
+            expect(!writer.getSnapshotFile().existsAsFile());
+            expect(writer.getSnapshotFile().getParentDirectory().findChildFiles(juce::File::findFiles, false).isEmpty());
+        }
+
+        beginTest("The engine writes a snapshot and the next load maps it");
+        {
+            TestAudioFiles::TempFolder engineLibrary("HammerSamplerSnapshotEngine");
+            TestAudioFiles::TempFolder cache("HammerSamplerSnapshotEngineCache");
+            const auto engineSnapshotFolder = cache.folder.getChildFile("PreloadSnapshots");
+            for (auto velocity : { "040", "127" })
+                for (auto rr : { "01", "02" })
+                    TestAudioFiles::writeRampWav(engineLibrary.folder.getChildFile(juce::String("C4_") + velocity + "_" + rr + ".wav"), 2000);
+
+            PreloadSnapshot::Config engineConfig;
+            engineConfig.preloadSizeKB = 64;
+            engineConfig.velocityLayerLimit = 2;
+            engineConfig.roundRobinLimit = 2;
+            const auto snapshotFile = PreloadSnapshot(engineLibrary.folder, engineConfig, engineSnapshotFolder).getSnapshotFile();
+
+            {
+                SamplerEngine engine;
+                engine.setCacheDirectory(cache.folder);
+                engine.loadSamplesFromFolder(engineLibrary.folder);
+                expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete; }));
+                expect(TestAudioFiles::waitFor([&] { return snapshotFile.existsAsFile(); }));
+            }
+
+            PreloadSnapshot snapshot(engineLibrary.folder, engineConfig, engineSnapshotFolder);
+            expect(snapshot.open());
+            expect(snapshot.getNumEntries() == 4);
+            const auto writtenTime = snapshotFile.getLastModificationTime().toMilliseconds();
+
+            SamplerEngine reopened;
+            reopened.setCacheDirectory(cache.folder);
+            reopened.loadSamplesFromFolder(engineLibrary.folder);
+            expect(TestAudioFiles::waitFor([&] { return reopened.getLoadStage() == LoadStage::Complete; }));
+            expect(reopened.getPreloadMemoryBytes() == 4 * 2000 * 2 * 4);
+            expect(snapshotFile.getLastModificationTime().toMilliseconds() == writtenTime);  // Already current: not rewritten
+        }
+    }
+};
+
+static PreloadSnapshotTests preloadSnapshotTests;
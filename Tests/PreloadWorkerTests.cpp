@@ -0,0 +1,86 @@
+#include <juce_core/juce_core.h>
+#include "../Source/PreloadWorker.h"
+
+//==============================================================================
+// Preload Worker Tests
+//==============================================================================
+class PreloadWorkerTests : public juce::UnitTest
+{
+public:
+    PreloadWorkerTests() : juce::UnitTest("Preload Worker") {}
+
+    void runTest() override
+    {
+        beginTest("Runs the job once per burst of requests");
+        {
+            std::atomic<int> runs{0};
+            juce::WaitableEvent release(true);
+
+            PreloadWorker worker([&]
+            {
+                ++runs;
+                release.wait(2000);  // Hold the first run while more requests arrive
+            }, nullptr);
+            worker.startThread();
+
+            worker.requestWork();
+            waitUntil([&] { return runs.load() == 1; });
+
+            for (int i = 0; i < 10; ++i)
+                worker.requestWork();
+            expect(worker.hasPendingRequest());
+
+            release.signal();
+            waitUntil([&] { return !worker.isBusy(); });
+
+            expect(runs.load() == 2);  // The 10 requests coalesced into one more run
+            worker.stopThread();
+        }
+
+        beginTest("Running job sees newer requests");
+        {
+            std::atomic<bool> sawNewerRequest{false};
+            std::atomic<int> runs{0};
+            PreloadWorker* workerPtr = nullptr;
+
+            PreloadWorker worker([&]
+            {
+                if (++runs == 1)
+                {
+                    workerPtr->requestWork();
+                    sawNewerRequest = workerPtr->hasPendingRequest();
+                }
+            }, nullptr);
+            workerPtr = &worker;
+            worker.startThread();
+
+            worker.requestWork();
+            waitUntil([&] { return runs.load() >= 2 && !worker.isBusy(); });
+
+            expect(sawNewerRequest.load());
+            expect(runs.load() == 2);
+            worker.stopThread();
+        }
+
+        beginTest("Housekeeping runs while idle");
+        {
+            std::atomic<int> housekeepingRuns{0};
+            PreloadWorker worker(nullptr, [&] { ++housekeepingRuns; });
+            worker.startThread();
+
+            waitUntil([&] { return housekeepingRuns.load() >= 2; });
+            expect(housekeepingRuns.load() >= 2);
+            worker.stopThread();
+        }
+    }
+
+private:
+    template <typename Condition>
+    static void waitUntil(Condition condition)
+    {
+        for (int i = 0; i < 500 && !condition(); ++i)
+            juce::Thread::sleep(5);
+    }
+};
+
+static PreloadWorkerTests preloadWorkerTests;
@@ -0,0 +1,108 @@
+#include <juce_core/juce_core.h>
+#include "../Source/SampleLookupTable.h"
+
+//==============================================================================
+// Sample Lookup Table Tests
+//==============================================================================
+class SampleLookupTableTests : public juce::UnitTest
+{
+public:
+    SampleLookupTableTests() : juce::UnitTest("Sample Lookup Table") {}
+
+    void runTest() override
+    {
+        // C4 (60) has 4 layers x 3 RRs, D4 (62) has 2 layers x 1 RR, C#4 (61) falls back to D4
+        std::array<SampleLookupTable::NoteLayout, 128> notes{};
+        notes[60] = { 4, -1, true };
+        notes[61] = { 0, 62, true };
+        notes[62] = { 2, -1, true };
+
+        std::vector<SampleLookupTable::SampleKey> samples;
+        for (int layer = 0; layer < 4; ++layer)
+            for (int rr = 1; rr <= 3; ++rr)
+                samples.push_back({ 60, layer, rr });
+        samples.push_back({ 62, 0, 1 });
+        samples.push_back({ 62, 1, 1 });
+
+        beginTest("Exact note, layer and round-robin");
+        {
+            SampleLookupTable table;
+            table.build(notes, samples, 4);
+
+            expect(table.find(60, 1, 1) == 0);     // Layer 0, RR 1
+            expect(table.find(60, 1, 3) == 2);     // Layer 0, RR 3
+            expect(table.find(60, 127, 2) == 10);  // Layer 3, RR 2
+            expect(table.find(60, 64, 1) == 3);    // (63 * 4) / 127 = layer 1, RR 1
+        }
+
+        beginTest("Velocity layer mapping honours the limit");
+        {
+            SampleLookupTable table;
+            table.build(notes, samples, 2);
+
+            expect(table.getVelocityLayerIndex(60, 1) == 0);
+            expect(table.getVelocityLayerIndex(60, 64) == 0);
+            expect(table.getVelocityLayerIndex(60, 65) == 1);
+            expect(table.getVelocityLayerIndex(60, 127) == 1);
+            expect(table.find(60, 127, 1) == 3);  // Layer 1 only, never layers 2-3
+        }
+
+        beginTest("Fallback notes and missing round-robins");
+        {
+            SampleLookupTable table;
+            table.build(notes, samples, 4);
+
+            expect(table.getResolvedNote(61) == 62);
+            expect(table.find(61, 127, 1) == 13);  // Borrowed from D4, top layer
+            expect(table.find(62, 10, 3) == 12);   // RR 3 missing -> first sample of the layer
+            expect(table.find(62, 10, 9) == 12);   // RR beyond the table -> same fallback
+        }
+
+        beginTest("Unplayable samples and unmapped notes");
+        {
+            auto partial = samples;
+            partial[0].velocityLayerIndex = -1;  // C4 layer 0 RR 1 not preloaded
+
+            SampleLookupTable table;
+            table.build(notes, partial, 4);
+
+            expect(table.find(60, 1, 1) == 1);   // Falls through to RR 2
+            expect(table.find(59, 100, 1) == -1);
+            expect(table.find(128, 100, 1) == -1);
+            expect(table.getVelocityLayerIndex(59, 100) == -1);
+
+            table.clear();
+            expect(table.find(60, 1, 1) == -1);
+        }
+
+        beginTest("Layers with nothing playable borrow the nearest layer");
+        {
+            // Only C4 layer 2 RR 1 is loaded, as after the first load stage
+            auto partial = samples;
+            for (auto& key : partial)
+            {
+                if (key.midiNote == 60 && !(key.velocityLayerIndex == 2 && key.roundRobin == 1))
+                    key.velocityLayerIndex = -1;
+            }
+
+            SampleLookupTable table;
+            table.build(notes, partial, 4);
+
+            expect(table.find(60, 1, 1) == 6);    // Layer 0 -> layer 2
+            expect(table.find(60, 127, 3) == 6);  // Layer 3 -> layer 2
+            expect(table.find(60, 90, 2) == 6);   // Layer 2, RR 2 missing -> RR 1
+
+            // Equally near on both sides: the softer layer wins
+            auto gap = samples;
+            for (auto& key : gap)
+            {
+                if (key.midiNote == 60 && key.velocityLayerIndex == 1)
+                    key.velocityLayerIndex = -1;
+            }
+            table.build(notes, gap, 4);
+            expect(table.find(60, 64, 2) == 0);  // Layer 1 -> layer 0, its first sample
+        }
+    }
+};
+
+static SampleLookupTableTests sampleLookupTableTests;
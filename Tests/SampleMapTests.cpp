@@ -0,0 +1,93 @@
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <atomic>
+#include <optional>
+#include "../Source/DeferredReclaimer.h"
+#include "../Source/SamplerEngine.h"
+#include "TestAudioFiles.h"
+
+//==============================================================================
+// Sample Map Tests
+//==============================================================================
+class SampleMapTests : public juce::UnitTest
+{
+public:
+    SampleMapTests() : juce::UnitTest("Sample Map Publication") {}
+
+    void runTest() override
+    {
+        beginTest("Retired objects wait for reader passes in progress");
+        {
+            DeferredReclaimer reclaimer;
+            std::atomic<int> destroyed{0};
+
+            reclaimer.retire(std::make_unique<Tracked>(destroyed));
+            expectEquals(reclaimer.collect(), 0);
+            expectEquals(destroyed.load(), 1);  // No reader was inside a pass
+
+            {
+                std::optional<DeferredReclaimer::ReadScope> audioPass;
+                audioPass.emplace(reclaimer, DeferredReclaimer::audioThreadReader);
+                reclaimer.retire(std::make_unique<Tracked>(destroyed));
+                expectEquals(reclaimer.collect(), 1);
+
+                // A pass starting after the retire doesn't hold it up, only the one in progress
+                DeferredReclaimer::ReadScope diskPass(reclaimer, DeferredReclaimer::diskThreadReader);
+                audioPass.reset();
+                expectEquals(reclaimer.collect(), 0);
+            }
+            expectEquals(destroyed.load(), 2);
+        }
+
+        beginTest("Published map survives until readers leave");
+        {
+            TestAudioFiles::TempFolder library("HammerSamplerSampleMap");
+            TestAudioFiles::TempFolder cache("HammerSamplerSampleMapCache");
+            for (const char* velocity : { "64", "127" })
+                TestAudioFiles::writeRampWav(library.folder.getChildFile(juce::String("C4_") + velocity + "_01.wav"), 20000);
+
+            SamplerEngine engine;
+            engine.setCacheDirectory(cache.folder);
+            engine.prepareToPlay(44100.0, 512);
+            engine.loadSamplesFromFolder(library.folder);
+            expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete && !engine.getPreloadProgress().inProgress; }));
+            expect(TestAudioFiles::waitFor([&] { return engine.getPendingReclaimCount() == 0; }));
+
+            juce::AudioBuffer<float> buffer(2, 512);
+            {
+                // This block pinned the map with both layers; the preload worker republishes without the upper one
+                SamplerEngine::AudioBlockScope audioBlock(engine);
+                engine.setVelocityLayerLimit(1);
+                expect(TestAudioFiles::waitFor([&] { return engine.getPendingReclaimCount() > 0; }));
+                juce::Thread::sleep(50);
+                expect(engine.getPendingReclaimCount() > 0);
+
+                // The pinned map and its upper layer preload are still whole
+                buffer.clear();
+                engine.noteOn(60, 127, 1);
+                engine.processBlock(buffer);
+                expect(buffer.getMagnitude(0, 512) > 0.0f);
+                engine.noteOff(60);
+            }
+
+            // Freed once the block is over and the voice has let go of the preload
+            expect(TestAudioFiles::waitFor([&]
+            {
+                SamplerEngine::AudioBlockScope audioBlock(engine);
+                engine.processBlock(buffer);
+                return engine.getActiveVoiceCount() == 0;
+            }));
+            expect(TestAudioFiles::waitFor([&] { return engine.getPendingReclaimCount() == 0; }));
+        }
+    }
+
+private:
+    struct Tracked
+    {
+        explicit Tracked(std::atomic<int>& counter) : destroyed(counter) {}
+        ~Tracked() { ++destroyed; }
+        std::atomic<int>& destroyed;
+    };
+};
+
+static SampleMapTests sampleMapTests;
@@ -0,0 +1,101 @@
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "../Source/LibraryScanner.h"
+#include "../Source/SamplePath.h"
+#include "../Source/SampleTable.h"
+#include "../Source/SamplerEngine.h"
+#include "TestAudioFiles.h"
+
+//==============================================================================
+// Sample Table Tests
+//==============================================================================
+class SampleTableTests : public juce::UnitTest
+{
+public:
+    SampleTableTests() : juce::UnitTest("Sample Metadata") {}
+
+    void runTest() override
+    {
+        beginTest("Interned paths are shared, and keep their full path");
+        {
+            TestAudioFiles::TempFolder folder("HammerSamplerSamplePath");
+            const auto fileA = folder.folder.getChildFile("C4_127_01.wav");
+            const auto fileB = folder.folder.getChildFile("D4_127_01.wav");
+
+            const auto a = SamplePath::intern(fileA);
+            const int64_t internedBytes = SamplePath::getInternedBytes();
+            expect(SamplePath::intern(fileA.getFullPathName()) == a);
+            expect(SamplePath::getInternedBytes() == internedBytes);  // Nothing new
+
+            const auto b = SamplePath::intern(fileB);
+            expect(b != a);
+            expect(a.getFile() == fileA && b.toString() == fileB.getFullPathName());
+            expect(a.getFileName() == "C4_127_01.wav");
+            expect(a.getFolderKey() != nullptr && a.getFolderKey() == b.getFolderKey());  // One folder node
+            expect(SamplePath::getInternedBytes() == internedBytes + static_cast<int64_t>(b.getNodeBytes()));
+
+            expect(SamplePath().isEmpty() && SamplePath::intern(juce::String()).isEmpty());
+        }
+
+        beginTest("A table row describes its sample as the scan found it, trimmed as asked");
+        {
+            LibraryScanner::ScannedSample scanned = LibraryScanner::describeSample(juce::File("/tmp/E4_100_03.wav"), 64, 100, 3,
+                                                                                  48000.0, 2, 20000, 24);
+            scanned.fileSize = 120044;
+            scanned.dataOffset = 44;
+            scanned.contentHash = 0x1234;
+
+            SampleTable table;
+            expect(table.add(scanned, 1, 500, 18000) == 0);
+            expect(table.size() == 1);
+            expect(table.midiNotes[0] == 64 && table.velocities[0] == 100 && table.roundRobins[0] == 3);
+            expect(table.libraryLayers[0] == 1 && table.velocityLayerIndices[0] == -1);
+            expect(table.fileFrames[0] == 20000 && table.fileSizes[0] == 120044 && table.dataOffsets[0] == 44);
+            expect(table.contentHashes[0] == 0x1234);
+
+            const auto info = table.describe(0);
+            expect(info.path == scanned.info.path);
+            expect(info.fileStartFrame == 500 && info.totalSampleFrames == 18000);
+            expect(info.sampleRate == 48000.0 && info.numChannels == 2 && info.integerBits == 24);
+            expect(info.rootNote == 64);
+        }
+
+        beginTest("The engine reports a few hundred bytes of metadata per sample");
+        {
+            // 7 notes x 5 octaves x 3 velocities x 2 round robins
+            TestAudioFiles::TempFolder library("HammerSamplerSampleMetadata");
+            TestAudioFiles::TempFolder cache("HammerSamplerSampleMetadataCache");
+            int numSamples = 0;
+            for (int octave = 2; octave <= 6; ++octave)
+                for (const char* noteName : { "C", "D", "E", "F", "G", "A", "B" })
+                    for (int velocity : { 40, 80, 127 })
+                        for (int roundRobin = 1; roundRobin <= 2; ++roundRobin)
+                        {
+                            const auto fileName = juce::String(noteName) + juce::String(octave) + "_" + juce::String(velocity) + "_0"
+                                                + juce::String(roundRobin) + ".wav";
+                            TestAudioFiles::writeRampWav(library.folder.getChildFile(fileName), 2000);
+                            ++numSamples;
+                        }
+
+            SamplerEngine engine;
+            engine.setCacheDirectory(cache.folder);
+            engine.prepareToPlay(44100.0, 512);
+            engine.loadSamplesFromFolder(library.folder);
+            expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete && !engine.getPreloadProgress().inProgress; }));
+
+            const auto metadata = engine.getSampleMetadata();
+            expectEquals(metadata.samples, numSamples);
+            expect(metadata.tableBytes > 0 && metadata.rowBytes > 0);
+            expectLessThan(metadata.getBytesPerSample(), static_cast<int64_t>(256));
+
+            // Reloading interns nothing new
+            const int64_t internedBytes = SamplePath::getInternedBytes();
+            engine.loadSamplesFromFolder(library.folder);
+            expect(TestAudioFiles::waitFor([&] { return !engine.isLoading() && engine.getLoadStage() == LoadStage::Complete; }));
+            expectEquals(engine.getSampleMetadata().samples, numSamples);
+            expect(SamplePath::getInternedBytes() == internedBytes);
+        }
+    }
+};
+
+static SampleTableTests sampleTableTests;
@@ -0,0 +1,136 @@
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "../Source/LibraryScanner.h"
+#include "../Source/SamplerEngine.h"
+#include "TestAudioFiles.h"
+
+//==============================================================================
+// Silence Trim Tests
+//==============================================================================
+class SilenceTrimTests : public juce::UnitTest
+{
+public:
+    SilenceTrimTests() : juce::UnitTest("Silence Trimming") {}
+
+    void runTest() override
+    {
+        // 1000 frames of digital silence, the sound, then a tail at about -84 dB
+        constexpr int leadFrames = 1000;
+        constexpr float tailLevel = 2.5f / 32767.0f;
+        auto writeSample = [](const juce::File& file, int soundFrames, int tailFrames)
+        {
+            return TestAudioFiles::writeWav(file, 2, leadFrames + soundFrames + tailFrames, 44100, [=](int channel, int frame)
+            {
+                if (frame < leadFrames)
+                    return 0.0f;
+                if (frame < leadFrames + soundFrames)
+                    return TestAudioFiles::rampValue(channel, frame);
+                return tailLevel;
+            });
+        };
+
+        beginTest("The audible range skips leading and trailing silence at the threshold");
+        {
+            TestAudioFiles::TempFolder folder("HammerSamplerSilenceRange");
+            const auto file = folder.folder.getChildFile("C4_127_01.wav");
+            writeSample(file, 5000, 3000);
+
+            juce::AudioFormatManager formatManager;
+            formatManager.registerBasicFormats();
+            auto audibleRange = [&](const juce::File& f, float thresholdDb)
+            {
+                std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(f));
+                int64_t start = -1, end = -1;
+                LibraryScanner::findAudibleRange(*reader, thresholdDb, start, end);
+                return std::make_pair(start, end);
+            };
+
+            expect(audibleRange(file, -80.0f) == std::make_pair<int64_t, int64_t>(leadFrames, leadFrames + 5000));
+            expect(audibleRange(file, -90.0f) == std::make_pair<int64_t, int64_t>(leadFrames, leadFrames + 8000));  // The tail counts
+
+            // A silent file keeps everything
+            const auto silent = folder.folder.getChildFile("D4_127_01.wav");
+            TestAudioFiles::writeWav(silent, 2, 4000, 44100, [](int, int) { return 0.0f; });
+            expect(audibleRange(silent, -80.0f) == std::make_pair<int64_t, int64_t>(0, 4000));
+
+            // The scan reports it when asked
+            LibraryScanner::Options options;
+            options.parseFileName = &SamplerEngine::parseFileName;
+            options.analyseSilence = true;
+            const auto scanned = LibraryScanner(formatManager).scan(folder.folder, options);
+            expect(scanned.size() == 2);
+            expect(scanned[0].audibleStart == leadFrames && scanned[0].audibleEnd == leadFrames + 5000);
+            expect(scanned[0].audibleThresholdDb == -80.0f);
+            expect(scanned[0].info.totalSampleFrames == leadFrames + 8000);  // The scan itself trims nothing
+        }
+
+        beginTest("A trimming layer starts at the sound, preloads less and stops streaming at the tail");
+        {
+            // C4 fits in its preload; D4 streams
+            TestAudioFiles::TempFolder library("HammerSamplerSilenceTrim");
+            TestAudioFiles::TempFolder cache("HammerSamplerSilenceTrimCache");
+            writeSample(library.folder.getChildFile("C4_127_01.wav"), 3000, 3000);
+            writeSample(library.folder.getChildFile("D4_127_01.wav"), 30000, 30000);
+
+            auto firstBlock = [](SamplerEngine& engine, int note)
+            {
+                juce::AudioBuffer<float> buffer(2, 512);
+                buffer.clear();
+                SamplerEngine::AudioBlockScope audioBlock(engine);
+                engine.noteOn(note, 127, 1);
+                engine.processBlock(buffer);
+                return buffer.getMagnitude(0, 512);
+            };
+
+            // Blocks until the voice runs out of sample, with the key held
+            auto blocksPlayed = [](SamplerEngine& engine, int note)
+            {
+                int blocks = 0;
+                {
+                    SamplerEngine::AudioBlockScope audioBlock(engine);
+                    engine.noteOn(note, 127, 1);
+                }
+                juce::AudioBuffer<float> buffer(2, 512);
+                for (; blocks < 1000 && engine.getActiveVoiceCount() > 0; ++blocks)
+                {
+                    juce::Thread::sleep(2);  // Time for the disk thread
+                    SamplerEngine::AudioBlockScope audioBlock(engine);
+                    engine.processBlock(buffer);
+                }
+                engine.noteOff(note);
+                return blocks;
+            };
+
+            SamplerEngine engine;
+            engine.setCacheDirectory(cache.folder);
+            engine.prepareToPlay(44100.0, 512);
+            engine.loadSamplesFromFolder(library.folder);
+            expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete && !engine.getPreloadProgress().inProgress; }));
+
+            constexpr int64_t streamedPreloadBytes = 64 * 1024;
+            expect(engine.getPreloadMemoryBytes() == (leadFrames + 6000) * 2 * 4 + streamedPreloadBytes);
+            expect(firstBlock(engine, 60) == 0.0f);  // The leading silence is longer than a block
+            const int untrimmedBlocks = blocksPlayed(engine, 62);
+            expect(untrimmedBlocks >= (leadFrames + 60000) / 512);
+
+            // Switching it on reloads the library trimmed
+            auto settings = engine.getLibraryLayers().front().settings;
+            settings.trimSilence = true;
+            engine.setLayerSettings(0, settings);
+            expect(TestAudioFiles::waitFor([&] { return engine.getPreloadMemoryBytes() == 3000 * 2 * 4 + streamedPreloadBytes; }));
+            expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete && !engine.getPreloadProgress().inProgress; }));
+
+            expect(firstBlock(engine, 60) > 0.0f);
+            const int trimmedBlocks = blocksPlayed(engine, 62);
+            expect(trimmedBlocks >= 30000 / 512 && trimmedBlocks < untrimmedBlocks);
+            expect(trimmedBlocks <= 30000 / 512 + 4);
+
+            // A lower threshold keeps the tail
+            settings.silenceThresholdDb = -90.0f;
+            engine.setLayerSettings(0, settings);
+            expect(TestAudioFiles::waitFor([&] { return engine.getPreloadMemoryBytes() == 6000 * 2 * 4 + streamedPreloadBytes; }));
+        }
+    }
+};
+
+static SilenceTrimTests silenceTrimTests;
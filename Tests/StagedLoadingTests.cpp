@@ -0,0 +1,259 @@
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "../Source/SamplerEngine.h"
+#include "TestAudioFiles.h"
+
+//==============================================================================
+// Staged Loading Tests
+//==============================================================================
+class StagedLoadingTests : public juce::UnitTest
+{
+public:
+    StagedLoadingTests() : juce::UnitTest("Staged Loading") {}
+
+    void runTest() override
+    {
+        // Two notes x 3 velocity layers x 2 round robins
+        TestAudioFiles::TempFolder library("HammerSamplerStagedLoading");
+        TestAudioFiles::TempFolder cache("HammerSamplerStagedLoadingCache");
+        for (auto note : { "C4", "D4" })
+            for (auto velocity : { "040", "080", "127" })
+                for (auto rr : { "01", "02" })
+                    TestAudioFiles::writeRampWav(library.folder.getChildFile(juce::String(note) + "_" + velocity + "_" + rr + ".wav"), 2000);
+
+        beginTest("Stages advance to complete and every preload arrives");
+        {
+            SamplerEngine engine;
+            engine.setCacheDirectory(cache.folder);
+            expect(engine.getLoadStage() == LoadStage::None);
+
+            engine.loadSamplesFromFolder(library.folder);
+            expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete; }));
+
+            expect(engine.isLoaded());
+            expect(engine.getMaxVelocityLayersGlobal() == 3);
+            expect(engine.getMaxRoundRobins() == 2);
+
+            // 12 stereo float preloads of 2000 frames
+            expect(TestAudioFiles::waitFor([&] { return engine.getPreloadMemoryBytes() == 12 * 2000 * 2 * 4; }));
+        }
+
+        beginTest("Playable before later stages are in");
+        {
+            SamplerEngine engine;
+            engine.setCacheDirectory(cache.folder);
+            engine.loadSamplesFromFolder(library.folder);
+
+            // Loaded is reported as soon as stage 1 is published
+            expect(TestAudioFiles::waitFor([&] { return engine.isLoaded(); }));
+            expect(engine.getLoadStage() >= LoadStage::Playable);
+            expect(engine.getPreloadMemoryBytes() >= 2 * 2000 * 2 * 4);  // At least one sample per note
+
+            expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete; }));
+        }
+
+        beginTest("Progress counts files and preload bytes");
+        {
+            SamplerEngine engine;
+            engine.setCacheDirectory(cache.folder);
+            expect(!engine.getLoadProgress().inProgress);
+
+            engine.loadSamplesFromFolder(library.folder);
+            expect(engine.getLoadProgress().inProgress);
+            expect(TestAudioFiles::waitFor([&] { return !engine.getLoadProgress().inProgress; }));
+
+            auto progress = engine.getLoadProgress();
+            expect(progress.filesTotal == 12);
+            expect(progress.filesScanned == 12);
+            expect(progress.bytesToPreload == 12 * 2000 * 2 * 4);
+            expect(progress.bytesPreloaded == progress.bytesToPreload);
+        }
+
+        beginTest("A newer load supersedes one in progress without blocking");
+        {
+            TestAudioFiles::TempFolder other("HammerSamplerStagedLoadingOther");
+            for (auto rr : { "01", "02", "03" })
+                TestAudioFiles::writeRampWav(other.folder.getChildFile(juce::String("E4_100_") + rr + ".wav"), 1000);
+
+            SamplerEngine engine;
+            engine.setCacheDirectory(cache.folder);
+            const auto startTime = juce::Time::getMillisecondCounter();
+            engine.loadSamplesFromFolder(library.folder);
+            engine.loadSamplesFromFolder(other.folder);
+            expect(juce::Time::getMillisecondCounter() - startTime < 100);  // Neither call waits for disk
+
+            expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete && engine.isLoaded(); }));
+            expect(engine.getMaxRoundRobins() == 3);
+            expect(engine.getMaxVelocityLayersGlobal() == 1);
+            expect(engine.noteHasOwnSamples(64) && !engine.noteHasOwnSamples(60));
+            expect(TestAudioFiles::waitFor([&] { return engine.getPreloadMemoryBytes() == 3 * 1000 * 2 * 4; }));
+        }
+
+        beginTest("Switching libraries keeps the old one playing until the swap");
+        {
+            // 30000 frames: the note outlasts the load, and stays within its preload
+            TestAudioFiles::TempFolder first("HammerSamplerStagedLoadingFirst");
+            TestAudioFiles::writeRampWav(first.folder.getChildFile("C4_127_01.wav"), 30000);
+
+            SamplerEngine engine;
+            engine.setCacheDirectory(cache.folder);
+            engine.prepareToPlay(44100.0, 512);
+            engine.loadSamplesFromFolder(first.folder);
+            expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete; }));
+
+            juce::AudioBuffer<float> buffer(2, 512);
+            auto renderBlock = [&](int noteToStart)
+            {
+                SamplerEngine::AudioBlockScope audioBlock(engine);
+                if (noteToStart >= 0)
+                    engine.noteOn(noteToStart, 127, 1);
+                buffer.clear();
+                engine.processBlock(buffer);
+                return buffer.getMagnitude(0, 512) > 0.0f;
+            };
+
+            expect(renderBlock(60));
+
+            // While the next library loads, the held note sounds on and new notes still play
+            engine.loadSamplesFromFolder(library.folder);
+            expect(renderBlock(-1));
+            expect(renderBlock(60) || !engine.isLoading());
+            expect(engine.getActiveVoiceCount() >= 1);
+
+            expect(TestAudioFiles::waitFor([&] { return engine.isLoaded(); }));
+            expect(engine.noteHasOwnSamples(62));
+
+            // After the swap the old voices finish on the old preloads
+            expect(renderBlock(-1));
+            expect(engine.getActiveVoiceCount() >= 1);
+            expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete; }));
+            expect(TestAudioFiles::waitFor([&] { return engine.getPreloadMemoryBytes() == 12 * 2000 * 2 * 4; }));
+        }
+
+        beginTest("Preload size changes resize what is loaded");
+        {
+            // Long enough that every preload size cuts the file: 4096 frames at 32 KB, 8192 at 64 KB
+            TestAudioFiles::TempFolder longLibrary("HammerSamplerStagedLoadingLong");
+            for (auto velocity : { "064", "127" })
+                TestAudioFiles::writeRampWav(longLibrary.folder.getChildFile(juce::String("C4_") + velocity + "_01.wav"), 30000);
+
+            juce::AudioFormatManager formatManager;
+            formatManager.registerBasicFormats();
+            LibraryScanner::Options options;
+            options.parseFileName = &SamplerEngine::parseFileName;
+
+            // Resized preloads must match a fresh read at the new size; the snapshot the
+            // engine writes once resizing is done holds exactly what it resized
+            auto matchesFreshRead = [&](int sizeKB)
+            {
+                PreloadSnapshot::Config config;
+                config.preloadSizeKB = sizeKB;
+                config.velocityLayerLimit = 2;
+                config.roundRobinLimit = 1;
+                PreloadSnapshot snapshot(longLibrary.folder, config, cache.folder.getChildFile("PreloadSnapshots"));
+                if (!TestAudioFiles::waitFor([&] { return snapshot.open(); }))
+                    return false;
+
+                const auto fresh = LibraryScanner(formatManager).scan(longLibrary.folder, options);
+                bool matches = fresh.size() == 2;
+                for (const auto& sample : fresh)
+                {
+                    auto mapped = snapshot.createPreload(sample.info);
+                    const auto decoded = TestAudioFiles::decodePreload(sample.info, sizeKB);
+                    if (decoded == nullptr)
+                        return false;
+                    const auto& expected = decoded->preloadBuffer;
+                    matches = matches && mapped != nullptr
+                           && mapped->preloadBuffer.getNumSamples() == expected.getNumSamples();
+                    for (int channel = 0; matches && channel < expected.getNumChannels(); ++channel)
+                        matches = std::memcmp(mapped->preloadBuffer.getReadPointer(channel), expected.getReadPointer(channel),
+                                              sizeof(float) * static_cast<size_t>(expected.getNumSamples())) == 0;
+                }
+                snapshot.getSnapshotFile().deleteFile();
+                return matches;
+            };
+
+            SamplerEngine engine;
+            engine.setCacheDirectory(cache.folder);
+            engine.loadSamplesFromFolder(longLibrary.folder);
+            expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete; }));
+            expect(engine.getPreloadMemoryBytes() == 2 * 8192 * 2 * 4);
+            expect(matchesFreshRead(64));
+
+            engine.setPreloadSizeKB(128);  // Growth reads the tail after frame 8192
+            engine.reloadPreloadBuffers();
+            expect(TestAudioFiles::waitFor([&] { return engine.getPreloadMemoryBytes() == 2 * 16384 * 2 * 4; }));
+            expect(matchesFreshRead(128));
+
+            engine.setPreloadSizeKB(32);  // Shrinking keeps the first 4096 frames
+            engine.reloadPreloadBuffers();
+            expect(TestAudioFiles::waitFor([&] { return engine.getPreloadMemoryBytes() == 2 * 4096 * 2 * 4; }));
+            expect(matchesFreshRead(32));
+
+            // Preloads mapped from a snapshot shrink by referring to less of the mapping
+            engine.setPreloadSizeKB(64);
+            engine.reloadPreloadBuffers();
+            PreloadSnapshot::Config config64;
+            config64.preloadSizeKB = 64;
+            config64.velocityLayerLimit = 2;
+            config64.roundRobinLimit = 1;
+            expect(TestAudioFiles::waitFor([&] { return PreloadSnapshot(longLibrary.folder, config64, cache.folder.getChildFile("PreloadSnapshots")).open(); }));
+
+            SamplerEngine reopened;
+            reopened.setCacheDirectory(cache.folder);
+            reopened.loadSamplesFromFolder(longLibrary.folder);
+            expect(TestAudioFiles::waitFor([&] { return reopened.getLoadStage() == LoadStage::Complete; }));
+            reopened.setPreloadSizeKB(32);
+            reopened.reloadPreloadBuffers();
+            expect(TestAudioFiles::waitFor([&] { return reopened.getPreloadMemoryBytes() == 2 * 4096 * 2 * 4; }));
+            expect(matchesFreshRead(32));
+        }
+
+        beginTest("Played samples form a working set that carries into the next load");
+        {
+            WorkingSet played;
+            {
+                SamplerEngine engine;
+                engine.setCacheDirectory(cache.folder);
+                engine.prepareToPlay(44100.0, 512);
+                engine.loadSamplesFromFolder(library.folder);
+                expect(TestAudioFiles::waitFor([&] { return engine.getLoadStage() == LoadStage::Complete; }));
+                expect(engine.getWorkingSet().entries.empty());
+
+                juce::AudioBuffer<float> buffer(2, 512);
+                for (int block = 0; block < 4; ++block)
+                {
+                    SamplerEngine::AudioBlockScope audioBlock(engine);
+                    if (block == 0)
+                    {
+                        engine.noteOn(60, 127, 2);
+                        engine.noteOn(62, 40, 1);
+                    }
+                    buffer.clear();
+                    engine.processBlock(buffer);
+                }
+
+                played = engine.getWorkingSet();
+                expect(played.entries.size() == 2);
+                for (const auto& entry : played.entries)
+                {
+                    expect(entry.plays == 1);
+                    expect((entry.midiNote == 60 && entry.velocity == 127 && entry.roundRobin == 2) ||
+                           (entry.midiNote == 62 && entry.velocity == 40 && entry.roundRobin == 1));
+                }
+            }
+
+            SamplerEngine reopened;
+            reopened.setCacheDirectory(cache.folder);
+            reopened.setWorkingSet(WorkingSet::fromString(played.toString()));
+            expect(reopened.getWorkingSet().entries.size() == 2);  // Kept while nothing is loaded
+
+            reopened.loadSamplesFromFolder(library.folder);
+            expect(TestAudioFiles::waitFor([&] { return reopened.isLoaded(); }));
+            expect(reopened.getWorkingSet().entries.size() == 2);
+            expect(TestAudioFiles::waitFor([&] { return reopened.getLoadStage() == LoadStage::Complete; }));
+        }
+    }
+};
+
+static StagedLoadingTests stagedLoadingTests;
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "../Source/LibraryScanner.h"
+
+/**
+ * Helpers for tests that need sample libraries on disk, and for waiting on the
+ * engine's background threads.
+ */
+namespace TestAudioFiles
+{
+    /** Fresh, empty folder in the temp directory (removed by the destructor) */
+    struct TempFolder
+    {
+        explicit TempFolder(const juce::String& name)
+            : folder(juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile(name))
+        {
+            folder.deleteRecursively();
+            folder.createDirectory();
+        }
+
+        ~TempFolder() { folder.deleteRecursively(); }
+
+        juce::File folder;
+    };
+
+    /** Polls condition every 5 ms until it holds (true) or timeoutMs passes (false) */
+    template <typename Condition>
+    bool waitFor(Condition condition, int timeoutMs = 5000)
+    {
+        const auto deadline = juce::Time::getMillisecondCounter() + static_cast<juce::uint32>(timeoutMs);
+        while (!condition())
+        {
+            if (juce::Time::getMillisecondCounter() > deadline)
+                return false;
+            juce::Thread::sleep(5);
+        }
+        return true;
+    }
+
+    /** Write a 16-bit PCM WAV file. valueAt(channel, frame) returns samples in -1..1. */
+    inline bool writeWav(const juce::File& file, int numChannels, int numFrames, int sampleRate,
+                         const std::function<float(int channel, int frame)>& valueAt)
+    {
+        std::vector<char> bytes;
+        auto append = [&bytes](const void* data, size_t size)
+        {
+            const char* p = static_cast<const char*>(data);
+            bytes.insert(bytes.end(), p, p + size);
+        };
+        auto append32 = [&](uint32_t v) { append(&v, 4); };
+        auto append16 = [&](uint16_t v) { append(&v, 2); };
+
+        const uint32_t dataSize = static_cast<uint32_t>(numFrames * numChannels * 2);
+
+        append("RIFF", 4);
+        append32(36 + dataSize);
+        append("WAVE", 4);
+
+        append("fmt ", 4);
+        append32(16);
+        append16(1);  // PCM
+        append16(static_cast<uint16_t>(numChannels));
+        append32(static_cast<uint32_t>(sampleRate));
+        append32(static_cast<uint32_t>(sampleRate * numChannels * 2));
+        append16(static_cast<uint16_t>(numChannels * 2));
+        append16(16);
+
+        append("data", 4);
+        append32(dataSize);
+        for (int frame = 0; frame < numFrames; ++frame)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                const float value = juce::jlimit(-1.0f, 1.0f, valueAt(ch, frame));
+                append16(static_cast<uint16_t>(static_cast<int16_t>(value * 32767.0f)));
+            }
+        }
+
+        file.getParentDirectory().createDirectory();
+        return file.replaceWithData(bytes.data(), bytes.size());
+    }
+
+    /** Stereo ramp whose samples encode (frame, channel), for checking what was read */
+    inline float rampValue(int channel, int frame)
+    {
+        return static_cast<float>((frame % 1000) - 500) / 1000.0f * (channel == 0 ? 1.0f : -1.0f);
+    }
+
+    /** Stereo test tone: the ramp, except frame 2 is stamped from the file path so no two files
+        are duplicates (the engine shares identical samples' preloads) */
+    inline bool writeRampWav(const juce::File& file, int numFrames, int sampleRate = 44100)
+    {
+        const auto stamp = static_cast<uint32_t>(file.getFullPathName().hashCode());
+        return writeWav(file, 2, numFrames, sampleRate, [stamp](int channel, int frame)
+        {
+            if (frame != 2)
+                return rampValue(channel, frame);
+            return static_cast<float>((stamp >> (channel * 16)) & 0xffff) / 32768.0f - 1.0f;
+        });
+    }
+
+    /** A float preload of preloadSizeKB decoded straight from the sample's file: what the engine's
+        preload of that size must hold. Null if the file can't be read. */
+    inline std::unique_ptr<PreloadedSample> decodePreload(const PreloadedSample& info, int preloadSizeKB)
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(info.path.getFile()));
+        if (reader == nullptr || info.numChannels <= 0)
+            return nullptr;
+
+        const int frames = LibraryScanner::getPreloadSizeFrames(info, preloadSizeKB);
+        auto preload = LibraryScanner::makePreload(info);
+        preload->preloadBuffer.setSize(info.numChannels, frames);
+        reader->read(&preload->preloadBuffer, 0, frames, info.fileStartFrame, true, true);
+        preload->preloadSizeFrames = frames;
+        return preload;
+    }
+}
@@ -0,0 +1,98 @@
+#include <juce_core/juce_core.h>
+#include "../Source/VoicePool.h"
+
+//==============================================================================
+// Voice Pool Tests
+//==============================================================================
+class VoicePoolTests : public juce::UnitTest
+{
+public:
+    VoicePoolTests() : juce::UnitTest("Voice Pool") {}
+
+    void runTest() override
+    {
+        beginTest("Allocate until full");
+        {
+            VoicePool pool(4);
+            expect(pool.getNumActive() == 0);
+
+            for (int i = 0; i < 4; ++i)
+                expect(pool.allocate(60 + i) == i);
+
+            expect(pool.getNumActive() == 4);
+            expect(pool.allocate(70) == VoicePool::none);
+            expect(pool.getOldestActive() == 0);
+        }
+
+        beginTest("Per-note lists keep start order");
+        {
+            VoicePool pool(8);
+            int first = pool.allocate(60);
+            pool.allocate(62);
+            int second = pool.allocate(60);
+            int third = pool.allocate(60);
+
+            expect(pool.getNumActiveForNote(60) == 3);
+            expect(pool.getNumActiveForNote(62) == 1);
+            expect(pool.getOldestForNote(60) == first);
+            expect(pool.getNextForNote(first) == second);
+            expect(pool.getNextForNote(second) == third);
+            expect(pool.getNextForNote(third) == VoicePool::none);
+            expect(pool.getOldestForNote(61) == VoicePool::none);
+        }
+
+        beginTest("Release from the middle of the lists");
+        {
+            VoicePool pool(8);
+            int a = pool.allocate(60);
+            int b = pool.allocate(60);
+            int c = pool.allocate(64);
+
+            pool.release(b);
+            expect(!pool.isActive(b));
+            expect(pool.getNumActive() == 2);
+            expect(pool.getNumActiveForNote(60) == 1);
+            expect(pool.getNextForNote(a) == VoicePool::none);
+            expect(pool.getNextActive(a) == c);
+
+            // Released slot is reused first
+            expect(pool.allocate(67) == b);
+            expect(pool.getNote(b) == 67);
+
+            // Releasing twice is harmless
+            pool.release(a);
+            pool.release(a);
+            expect(pool.getNumActive() == 2);
+            expect(pool.getOldestActive() == c);
+        }
+
+        beginTest("Release while iterating and reset");
+        {
+            VoicePool pool(16);
+            for (int i = 0; i < 16; ++i)
+                pool.allocate(i % 2 == 0 ? 60 : 61);
+
+            int visited = 0;
+            for (int v = pool.getOldestActive(); v != VoicePool::none;)
+            {
+                const int next = pool.getNextActive(v);
+                if (pool.getNote(v) == 60)
+                    pool.release(v);
+                ++visited;
+                v = next;
+            }
+
+            expect(visited == 16);
+            expect(pool.getNumActive() == 8);
+            expect(pool.getNumActiveForNote(60) == 0);
+            expect(pool.getOldestForNote(60) == VoicePool::none);
+
+            pool.reset();
+            expect(pool.getNumActive() == 0);
+            expect(pool.getOldestActive() == VoicePool::none);
+            expect(pool.allocate(60) == 0);
+        }
+    }
+};
+
+static VoicePoolTests voicePoolTests;
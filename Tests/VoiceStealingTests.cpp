@@ -0,0 +1,76 @@
+#include <juce_core/juce_core.h>
+#include "../Source/VoiceStealing.h"
+
+//==============================================================================
+// Voice Stealing Policy Tests
+//==============================================================================
+class VoiceStealingPolicyTests : public juce::UnitTest
+{
+public:
+    VoiceStealingPolicyTests() : juce::UnitTest("Voice Stealing Policy") {}
+
+    void runTest() override
+    {
+        beginTest("Oldest voice policy");
+        {
+            OldestVoiceStealingPolicy policy;
+            VoiceStealInfo older = makeVoice(false, false, 1.0f, 1.0f, 10);
+            VoiceStealInfo newer = makeVoice(true, false, 0.1f, 0.0f, 11);
+
+            expect(policy.getStealCost(older) < policy.getStealCost(newer));
+        }
+
+        beginTest("Released before pedal-sustained before held");
+        {
+            CostAwareStealingPolicy policy;
+            VoiceStealInfo released = makeVoice(true, false, 1.0f, 0.8f, 3);
+            VoiceStealInfo pedal = makeVoice(false, true, 1.0f, 0.8f, 2);
+            VoiceStealInfo held = makeVoice(false, false, 0.8f, 0.8f, 1);
+
+            expect(policy.getStealCost(released) < policy.getStealCost(pedal));
+            expect(policy.getStealCost(pedal) < policy.getStealCost(held));
+        }
+
+        beginTest("Quieter voices are cheaper");
+        {
+            CostAwareStealingPolicy policy;
+
+            // Released tails by current envelope level
+            expect(policy.getStealCost(makeVoice(true, false, 1.0f, 0.1f, 1))
+                   < policy.getStealCost(makeVoice(true, false, 0.2f, 0.5f, 2)));
+
+            // Held keys by velocity (their envelope may still be in the attack)
+            expect(policy.getStealCost(makeVoice(false, false, 0.3f, 0.9f, 1))
+                   < policy.getStealCost(makeVoice(false, false, 0.9f, 0.0f, 2)));
+        }
+
+        beginTest("Streaming voices are slightly cheaper");
+        {
+            CostAwareStealingPolicy policy;
+            VoiceStealInfo fromRam = makeVoice(true, false, 1.0f, 0.5f, 1);
+            VoiceStealInfo fromDisk = fromRam;
+            fromDisk.isStreamingFromDisk = true;
+
+            expect(policy.getStealCost(fromDisk) < policy.getStealCost(fromRam));
+
+            CostAwareStealingPolicy::Weights weights;
+            weights.streamingFactor = 1.0;
+            CostAwareStealingPolicy neutral(weights);
+            expect(neutral.getStealCost(fromDisk) == neutral.getStealCost(fromRam));
+        }
+    }
+
+private:
+    static VoiceStealInfo makeVoice(bool releasing, bool pedal, float velocity, float level, uint64_t startCounter)
+    {
+        VoiceStealInfo info;
+        info.isReleasing = releasing;
+        info.isSustainedByPedal = pedal;
+        info.velocity = velocity;
+        info.currentLevel = level;
+        info.startCounter = startCounter;
+        return info;
+    }
+};
+
+static VoiceStealingPolicyTests voiceStealingPolicyTests;
@@ -0,0 +1,69 @@
+#include <juce_core/juce_core.h>
+#include "../Source/WorkingSet.h"
+
+//==============================================================================
+// Working Set Tests
+//==============================================================================
+class WorkingSetTests : public juce::UnitTest
+{
+public:
+    WorkingSetTests() : juce::UnitTest("Working Set") {}
+
+    void runTest() override
+    {
+        beginTest("Round trip through the state string");
+        {
+            WorkingSet workingSet;
+            workingSet.entries.push_back({ 60, 100, 1, 3, 0 });
+            workingSet.entries.push_back({ 21, 127, 4, 12, 1500000 });
+            workingSet.entries.push_back({ 108, 1, 2, 3, 90000 });
+
+            auto restored = WorkingSet::fromString(workingSet.toString());
+            expect(restored.entries.size() == 3);
+
+            if (restored.entries.size() == 3)
+            {
+                // Saved most-played first, ties by how far they played
+                expect(restored.entries[0].midiNote == 21 && restored.entries[0].roundRobin == 4);
+                expect(restored.entries[0].plays == 12 && restored.entries[0].framesPlayed == 1500000);
+                expect(restored.entries[1].midiNote == 108 && restored.entries[1].velocity == 1);
+                expect(restored.entries[2].midiNote == 60 && restored.entries[2].framesPlayed == 0);
+            }
+        }
+
+        beginTest("Empty, malformed and newer states restore nothing");
+        {
+            expect(WorkingSet().toString().isEmpty());
+            expect(WorkingSet::fromString({}).entries.empty());
+            expect(WorkingSet::fromString("not base64 at all!").entries.empty());
+
+            // Valid encoding, wrong version byte
+            juce::MemoryOutputStream out;
+            out.writeByte(static_cast<char>(WorkingSet::formatVersion + 1));
+            out.writeInt(0);
+            expect(WorkingSet::fromString(out.getMemoryBlock().toBase64Encoding()).entries.empty());
+
+            // Count disagrees with the data
+            juce::MemoryOutputStream truncated;
+            truncated.writeByte(static_cast<char>(WorkingSet::formatVersion));
+            truncated.writeInt(2);
+            truncated.writeRepeatedByte(0, 12);
+            expect(WorkingSet::fromString(truncated.getMemoryBlock().toBase64Encoding()).entries.empty());
+        }
+
+        beginTest("Large sets keep the most-played entries");
+        {
+            WorkingSet workingSet;
+            for (size_t i = 0; i < WorkingSet::maxEntries + 100; ++i)
+                workingSet.entries.push_back({ static_cast<int>(i % 128), 64, static_cast<int>(i / 128) + 1,
+                                               static_cast<uint32_t>(i + 1), 0 });
+
+            auto restored = WorkingSet::fromString(workingSet.toString());
+            expect(restored.entries.size() == WorkingSet::maxEntries);
+            expect(restored.entries.front().plays == WorkingSet::maxEntries + 100);
+            expect(restored.entries.back().plays == 101);
+        }
+    }
+};
+
+static WorkingSetTests workingSetTests;